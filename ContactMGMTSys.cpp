@@ -1,21 +1,83 @@
 #include <iostream>
 #include <string>
+#include <string_view> // Interned-string lookups without a copy
 #include <iomanip>
 #include "sqlite3.h"
 #include <limits> // Required for numeric_limits
 #include <list> // Include list for list usage
 #include <cstddef> // Include cstddef for NULL
 #include <cstdlib> // Required for exit()
+#include <unordered_map> // Hotel id index
+#include <vector>
+#include <chrono> // Benchmark timing
+#include <new> // Placement new for the slab pools
+#include <unordered_set>
+#include <map> // Ordered room-count indexes
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <iterator>
+#include <cstdio> // rename/remove for snapshot files
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <memory>
+#include <memory_resource> // Pooled nodes for the id and room indexes
+#include <shared_mutex> // Reader/writer lock for server mode
+#include <condition_variable>
+#include <functional> // Per-shard tasks for the worker pool
+#include <csignal>
+#include <random> // Load generator request mix
+#include <cmath>
+#if defined(CMS_BENCHMARKS) && defined(__GLIBC__)
+#include <malloc.h> // Live-heap figures for the memory benchmark
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <cerrno>
+#endif
 
 using namespace std;
 
-// Hotel structure
+// Hotel structure. Coordinates are optional: NaN until a position is known,
+// and hotels without one are simply left out of the spatial index.
 struct Hotel {
     int id;
     string name;
     string services;
     string location;
     int roomNumber;
+    double latitude = NAN;  // Degrees north
+    double longitude = NAN; // Degrees east
+
+    bool hasCoordinates() const { return !std::isnan(latitude) && !std::isnan(longitude); }
+};
+
+// One stop on the tour, positioned the same way as a hotel
+struct ItineraryStop {
+    string description;
+    double latitude;
+    double longitude;
+
+    ItineraryStop(const string& description, double latitude = NAN, double longitude = NAN)
+        : description(description), latitude(latitude), longitude(longitude) {}
+
+    bool hasCoordinates() const { return !std::isnan(latitude) && !std::isnan(longitude); }
 };
 
 // Guest structure
@@ -25,672 +87,11037 @@ struct Guest {
     int queuePosition;
 };
 
-// Node for Hotel Linked List
-struct HotelNode {
-    Hotel data;
-    HotelNode* next;
+// Rooms held at one hotel for the nights checkIn .. checkOut - 1. Dates are
+// day numbers (see parseDate), so the night count is a subtraction.
+struct Booking {
+    int id;
+    int hotelId;
+    int checkIn;
+    int checkOut; // Day of departure, which is not itself a booked night
+    int rooms;
+    string guestName;
 
-    HotelNode(Hotel hotel) : data(hotel), next(NULL) {}
+    int nights() const { return checkOut - checkIn; }
 };
 
-// Linked List for Hotels
-class HotelLinkedList {
+// Render one hotel or guest the way every listing shows it
+static void formatHotel(ostream& out, int id, const string& name, const string& services,
+                        const string& location, int roomNumber) {
+    out << "ID: " << id << "\nName: " << name << "\nServices: " << services << "\nLocation: " << location
+        << "\nRoom Number: " << roomNumber << "\n\n";
+}
+
+static void formatGuest(ostream& out, int id, const string& name, int ticket, int position) {
+    out << "ID: " << id << ", Name: " << name << ", Position: " << position << " (Ticket #" << ticket << ")\n";
+}
+
+// Both coordinates unknown, or both within range
+static bool validCoordinates(double latitude, double longitude) {
+    if (std::isnan(latitude) && std::isnan(longitude)) return true;
+    return latitude >= -90 && latitude <= 90 && longitude >= -180 && longitude <= 180;
+}
+
+// Parse "latitude,longitude"; blank text means no coordinates
+static bool parseCoordinates(const string& text, double& latitude, double& longitude) {
+    latitude = longitude = NAN;
+    if (text.find_first_not_of(" \t") == string::npos) return true;
+    char* end;
+    double lat = strtod(text.c_str(), &end);
+    while (*end == ' ') end++;
+    if (end == text.c_str() || *end != ',') return false;
+    const char* rest = end + 1;
+    double lon = strtod(rest, &end);
+    while (*end == ' ') end++;
+    if (end == rest || *end != '\0' || !validCoordinates(lat, lon) || std::isnan(lat) || std::isnan(lon)) return false;
+    latitude = lat;
+    longitude = lon;
+    return true;
+}
+
+// Booking dates are day numbers counted from 1970-01-01, converted with
+// Howard Hinnant's civil-calendar arithmetic so no time zone is involved
+const int FIRST_BOOKING_YEAR = 2000;
+const int LAST_BOOKING_YEAR = 2099;
+const int MAX_STAY_NIGHTS = 90;
+
+static int dayFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// Parse YYYY-MM-DD into a day number; the year must be within the booking years
+static bool parseDate(const string& text, int& dayNumber) {
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-') return false;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (i != 4 && i != 7 && !isdigit((unsigned char)text[i])) return false;
+    }
+    int year = atoi(text.c_str()), month = atoi(text.c_str() + 5), day = atoi(text.c_str() + 8);
+    static const int monthDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (year < FIRST_BOOKING_YEAR || year > LAST_BOOKING_YEAR || month < 1 || month > 12) return false;
+    bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    if (day < 1 || day > monthDays[month - 1] + (month == 2 && leap)) return false;
+    dayNumber = dayFromCivil(year, month, day);
+    return true;
+}
+
+static string formatDate(int dayNumber) {
+    int shifted = dayNumber + 719468;
+    int era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+    int dayOfEra = shifted - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int monthIndex = (5 * dayOfYear + 2) / 153;
+    int day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    int month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    char text[40];
+    snprintf(text, sizeof(text), "%04d-%02d-%02d", yearOfEra + era * 400 + (month <= 2), month, day);
+    return text;
+}
+
+// Slab allocator for fixed-size records.
+// Objects are carved out of contiguous chunks, freed slots go on a free list
+// for reuse, and release() hands every chunk back in one pass instead of one
+// free() per record. release() does not run destructors: destroy live objects
+// first unless T is trivially destructible.
+template <typename T>
+class SlabPool {
 public:
-    HotelNode* head;
-    HotelLinkedList() : head(NULL) {}
+    explicit SlabPool(size_t chunkSize = 4096)
+        : chunkSize(chunkSize), used(chunkSize), freeList(NULL), live(0), chunkAllocations(0) {}
+    ~SlabPool() { release(); }
 
-    void addHotel(Hotel hotel) {
-        HotelNode* newNode = new HotelNode(hotel);
-        if (!head) {
-            head = newNode;
+    template <typename... Args>
+    T* create(Args&&... args) {
+        Slot* slot = freeList;
+        if (slot) {
+            freeList = slot->nextFree;
         } else {
-            HotelNode* current = head;
-            while (current->next) {
-                current = current->next;
+            if (used == chunkSize) {
+                chunks.push_back(static_cast<Slot*>(::operator new(sizeof(Slot) * chunkSize)));
+                chunkAllocations++;
+                used = 0;
             }
-            current->next = newNode;
+            slot = &chunks.back()[used++];
         }
+        live++;
+        return new (slot->storage) T(std::forward<Args>(args)...);
     }
 
-    bool removeHotel(int id) {
-        if (!head) return false;
-        if (head->data.id == id) {
-            HotelNode* temp = head;
-            head = head->next;
-            delete temp;
-            return true;
+    void destroy(T* object) {
+        object->~T();
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->nextFree = freeList;
+        freeList = slot;
+        live--;
+    }
+
+    void release() {
+        for (size_t i = 0; i < chunks.size(); i++) {
+            ::operator delete(chunks[i]);
         }
-        HotelNode* current = head;
-        while (current->next && current->next->data.id != id) {
-            current = current->next;
+        chunks.clear();
+        used = chunkSize;
+        freeList = NULL;
+        live = 0;
+    }
+
+    size_t liveCount() const { return live; }
+    size_t capacity() const { return chunks.size() * chunkSize; }
+    size_t chunkAllocationCount() const { return chunkAllocations; }
+
+private:
+    union Slot {
+        Slot* nextFree;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    vector<Slot*> chunks;
+    size_t chunkSize;
+    size_t used; // Slots handed out from the newest chunk
+    Slot* freeList;
+    size_t live;
+    size_t chunkAllocations;
+
+    SlabPool(const SlabPool&);
+    SlabPool& operator=(const SlabPool&);
+};
+
+// Append-only array whose elements never move. Chunk k holds FIRST << k
+// elements, so 32 chunk pointers cover any 32-bit index and nothing is ever
+// copied on growth. Other threads may read an element while one writer
+// appends, provided they learned its index through a release/acquire
+// publication made after it was appended.
+template <typename T>
+class SegmentedArray {
+public:
+    SegmentedArray() : count(0) {
+        for (int k = 0; k < CHUNKS; k++) chunks[k] = NULL;
+    }
+    ~SegmentedArray() { clear(); }
+
+    T& push_back(const T& value) {
+        size_t offset;
+        int k = chunkOf(count, offset);
+        if (!chunks[k]) chunks[k] = static_cast<T*>(::operator new(sizeof(T) * (FIRST << k)));
+        T* element = new (&chunks[k][offset]) T(value);
+        count++;
+        return *element;
+    }
+
+    T& operator[](size_t index) {
+        size_t offset;
+        int k = chunkOf(index, offset);
+        return chunks[k][offset];
+    }
+
+    const T& operator[](size_t index) const {
+        size_t offset;
+        int k = chunkOf(index, offset);
+        return chunks[k][offset];
+    }
+
+    size_t size() const { return count; }
+
+    void clear() {
+        for (size_t i = 0; i < count; i++) (*this)[i].~T();
+        for (int k = 0; k < CHUNKS; k++) {
+            ::operator delete(chunks[k]);
+            chunks[k] = NULL;
         }
-        if (!current->next) return false;
-        HotelNode* temp = current->next;
-        current->next = current->next->next;
-        delete temp;
-        return true;
+        count = 0;
     }
 
-    HotelNode* findHotel(int id) {
-        HotelNode* current = head;
-        while (current) {
-            if (current->data.id == id) {
-                return current;
+private:
+    static const int CHUNKS = 32;
+    static const size_t FIRST = 16;
+
+    T* chunks[CHUNKS];
+    size_t count;
+
+    // Chunk k starts at FIRST * (2^k - 1)
+    static int chunkOf(size_t index, size_t& offset) {
+        size_t position = index / FIRST + 1;
+#if defined(__GNUC__)
+        int k = 63 - __builtin_clzll((unsigned long long)position);
+#else
+        int k = 0;
+        while (position >> (k + 1)) k++;
+#endif
+        offset = index - FIRST * ((size_t(1) << k) - 1);
+        return k;
+    }
+
+    SegmentedArray(const SegmentedArray&);
+    SegmentedArray& operator=(const SegmentedArray&);
+};
+
+// Compressed bitmap over 32-bit slot numbers (roaring layout).
+// Values are grouped by their high 16 bits; each group is either a sorted
+// array of low halves (sparse) or a 1024-word bitset (dense, more than
+// ARRAY_LIMIT values). Bitset-against-bitset operations are plain word loops
+// the compiler vectorizes.
+class CompressedBitmap {
+public:
+    CompressedBitmap() {}
+
+    void add(uint32_t value) {
+        Container& c = containerFor(uint16_t(value >> 16), true);
+        uint16_t low = uint16_t(value);
+        if (c.isBitset()) {
+            uint64_t bit = uint64_t(1) << (low & 63);
+            if (!(c.words[low >> 6] & bit)) {
+                c.words[low >> 6] |= bit;
+                c.cardinality++;
             }
-            current = current->next;
+            return;
         }
-        return NULL;
+        vector<uint16_t>::iterator it = lower_bound(c.values.begin(), c.values.end(), low);
+        if (it != c.values.end() && *it == low) return;
+        c.values.insert(it, low);
+        c.cardinality++;
+        if (c.cardinality > ARRAY_LIMIT) c.toBitset();
     }
 
-    void displayHotels() {
-        cout << "\n--- Hotel List ---\n";
-        HotelNode* current = head;
-        while (current) {
-            cout << "ID: " << current->data.id << "\nName: " << current->data.name
-                 << "\nServices: " << current->data.services << "\nLocation: " << current->data.location
-                 << "\nRoom Number: " << current->data.roomNumber << "\n\n";
-            current = current->next;
+    void remove(uint32_t value) {
+        size_t at = findContainer(uint16_t(value >> 16));
+        if (at == containers.size()) return;
+        Container& c = containers[at];
+        uint16_t low = uint16_t(value);
+        if (c.isBitset()) {
+            uint64_t bit = uint64_t(1) << (low & 63);
+            if (c.words[low >> 6] & bit) {
+                c.words[low >> 6] &= ~bit;
+                c.cardinality--;
+                if (c.cardinality <= ARRAY_LIMIT / 2) c.toArray();
+            }
+        } else {
+            vector<uint16_t>::iterator it = lower_bound(c.values.begin(), c.values.end(), low);
+            if (it == c.values.end() || *it != low) return;
+            c.values.erase(it);
+            c.cardinality--;
         }
+        if (c.cardinality == 0) containers.erase(containers.begin() + at);
     }
 
-    bool isHotelIdUnique(int id) {
-        HotelNode* current = head;
-        while (current) {
-            if (current->data.id == id) {
-                return false; // ID already exists
+    bool contains(uint32_t value) const {
+        size_t at = findContainer(uint16_t(value >> 16));
+        if (at == containers.size()) return false;
+        return containers[at].contains(uint16_t(value));
+    }
+
+    size_t cardinality() const {
+        size_t total = 0;
+        for (size_t i = 0; i < containers.size(); i++) total += containers[i].cardinality;
+        return total;
+    }
+
+    bool empty() const { return containers.empty(); }
+    void clear() { containers.clear(); }
+
+    void toVector(vector<uint32_t>& out) const {
+        out.clear();
+        out.reserve(cardinality());
+        for (size_t i = 0; i < containers.size(); i++) {
+            const Container& c = containers[i];
+            uint32_t high = uint32_t(c.key) << 16;
+            if (c.isBitset()) {
+                for (int w = 0; w < WORDS; w++) {
+                    uint64_t word = c.words[w];
+                    while (word) {
+                        out.push_back(high | uint32_t(w * 64 + __builtin_ctzll(word)));
+                        word &= word - 1;
+                    }
+                }
+            } else {
+                for (size_t v = 0; v < c.values.size(); v++) out.push_back(high | c.values[v]);
             }
-            current = current->next;
         }
-        return true; // ID is unique
     }
 
-    list<Hotel> toList() {
-        list<Hotel> hotelList;
-        HotelNode* current = head;
-        while (current) {
-            hotelList.push_back(current->data);
-            current = current->next;
+    // Heap bytes held by the containers
+    size_t memoryBytes() const {
+        size_t bytes = containers.capacity() * sizeof(Container);
+        for (size_t i = 0; i < containers.size(); i++) {
+            bytes += containers[i].values.capacity() * sizeof(uint16_t) + containers[i].words.capacity() * sizeof(uint64_t);
         }
-        return hotelList;
+        return bytes;
     }
 
-    int size() {
-        int count = 0;
-        HotelNode* current = head;
-        while (current) {
-            count++;
-            current = current->next;
-        }
-        return count;
+    static CompressedBitmap intersect(const CompressedBitmap& a, const CompressedBitmap& b) {
+        return combine(a, b, OP_AND);
+    }
+    static CompressedBitmap unite(const CompressedBitmap& a, const CompressedBitmap& b) {
+        return combine(a, b, OP_OR);
+    }
+    static CompressedBitmap subtract(const CompressedBitmap& a, const CompressedBitmap& b) {
+        return combine(a, b, OP_ANDNOT);
     }
 
+private:
+    enum { ARRAY_LIMIT = 4096, WORDS = 1024 };
+    enum Op { OP_AND, OP_OR, OP_ANDNOT };
 
-    void clearList() {
-        HotelNode* current = head;
-        while (current) {
-            HotelNode* next = current->next;
-            delete current;
-            current = next;
+    struct Container {
+        uint16_t key;
+        uint32_t cardinality;
+        vector<uint16_t> values; // Sparse form
+        vector<uint64_t> words;  // Dense form, WORDS entries when in use
+
+        bool isBitset() const { return !words.empty(); }
+
+        bool contains(uint16_t low) const {
+            if (isBitset()) return (words[low >> 6] >> (low & 63)) & 1;
+            return binary_search(values.begin(), values.end(), low);
         }
-        head = NULL;
-    }
-};
 
-// Node for Guest Linked List
-struct GuestNode {
-    Guest data;
-    GuestNode* next;
+        void toBitset() {
+            words.assign(WORDS, 0);
+            for (size_t i = 0; i < values.size(); i++) words[values[i] >> 6] |= uint64_t(1) << (values[i] & 63);
+            vector<uint16_t>().swap(values);
+        }
 
-    GuestNode(Guest guest) : data(guest), next(NULL) {}
-};
+        void toArray() {
+            values.clear();
+            values.reserve(cardinality);
+            for (int w = 0; w < WORDS; w++) {
+                uint64_t word = words[w];
+                while (word) {
+                    values.push_back(uint16_t(w * 64 + __builtin_ctzll(word)));
+                    word &= word - 1;
+                }
+            }
+            vector<uint64_t>().swap(words);
+        }
 
-// Linked List for Guests (acting as Queue)
-class GuestLinkedList {
-public:
-    GuestNode* head;
-    GuestNode* tail; // To efficiently add to the end (enqueue)
-    GuestLinkedList() : head(NULL), tail(NULL) {}
+        // Settle on the cheaper form after a bulk operation
+        void normalize() {
+            if (isBitset()) {
+                uint32_t count = 0;
+                for (int w = 0; w < WORDS; w++) count += __builtin_popcountll(words[w]);
+                cardinality = count;
+                if (cardinality <= ARRAY_LIMIT) toArray();
+            } else {
+                cardinality = uint32_t(values.size());
+                if (cardinality > ARRAY_LIMIT) toBitset();
+            }
+        }
+    };
 
-    void addGuest(Guest guest) { // Enqueue
-        GuestNode* newNode = new GuestNode(guest);
-        if (!head) {
-            head = newNode;
-            tail = newNode;
-        } else {
-            tail->next = newNode;
-            tail = newNode;
+    vector<Container> containers; // Sorted by key
+
+    size_t findContainer(uint16_t key) const {
+        size_t lo = 0, hi = containers.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (containers[mid].key < key) lo = mid + 1;
+            else hi = mid;
         }
+        return lo < containers.size() && containers[lo].key == key ? lo : containers.size();
     }
 
-    Guest serveGuest() { // Dequeue
-        if (!head) {
-            return Guest(); // Return default Guest if queue is empty
+    Container& containerFor(uint16_t key, bool create) {
+        size_t lo = 0, hi = containers.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (containers[mid].key < key) lo = mid + 1;
+            else hi = mid;
         }
-        GuestNode* temp = head;
-        Guest guest = head->data;
-        head = head->next;
-        if (!head) {
-            tail = NULL; // Queue becomes empty, update tail
+        if (create && (lo == containers.size() || containers[lo].key != key)) {
+            Container c;
+            c.key = key;
+            c.cardinality = 0;
+            containers.insert(containers.begin() + lo, c);
         }
-        delete temp;
-        return guest;
+        return containers[lo];
     }
 
-    void displayGuests() {
-        cout << "\n--- Guest Queue ---\n";
-        GuestNode* current = head;
-        while (current) {
-            cout << "ID: " << current->data.id << ", Name: " << current->data.name
-                 << ", Position: " << current->data.queuePosition << "\n";
-            current = current->next;
+    static void toWords(const Container& c, vector<uint64_t>& words) {
+        if (c.isBitset()) {
+            words = c.words;
+        } else {
+            words.assign(WORDS, 0);
+            for (size_t i = 0; i < c.values.size(); i++) words[c.values[i] >> 6] |= uint64_t(1) << (c.values[i] & 63);
         }
     }
 
-    bool isGuestIdUnique(int id) {
-        GuestNode* current = head;
-        while (current) {
-            if (current->data.id == id) {
-                return false; // ID already exists
+    static Container combineContainers(const Container& a, const Container& b, Op op) {
+        Container out;
+        out.key = a.key;
+        out.cardinality = 0;
+        if (!a.isBitset() && !b.isBitset()) {
+            if (op == OP_AND) {
+                set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(out.values));
+            } else if (op == OP_OR) {
+                set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(out.values));
+            } else {
+                set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(out.values));
+            }
+        } else if (op == OP_AND && !a.isBitset()) {
+            for (size_t i = 0; i < a.values.size(); i++) {
+                if (b.contains(a.values[i])) out.values.push_back(a.values[i]);
+            }
+        } else if (op == OP_AND && !b.isBitset()) {
+            for (size_t i = 0; i < b.values.size(); i++) {
+                if (a.contains(b.values[i])) out.values.push_back(b.values[i]);
+            }
+        } else if (op == OP_ANDNOT && !a.isBitset()) {
+            for (size_t i = 0; i < a.values.size(); i++) {
+                if (!b.contains(a.values[i])) out.values.push_back(a.values[i]);
+            }
+        } else {
+            vector<uint64_t> right;
+            toWords(a, out.words);
+            toWords(b, right);
+            uint64_t* __restrict dst = &out.words[0];
+            const uint64_t* __restrict src = &right[0];
+            if (op == OP_AND) {
+                for (int w = 0; w < WORDS; w++) dst[w] &= src[w];
+            } else if (op == OP_OR) {
+                for (int w = 0; w < WORDS; w++) dst[w] |= src[w];
+            } else {
+                for (int w = 0; w < WORDS; w++) dst[w] &= ~src[w];
             }
-            current = current->next;
         }
-        return true; // ID is unique
+        out.normalize();
+        return out;
     }
 
-    list<Guest> toList() {
-        list<Guest> guestList;
-        GuestNode* current = head;
-        while (current) {
-            guestList.push_back(current->data);
-            current = current->next;
+    static CompressedBitmap combine(const CompressedBitmap& a, const CompressedBitmap& b, Op op) {
+        CompressedBitmap result;
+        size_t i = 0, j = 0;
+        while (i < a.containers.size() || j < b.containers.size()) {
+            bool haveA = i < a.containers.size();
+            bool haveB = j < b.containers.size();
+            if (haveA && (!haveB || a.containers[i].key < b.containers[j].key)) {
+                if (op != OP_AND) result.containers.push_back(a.containers[i]);
+                i++;
+            } else if (haveB && (!haveA || b.containers[j].key < a.containers[i].key)) {
+                if (op == OP_OR) result.containers.push_back(b.containers[j]);
+                j++;
+            } else {
+                Container c = combineContainers(a.containers[i], b.containers[j], op);
+                if (c.cardinality) result.containers.push_back(c);
+                i++;
+                j++;
+            }
         }
-        return guestList;
+        return result;
     }
+};
 
-     int size() {
-        int count = 0;
-        GuestNode* current = head;
-        while (current) {
-            count++;
-            current = current->next;
+// Inverted index from amenities to hotel slots.
+// Hotel::services is split on commas and each phrase normalized (lower case,
+// punctuation dropped, spaces collapsed), so "Free Wi-Fi" and "free wifi" are
+// the same amenity. Each amenity has a posting bitmap of the slots offering it.
+class AmenityIndex {
+public:
+    static string normalize(const string& phrase) {
+        string key;
+        bool space = false;
+        for (size_t i = 0; i < phrase.size(); i++) {
+            unsigned char c = phrase[i];
+            if (isalnum(c) || c >= 0x80) {
+                if (space && !key.empty()) key += ' ';
+                key += char(tolower(c));
+                space = false;
+            } else if (isspace(c)) {
+                space = true;
+            }
         }
-        return count;
+        return key;
     }
 
-     void clearList() {
-        GuestNode* current = head;
-        while (current) {
-            GuestNode* next = current->next;
-            delete current;
-            current = next;
+    // Split a services string into normalized amenity keys
+    static void tokenize(const string& services, vector<string>& keys) {
+        keys.clear();
+        size_t start = 0;
+        while (start <= services.size()) {
+            size_t comma = services.find(',', start);
+            if (comma == string::npos) comma = services.size();
+            string key = normalize(services.substr(start, comma - start));
+            if (!key.empty() && find(keys.begin(), keys.end(), key) == keys.end()) keys.push_back(key);
+            start = comma + 1;
         }
-        head = NULL;
-        tail = NULL;
     }
-};
 
+    // Amenity ids for a services string, assigning ids to new amenities
+    const vector<int>& parse(string_view services) { return amenityIds(services); }
 
-// Global Data
-HotelLinkedList hotelList;
-GuestLinkedList guestQueue;
-list<string> itinerary;
-sqlite3* db;
-
-// Function prototypes
-void initializeDatabase();
-void closeDatabase();
-void adminMenu();
-void customerMenu();
-bool authenticateAdmin();
-void addHotel();
-void updateHotel();
-void viewHotels();
-void deleteHotel();
-void saveHotelToDatabase(Hotel hotel);
-void loadHotelsFromDatabase();
-void addGuest();
-void serveGuest();
-void displayGuestQueue();
-void saveGuestToDatabase(Guest guest);
-void loadGuestsFromDatabase();
-void addStopToItinerary();
-void viewItinerary();
-bool isHotelIdUnique(int id);
-bool isGuestIdUnique(int id);
+    // Dictionary id for an amenity, or -1 when no hotel has ever listed it
+    int lookup(const string& phrase) const {
+        unordered_map<string, int>::const_iterator it = dictionary.find(normalize(phrase));
+        return it == dictionary.end() ? -1 : it->second;
+    }
 
-// Predefined hotels near Lalibela
-void addPredefinedHotels() {
-    hotelList.clearList(); // Clear existing list first if needed
-    list<Hotel> predefinedHotels; // Initialize as an empty list
+    void add(uint32_t slot, string_view services) {
+        const vector<int>& ids = amenityIds(services);
+        for (size_t i = 0; i < ids.size(); i++) postings[ids[i]].add(slot);
+        allSlots.add(slot);
+    }
 
-    Hotel hotel1 = {1, "Lalibela Lodge", "Free Wi-Fi, Restaurant, Pool", "Lalibela", 20};
-    predefinedHotels.push_back(hotel1);
-    Hotel hotel2 = {2, "Mountain View Hotel", "Spa, Free Breakfast", "Lalibela", 15};
-    predefinedHotels.push_back(hotel2);
-    Hotel hotel3 = {3, "Rock-Hewn Inn", "Bar, Room Service", "Lalibela", 25};
-    predefinedHotels.push_back(hotel3);
-    Hotel hotel4 = {4, "Zion Hotel", "Free Parking, Conference Room", "Lalibela", 30};
-    predefinedHotels.push_back(hotel4);
-    Hotel hotel5 = {5, "St. George Guesthouse", "Free Wi-Fi, Garden", "Lalibela", 10};
-    predefinedHotels.push_back(hotel5);
-    Hotel hotel6 = {6, "Axum Hotel", "Restaurant, Free Parking", "Lalibela", 18};
-    predefinedHotels.push_back(hotel6);
-    Hotel hotel7 = {7, "Queen Sheba Hotel", "Pool, Spa, Gym", "Lalibela", 22};
-    predefinedHotels.push_back(hotel7);
-    Hotel hotel8 = {8, "Ethiopian Heritage Hotel", "Free Breakfast, Bar", "Lalibela", 12};
-    predefinedHotels.push_back(hotel8);
-    Hotel hotel9 = {9, "Bete Maryam Hotel", "Free Wi-Fi, Restaurant", "Lalibela", 14};
-    predefinedHotels.push_back(hotel9);
-    Hotel hotel10 = {10, "Tekle Haymanot Lodge", "Garden, Room Service", "Lalibela", 16};
-    predefinedHotels.push_back(hotel10);
+    void remove(uint32_t slot, string_view services) {
+        const vector<int>& ids = amenityIds(services);
+        for (size_t i = 0; i < ids.size(); i++) postings[ids[i]].remove(slot);
+        allSlots.remove(slot);
+    }
 
+    void update(uint32_t slot, string_view oldServices, string_view newServices) {
+        if (oldServices == newServices) return;
+        remove(slot, oldServices);
+        add(slot, newServices);
+    }
 
-    for (list<Hotel>::iterator hotel_iter = predefinedHotels.begin(); hotel_iter != predefinedHotels.end(); ++hotel_iter) {
-        hotelList.addHotel(*hotel_iter);
+    void clear() {
+        parsedServices.clear();
+        dictionary.clear();
+        names.clear();
+        postings.clear();
+        allSlots.clear();
     }
-}
 
-// Predefined itineraries
-void addPredefinedItinerary() {
-    itinerary.clear(); // Clear existing itinerary if needed
-    itinerary.push_back("1. Visit the Rock-Hewn Churches of Lalibela");
-    itinerary.push_back("2. Explore Asheton Maryam Monastery");
-    itinerary.push_back("3. Hike to the top of Mount Abuna Yosef");
-    itinerary.push_back("4. Visit the Lalibela Market");
-    itinerary.push_back("5. Attend a traditional coffee ceremony");
-}
+    size_t amenityCount() const { return names.size(); }
+    const string& amenityName(int id) const { return names[id]; }
+    const CompressedBitmap& posting(int id) const { return postings[id]; }
 
-int main() {
-    initializeDatabase();
-    loadHotelsFromDatabase();
-    loadGuestsFromDatabase();
-    addPredefinedHotels(); // Call addPredefinedHotels to populate hotel list
+    // Evaluate a boolean amenity query such as "Pool AND Spa AND NOT Bar".
+    // AND binds tighter than OR; NOT and parentheses are supported.
+    bool query(const string& expression, CompressedBitmap& result, string& error) const {
+        vector<string> tokens;
+        tokenizeQuery(expression, tokens);
+        size_t pos = 0;
+        error.clear();
+        result = parseOr(tokens, pos, error);
+        if (error.empty() && pos != tokens.size()) error = "unexpected '" + tokens[pos] + "'";
+        return error.empty();
+    }
 
-    int userType;
-    do {
-        cout << "\nLalibela Tourism Management\n";
-        cout << "1. Admin\n2. Customer\n3. Exit\nChoice: ";
-        cin >> userType;
-        cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+private:
+    unordered_map<string, int> dictionary; // Normalized key -> amenity id
+    vector<string> names;                  // Display name, as first written
+    vector<CompressedBitmap> postings;     // Amenity id -> hotel slots
+    CompressedBitmap allSlots;             // Every indexed slot, for NOT
 
-        switch(userType) {
-            case 1:
-                if(authenticateAdmin()) adminMenu();
-                else cout << "Access denied!\n";
-                break;
-            case 2: customerMenu(); break;
-            case 3: cout << "Exiting...\n"; break;
-            default: cout << "Invalid choice!\n";
-        }
-    } while(userType != 3);
+    // Catalogues repeat the same few services strings, so their parsed form
+    // is remembered instead of tokenizing every hotel again
+    unordered_map<string, vector<int> > parsedServices;
+    enum { PARSED_SERVICES_LIMIT = 65536 };
+    string lookupKey; // Reused for cache lookups, so a hit allocates nothing
 
-    closeDatabase();
-    return 0;
-}
+    const vector<int>& amenityIds(string_view services) {
+        lookupKey.assign(services.data(), services.size());
+        unordered_map<string, vector<int> >::iterator it = parsedServices.find(lookupKey);
+        if (it != parsedServices.end()) return it->second;
+        if (parsedServices.size() >= PARSED_SERVICES_LIMIT) parsedServices.clear();
+        vector<string> keys;
+        tokenize(lookupKey, keys);
+        vector<int>& ids = parsedServices[lookupKey];
+        for (size_t i = 0; i < keys.size(); i++) ids.push_back(intern(keys[i], lookupKey));
+        return ids;
+    }
 
-// Initialize SQLite Database
-void initializeDatabase() {
-    if (sqlite3_open("tourism.db", &db)) {
-        cerr << "Error opening SQLite database: " << sqlite3_errmsg(db) << endl;
-        exit(1);
+    int intern(const string& key, const string& services) {
+        unordered_map<string, int>::iterator it = dictionary.find(key);
+        if (it != dictionary.end()) return it->second;
+        int id = int(names.size());
+        dictionary[key] = id;
+        names.push_back(displayName(key, services));
+        postings.push_back(CompressedBitmap());
+        return id;
     }
 
-    char* createHotelsTable = (char*)
-        "CREATE TABLE IF NOT EXISTS Hotels ("
-        "id INTEGER PRIMARY KEY, "
-        "name TEXT, "
-        "services TEXT, "
-        "location TEXT, "
-        "roomNumber INTEGER);";
+    // Recover the original spelling of a key from the services string
+    static string displayName(const string& key, const string& services) {
+        size_t start = 0;
+        while (start <= services.size()) {
+            size_t comma = services.find(',', start);
+            if (comma == string::npos) comma = services.size();
+            string phrase = services.substr(start, comma - start);
+            if (normalize(phrase) == key) {
+                size_t first = phrase.find_first_not_of(" \t");
+                size_t last = phrase.find_last_not_of(" \t");
+                return phrase.substr(first, last - first + 1);
+            }
+            start = comma + 1;
+        }
+        return key;
+    }
 
-    char* createGuestsTable = (char*)
-        "CREATE TABLE IF NOT EXISTS Guests ("
-        "id INTEGER PRIMARY KEY, "
-        "name TEXT, "
-        "queuePosition INTEGER);";
+    static bool isKeyword(const string& word, const char* keyword) {
+        if (word.size() != strlen(keyword)) return false;
+        for (size_t i = 0; i < word.size(); i++) {
+            if (toupper((unsigned char)word[i]) != keyword[i]) return false;
+        }
+        return true;
+    }
 
-    char* errMsg;
-    if (sqlite3_exec(db, createHotelsTable, NULL, NULL, &errMsg) != SQLITE_OK) {
-        cerr << "Error creating Hotels table: " << errMsg << endl;
-        sqlite3_free(errMsg);
-        exit(1);
+    // Tokens are "(", ")", the keywords AND/OR/NOT, and amenity phrases
+    // made of the words between them
+    static void tokenizeQuery(const string& expression, vector<string>& tokens) {
+        string phrase;
+        string word;
+        for (size_t i = 0; i <= expression.size(); i++) {
+            char c = i < expression.size() ? expression[i] : ' ';
+            if (c == '(' || c == ')' || isspace((unsigned char)c)) {
+                if (!word.empty()) {
+                    if (isKeyword(word, "AND") || isKeyword(word, "OR") || isKeyword(word, "NOT")) {
+                        if (!phrase.empty()) tokens.push_back(phrase);
+                        phrase.clear();
+                        string keyword;
+                        for (size_t k = 0; k < word.size(); k++) keyword += char(toupper((unsigned char)word[k]));
+                        tokens.push_back(keyword);
+                    } else {
+                        if (!phrase.empty()) phrase += ' ';
+                        phrase += word;
+                    }
+                    word.clear();
+                }
+                if (c == '(' || c == ')') {
+                    if (!phrase.empty()) tokens.push_back(phrase);
+                    phrase.clear();
+                    tokens.push_back(string(1, c));
+                }
+            } else {
+                word += c;
+            }
+        }
+        if (!phrase.empty()) tokens.push_back(phrase);
     }
 
-    if (sqlite3_exec(db, createGuestsTable, NULL, NULL, &errMsg) != SQLITE_OK) {
-        cerr << "Error creating Guests table: " << errMsg << endl;
-        sqlite3_free(errMsg);
-        exit(1);
+    CompressedBitmap parseOr(const vector<string>& tokens, size_t& pos, string& error) const {
+        CompressedBitmap result = parseAnd(tokens, pos, error);
+        while (error.empty() && pos < tokens.size() && tokens[pos] == "OR") {
+            pos++;
+            result = CompressedBitmap::unite(result, parseAnd(tokens, pos, error));
+        }
+        return result;
+    }
+
+    CompressedBitmap parseAnd(const vector<string>& tokens, size_t& pos, string& error) const {
+        // Collect the positive and negated terms, then intersect smallest first
+        vector<CompressedBitmap> include, exclude;
+        while (error.empty()) {
+            bool negate = false;
+            while (pos < tokens.size() && tokens[pos] == "NOT") {
+                negate = !negate;
+                pos++;
+            }
+            CompressedBitmap term = parseTerm(tokens, pos, error);
+            if (negate) exclude.push_back(term);
+            else include.push_back(term);
+            if (pos < tokens.size() && tokens[pos] == "AND") pos++;
+            else break;
+        }
+        if (!error.empty()) return CompressedBitmap();
+
+        CompressedBitmap result;
+        if (include.empty()) {
+            result = allSlots;
+        } else {
+            size_t smallest = 0;
+            for (size_t i = 1; i < include.size(); i++) {
+                if (include[i].cardinality() < include[smallest].cardinality()) smallest = i;
+            }
+            result = include[smallest];
+            for (size_t i = 0; i < include.size() && !result.empty(); i++) {
+                if (i != smallest) result = CompressedBitmap::intersect(result, include[i]);
+            }
+        }
+        for (size_t i = 0; i < exclude.size() && !result.empty(); i++) {
+            result = CompressedBitmap::subtract(result, exclude[i]);
+        }
+        return result;
+    }
+
+    CompressedBitmap parseTerm(const vector<string>& tokens, size_t& pos, string& error) const {
+        if (pos >= tokens.size()) {
+            error = "expected an amenity";
+            return CompressedBitmap();
+        }
+        const string& token = tokens[pos++];
+        if (token == "(") {
+            CompressedBitmap inner = parseOr(tokens, pos, error);
+            if (error.empty()) {
+                if (pos < tokens.size() && tokens[pos] == ")") pos++;
+                else error = "missing ')'";
+            }
+            return inner;
+        }
+        if (token == ")" || token == "AND" || token == "OR") {
+            error = "unexpected '" + token + "'";
+            return CompressedBitmap();
+        }
+        int id = lookup(token);
+        return id < 0 ? CompressedBitmap() : postings[id];
+    }
+};
+
+// Trigram index for typo-tolerant name lookup.
+// A name is lower-cased and split into words at anything that is not a
+// letter or digit. Each word, padded as "  word ", contributes its
+// three-character windows, so "Rock-Hewn Inn" and "rock hewn inn" index
+// alike and a misspelling still shares most trigrams with the real name.
+// Similarity is the Jaccard ratio of the two trigram sets, as in pg_trgm.
+// Each trigram has a posting list of documents in increasing order. A
+// document is one indexed name; a removal only marks it dead, and the
+// lists are compacted once the dead outnumber the live.
+class TrigramIndex {
+public:
+    struct Match {
+        int id;
+        double score;
+    };
+
+    // Weaker matches than this are never returned
+    static constexpr double MIN_SIMILARITY = 0.3;
+
+    TrigramIndex() : liveCount(0) {}
+
+    void add(int id, string_view name) {
+        trigramsOf(name, scratch);
+        uint32_t doc = uint32_t(docs.size());
+        docs.push_back(Doc(id, uint32_t(terms.size()), uint32_t(scratch.size())));
+        docOf[id] = doc;
+        terms.insert(terms.end(), scratch.begin(), scratch.end());
+        for (size_t i = 0; i < scratch.size(); i++) postings[scratch[i]].push_back(doc);
+        liveCount++;
+    }
+
+    void remove(int id) {
+        unordered_map<int, uint32_t>::iterator it = docOf.find(id);
+        if (it == docOf.end()) return;
+        docs[it->second].trigramCount = DEAD;
+        docOf.erase(it);
+        liveCount--;
+        if (docs.size() - liveCount > max<size_t>(COMPACT_MIN_DEAD, liveCount)) compact();
+    }
+
+    void update(int id, string_view oldName, string_view newName) {
+        if (oldName == newName) return;
+        remove(id);
+        add(id, newName);
+    }
+
+    void clear() {
+        postings.clear();
+        docs.clear();
+        terms.clear();
+        docOf.clear();
+        liveCount = 0;
+    }
+
+    size_t size() const { return liveCount; }
+
+    // Up to limit ids of the names most like the query, best first (ties by
+    // id), none below MIN_SIMILARITY. Candidates come from the query's
+    // rarest trigrams: posting lists are read shortest first, counting hits
+    // per document, until further lists could add no candidate reaching
+    // MIN_SIMILARITY or SCAN_BUDGET postings have been read (the shortest
+    // list is always read). The remaining, longer lists are left unread,
+    // scoring the candidates that could still make the top `limit` against
+    // their own trigrams, at most SCORE_BUDGET of them, most hits first. Within
+    // the budgets the result is exact; beyond them, a name sharing little
+    // but common trigrams with the query (a first letter, "hotel") may be
+    // passed over, so the cost stays bounded however common they are.
+    void search(string_view query, size_t limit, vector<Match>& matches) const {
+        matches.clear();
+        vector<uint32_t> grams;
+        trigramsOf(query, grams);
+        if (grams.empty() || limit == 0) return;
+        vector<const vector<uint32_t>*> lists;
+        for (size_t i = 0; i < grams.size(); i++) {
+            unordered_map<uint32_t, vector<uint32_t> >::const_iterator it = postings.find(grams[i]);
+            if (it != postings.end()) lists.push_back(&it->second);
+        }
+        double q = double(grams.size());
+        size_t need = needed(MIN_SIMILARITY, q);
+        if (lists.size() < need) return;
+        sort(lists.begin(), lists.end(),
+             [](const vector<uint32_t>* a, const vector<uint32_t>* b) { return a->size() < b->size(); });
+
+        vector<uint16_t>& hits = searchHits();
+        if (hits.size() < docs.size()) hits.resize(docs.size(), 0);
+        vector<uint32_t> touched;
+        size_t scanned = 0, scannedPostings = 0;
+        while (scanned + need <= lists.size() &&
+               (scanned == 0 || scannedPostings + lists[scanned]->size() <= SCAN_BUDGET)) {
+            const vector<uint32_t>& list = *lists[scanned];
+            for (size_t j = 0; j < list.size(); j++) {
+                if (hits[list[j]]++ == 0) touched.push_back(list[j]);
+            }
+            scannedPostings += list.size();
+            scanned++;
+        }
+        rankCandidates(grams, lists.size() - scanned, scanned, touched, limit, matches);
+        for (size_t i = 0; i < touched.size(); i++) hits[touched[i]] = 0;
+        sort_heap(matches.begin(), matches.end(), betterMatch);
+    }
+
+    // The sorted, distinct trigrams of a name
+    static void trigramsOf(string_view name, vector<uint32_t>& grams) {
+        grams.clear();
+        uint32_t window = 0; // The last three characters, one per byte
+        bool inWord = false;
+        for (size_t i = 0; i <= name.size(); i++) {
+            unsigned char c = i < name.size() ? name[i] : ' ';
+            if (isalnum(c) || c >= 0x80) {
+                if (!inWord) window = (uint32_t(' ') << 8) | ' ';
+                inWord = true;
+                window = ((window << 8) | uint32_t(tolower(c))) & 0xFFFFFF;
+                grams.push_back(window);
+            } else if (inWord) {
+                grams.push_back(((window << 8) | ' ') & 0xFFFFFF);
+                inWord = false;
+            }
+        }
+        sort(grams.begin(), grams.end());
+        grams.erase(unique(grams.begin(), grams.end()), grams.end());
+    }
+
+private:
+    static constexpr uint32_t DEAD = ~uint32_t(0);
+    enum { COMPACT_MIN_DEAD = 1024 };
+    // Work limits per search: postings read for candidates, and candidates
+    // scored. Together about half a millisecond over a million names.
+    enum { SCAN_BUDGET = 32768, SCORE_BUDGET = 1024 };
+
+    struct Doc {
+        int id;
+        uint32_t first;        // Its sorted trigrams are terms[first, first + trigramCount)
+        uint32_t trigramCount; // DEAD once removed
+        Doc(int id, uint32_t first, uint32_t trigramCount) : id(id), first(first), trigramCount(trigramCount) {}
+    };
+
+    unordered_map<uint32_t, vector<uint32_t> > postings; // Trigram -> documents, increasing
+    vector<Doc> docs;
+    vector<uint32_t> terms;                              // Every document's trigrams, for scoring candidates
+    unordered_map<int, uint32_t> docOf;                  // id -> its live document
+    size_t liveCount;
+    vector<uint32_t> scratch;                            // Trigrams of the name being added
+
+    // Better score first, then lower id; as a heap comparator the worst kept
+    // match sits at the front
+    static bool betterMatch(const Match& a, const Match& b) {
+        return a.score != b.score ? a.score > b.score : a.id < b.id;
+    }
+
+    // Hits per document in the lists a search has scanned. The counters are
+    // per thread and reset after use, so concurrent readers never share them.
+    static vector<uint16_t>& searchHits() {
+        static thread_local vector<uint16_t> hits;
+        return hits;
+    }
+
+    // Trigrams a name must share with a query of q trigrams to score at least bar
+    static size_t needed(double bar, double q) {
+        return max<size_t>(1, size_t(ceil(bar * q - 1e-9)));
+    }
+
+    // Score up to SCORE_BUDGET touched candidates, most hits first, into a
+    // heap (worst at the front) of the best `limit`. `unread` of the query's
+    // lists were not scanned. Once the heap is full its worst score is the
+    // bar, and a candidate that could not clear it even sharing every unread
+    // trigram is not scored at all.
+    void rankCandidates(const vector<uint32_t>& grams, size_t unread, size_t scanned, const vector<uint32_t>& touched,
+                        size_t limit, vector<Match>& matches) const {
+        const vector<uint16_t>& hits = searchHits();
+        vector<size_t> offsets(scanned + 2, 0);
+        for (size_t i = 0; i < touched.size(); i++) offsets[scanned - hits[touched[i]] + 1]++;
+        for (size_t h = 1; h < offsets.size(); h++) offsets[h] += offsets[h - 1];
+        vector<uint32_t> order(touched.size());
+        for (size_t i = 0; i < touched.size(); i++) order[offsets[scanned - hits[touched[i]]]++] = touched[i];
+
+        double q = double(grams.size());
+        double bar = MIN_SIMILARITY;
+        for (size_t i = 0, scored = 0; i < order.size() && scored < SCORE_BUDGET; i++) {
+            // Candidates are scattered over memory; fetch ahead, the record first and then its trigrams
+            if (i + 8 < order.size()) __builtin_prefetch(&docs[order[i + 8]]);
+            if (i + 4 < order.size()) __builtin_prefetch(&terms[docs[order[i + 4]].first]);
+            uint32_t doc = order[i];
+            size_t found = hits[doc];
+            if ((found + unread) / q < bar) break; // Nor can any later candidate, with fewer hits
+            if (docs[doc].trigramCount == DEAD) continue;
+            double length = docs[doc].trigramCount;
+            double best = min(double(found + unread), length);
+            if (best / (q + length - best) < bar) continue;
+            scored++;
+            const uint32_t* own = &terms[docs[doc].first];
+            size_t common = 0;
+            for (size_t a = 0, b = 0; a < grams.size() && b < docs[doc].trigramCount;) {
+                if (grams[a] < own[b]) a++;
+                else if (own[b] < grams[a]) b++;
+                else common++, a++, b++;
+            }
+            Match match = {docs[doc].id, common / (q + length - common)};
+            if (match.score < bar) continue;
+            if (matches.size() == limit) {
+                if (!betterMatch(match, matches.front())) continue;
+                pop_heap(matches.begin(), matches.end(), betterMatch);
+                matches.pop_back();
+            }
+            matches.push_back(match);
+            push_heap(matches.begin(), matches.end(), betterMatch);
+            if (matches.size() == limit) bar = matches.front().score;
+        }
+    }
+
+    // Drop dead documents and renumber the rest, keeping every list in order
+    void compact() {
+        vector<uint32_t> renumber(docs.size(), DEAD);
+        vector<Doc> live;
+        vector<uint32_t> liveTerms;
+        live.reserve(liveCount);
+        for (size_t i = 0; i < docs.size(); i++) {
+            if (docs[i].trigramCount == DEAD) continue;
+            renumber[i] = uint32_t(live.size());
+            live.push_back(Doc(docs[i].id, uint32_t(liveTerms.size()), docs[i].trigramCount));
+            liveTerms.insert(liveTerms.end(), terms.begin() + docs[i].first,
+                             terms.begin() + docs[i].first + docs[i].trigramCount);
+        }
+        for (unordered_map<uint32_t, vector<uint32_t> >::iterator it = postings.begin(); it != postings.end();) {
+            vector<uint32_t>& list = it->second;
+            size_t kept = 0;
+            for (size_t i = 0; i < list.size(); i++) {
+                if (renumber[list[i]] != DEAD) list[kept++] = renumber[list[i]];
+            }
+            list.resize(kept);
+            if (list.empty()) it = postings.erase(it);
+            else ++it;
+        }
+        for (unordered_map<int, uint32_t>::iterator it = docOf.begin(); it != docOf.end(); ++it) {
+            it->second = renumber[it->second];
+        }
+        docs.swap(live);
+        terms.swap(liveTerms);
+    }
+
+    TrigramIndex(const TrigramIndex&);
+    TrigramIndex& operator=(const TrigramIndex&);
+};
+
+// Interned strings: each distinct value is stored once and referred to by a
+// dense 32-bit id. Values are never removed one by one, which suits the small
+// vocabularies (town names, services lists) a catalogue keeps repeating.
+// Values never move, so snapshot readers may look up ids they were handed
+// while the writer interns new ones.
+class StringTable {
+public:
+    StringTable() {}
+
+    uint32_t intern(string_view value) {
+        unordered_map<string_view, uint32_t>::const_iterator it = ids.find(value);
+        if (it != ids.end()) return it->second;
+        uint32_t id = uint32_t(values.size());
+        ids.emplace(string_view(values.push_back(string(value))), id);
+        return id;
+    }
+
+    const string& operator[](uint32_t id) const { return values[id]; }
+    size_t size() const { return values.size(); }
+
+    void clear() {
+        ids.clear();
+        values.clear();
+    }
+
+private:
+    SegmentedArray<string> values; // Never moves existing strings, so the views stay valid
+    unordered_map<string_view, uint32_t> ids;
+
+    StringTable(const StringTable&);
+    StringTable& operator=(const StringTable&);
+};
+
+// One version of a hotel's fields. Versions are immutable once published:
+// an edit publishes a new version in front of the old one, and a delete
+// publishes a removed marker, so snapshot readers can pick the version that
+// was current at their snapshot. Location and services are encoded against
+// dictionaries kept by HotelLinkedList, so read them through its
+// locationOf() and servicesOf().
+struct HotelDetails {
+    static const uint32_t NO_TEXT = 0xFFFFFFFFu;
+
+    string name;
+    uint32_t location;     // Id in the location table
+    uint32_t servicesText; // Id of the exact services text, or NO_TEXT when the bits render it
+    uint64_t amenities;    // Bit i set: amenity dictionary id i (ids 0-63)
+    double latitude;
+    double longitude;
+    uint64_t version;      // List version that published this one
+    HotelDetails* older;   // The version this one replaced, while a reader may need it
+    int roomNumber;
+    bool removed;          // Marker left by removeHotel()
+
+    HotelDetails(string&& name, uint32_t location, int roomNumber, double latitude, double longitude)
+        : name(std::move(name)), location(location), servicesText(NO_TEXT), amenities(0), latitude(latitude),
+          longitude(longitude), version(0), older(NULL), roomNumber(roomNumber), removed(false) {}
+
+    bool hasCoordinates() const { return !std::isnan(latitude) && !std::isnan(longitude); }
+};
+
+// Node for Hotel Linked List.
+// Hot fields sit together in the node so walks over ids and room counts stay
+// within the node slab; the strings live in a separate details slab.
+// roomNumber and details() are the current values for the writer; snapshot
+// readers go through HotelLinkedList::ReadSnapshot instead.
+struct HotelNode {
+    int id;
+    int roomNumber;
+    uint32_t slot; // Dense number for bitmap indexes, reused after deletes
+    atomic<HotelNode*> next;
+    HotelNode* prev;
+    atomic<HotelDetails*> latest; // Newest version; older ones hang off it
+
+    HotelNode(int id, int roomNumber, HotelDetails* details)
+        : id(id), roomNumber(roomNumber), slot(0), next(NULL), prev(NULL), latest(details) {}
+
+    HotelDetails* details() const { return latest.load(memory_order_acquire); }
+};
+
+// Ordered secondary indexes on room count: one over every hotel, and a
+// composite (location, roomNumber) index kept as one ordered map per
+// location, whose leading column also answers location-only lookups.
+// Locations compare case-insensitively. Keys end in the hotel id, so equal
+// room counts stay distinct and come back in id order. A range or top-k
+// query is a seek plus a walk over exactly the rows it returns.
+// Map nodes come from the memory resource given at construction.
+class RoomIndex {
+public:
+    explicit RoomIndex(pmr::memory_resource* memory = pmr::get_default_resource())
+        : byRooms(memory), byLocation(memory) {}
+
+    static string locationKey(const string& location) {
+        size_t start = location.find_first_not_of(" \t");
+        size_t end = location.find_last_not_of(" \t");
+        string key = start == string::npos ? string() : location.substr(start, end - start + 1);
+        for (size_t i = 0; i < key.size(); i++) key[i] = char(tolower((unsigned char)key[i]));
+        return key;
+    }
+
+    void add(HotelNode* node, const string& location) {
+        RoomKey key(node->roomNumber, node->id);
+        byRooms[key] = node;
+        byLocation[locationKey(location)][key] = node;
+    }
+
+    // Add many hotels at once, each with its location. Every map takes them
+    // in key order, so each insert is hinted by the previous one's position
+    // instead of descending from the root.
+    void addAll(const vector<pair<HotelNode*, const string*> >& hotels) {
+        if (hotels.empty()) return;
+        unordered_map<const string*, string> keys; // One locationKey() per distinct location
+        vector<Entry> entries;
+        entries.reserve(hotels.size());
+        for (size_t i = 0; i < hotels.size(); i++) {
+            unordered_map<const string*, string>::iterator key = keys.find(hotels[i].second);
+            if (key == keys.end()) key = keys.emplace(hotels[i].second, locationKey(*hotels[i].second)).first;
+            Entry entry = {RoomKey(hotels[i].first->roomNumber, hotels[i].first->id), hotels[i].first, &key->second};
+            entries.push_back(entry);
+        }
+        sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+        insertSorted(byRooms, entries.begin(), entries.end());
+        stable_sort(entries.begin(), entries.end(),
+                    [](const Entry& a, const Entry& b) { return *a.location < *b.location; });
+        for (vector<Entry>::iterator first = entries.begin(); first != entries.end();) {
+            vector<Entry>::iterator last = first;
+            while (last != entries.end() && *last->location == *first->location) ++last;
+            insertSorted(byLocation[*first->location], first, last);
+            first = last;
+        }
+    }
+
+    // Call before the node's location or room count changes
+    void remove(HotelNode* node, const string& location) {
+        RoomKey key(node->roomNumber, node->id);
+        byRooms.erase(key);
+        LocationMap::iterator it = byLocation.find(locationKey(location));
+        if (it == byLocation.end()) return;
+        it->second.erase(key);
+        if (it->second.empty()) byLocation.erase(it);
+    }
+
+    // Also gives back the location buckets, so the memory resource can be released
+    void clear() {
+        byRooms.clear();
+        LocationMap(byLocation.get_allocator()).swap(byLocation);
+    }
+
+    // Hotels with minRooms <= roomNumber <= maxRooms, at one location or at
+    // any when location is empty, smallest or largest first, at most limit
+    void query(const string& location, int minRooms, int maxRooms, bool largestFirst, size_t limit,
+               vector<HotelNode*>& out) const {
+        out.clear();
+        if (limit == 0) return;
+        visit(location, minRooms, maxRooms, largestFirst, [&out, limit](HotelNode* node) {
+            out.push_back(node);
+            return out.size() < limit;
+        });
+    }
+
+    // The same walk as query(), handing each hotel to visit(node) until it
+    // returns false, for callers that filter further as they go
+    template <typename Visit>
+    void visit(const string& location, int minRooms, int maxRooms, bool largestFirst, Visit visit) const {
+        const RoomMap* rooms = &byRooms;
+        string key = locationKey(location);
+        if (!key.empty()) {
+            LocationMap::const_iterator it = byLocation.find(key);
+            if (it == byLocation.end()) return;
+            rooms = &it->second;
+        }
+        if (minRooms > maxRooms) return;
+        if (largestFirst) {
+            RoomMap::const_iterator it = rooms->upper_bound(RoomKey(maxRooms, numeric_limits<int>::max()));
+            while (it != rooms->begin()) {
+                --it;
+                if (it->first.first < minRooms || !visit(it->second)) break;
+            }
+        } else {
+            RoomMap::const_iterator it = rooms->lower_bound(RoomKey(minRooms, numeric_limits<int>::min()));
+            for (; it != rooms->end() && it->first.first <= maxRooms; ++it) {
+                if (!visit(it->second)) break;
+            }
+        }
+    }
+
+    size_t locationCount() const { return byLocation.size(); }
+
+private:
+    typedef pair<int, int> RoomKey; // (roomNumber, id)
+    typedef pmr::map<RoomKey, HotelNode*> RoomMap;
+    typedef pmr::unordered_map<string, RoomMap> LocationMap;
+
+    struct Entry {
+        RoomKey key;
+        HotelNode* node;
+        const string* location; // Its location key
+    };
+
+    // Insert entries sorted by key. The hint walks forward a few existing
+    // keys to the next entry's place, and seeks afresh when it is further.
+    static void insertSorted(RoomMap& rooms, vector<Entry>::const_iterator first, vector<Entry>::const_iterator last) {
+        RoomMap::iterator hint = rooms.lower_bound(first->key);
+        for (; first != last; ++first) {
+            for (int steps = 0; hint != rooms.end() && hint->first < first->key; steps++) {
+                if (steps == 8) {
+                    hint = rooms.lower_bound(first->key);
+                    break;
+                }
+                ++hint;
+            }
+            hint = rooms.emplace_hint(hint, first->key, first->node);
+            hint->second = first->node;
+            ++hint;
+        }
+    }
+
+    RoomMap byRooms;
+    LocationMap byLocation; // location key -> its hotels by room count
+};
+
+const double GEO_PI = 3.14159265358979323846; // M_PI is not standard C++
+
+// Spatial index over hotels with coordinates: a uniform latitude/longitude
+// grid whose cells are cellDegrees on a side (about 2 km by default), storing
+// only occupied cells.
+// nearest() searches ring by ring outward from the query's cell and stops as
+// soon as no unvisited cell can hold anything closer than the k-th result so
+// far; within() visits the cells of the circle's bounding box. Distances are
+// great-circle kilometres. Like RoomIndex, remove() must see the coordinates
+// the node was added with.
+class GeoIndex {
+public:
+    struct Match {
+        double km;
+        HotelNode* node;
+    };
+
+    explicit GeoIndex(double cellDegrees = 0.02)
+        : cellDegrees(cellDegrees), cellRadians(cellDegrees * GEO_PI / 180), rows(int(ceil(180 / cellDegrees))),
+          columns(int(ceil(360 / cellDegrees))), count(0) {}
+
+    static const double EARTH_RADIUS_KM;
+
+    static double distanceKm(double lat1, double lon1, double lat2, double lon2) {
+        double phi1 = lat1 * GEO_PI / 180, phi2 = lat2 * GEO_PI / 180;
+        return toKm(haversine(phi1, lon1 * GEO_PI / 180, cos(phi1), phi2, lon2 * GEO_PI / 180, cos(phi2)));
+    }
+
+    void add(HotelNode* node) {
+        const HotelDetails* details = node->details();
+        Entry entry;
+        entry.phi = details->latitude * GEO_PI / 180;
+        entry.lambda = details->longitude * GEO_PI / 180;
+        entry.cosPhi = cos(entry.phi);
+        entry.node = node;
+        cells[cellKey(rowOf(details->latitude), columnOf(details->longitude))].push_back(entry);
+        count++;
+    }
+
+    void remove(HotelNode* node) {
+        CellMap::iterator it = cells.find(cellKey(rowOf(node->details()->latitude), columnOf(node->details()->longitude)));
+        if (it == cells.end()) return;
+        vector<Entry>& entries = it->second;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].node == node) {
+                entries[i] = entries.back();
+                entries.pop_back();
+                count--;
+                break;
+            }
+        }
+        if (entries.empty()) cells.erase(it);
+    }
+
+    void clear() {
+        cells.clear();
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+
+    // The k hotels closest to (latitude, longitude), nearest first
+    void nearest(double latitude, double longitude, size_t k, vector<Match>& out) const {
+        out.clear();
+        if (k == 0 || count == 0) return;
+        Query query(latitude, longitude);
+        vector<Candidate> heap; // Max-heap on (h, id): the current k-th best on top
+        int row = rowOf(latitude), column = columnOf(longitude);
+        for (int ring = 0;; ring++) {
+            // Past this point visiting rings costs more than one pass over everything
+            if (double(2 * ring + 1) * (2 * ring + 1) > 4.0 * cells.size()) {
+                heap.clear();
+                for (CellMap::const_iterator it = cells.begin(); it != cells.end(); ++it) {
+                    offerAll(it->second, query, k, heap);
+                }
+                break;
+            }
+            for (int dr = -ring; dr <= ring; dr++) {
+                int r = row + dr;
+                if (r < 0 || r >= rows) continue;
+                // Full rows at the top and bottom of the ring, only the two ends between
+                int step = (dr == -ring || dr == ring) ? 1 : 2 * ring;
+                for (int dc = -ring; dc <= ring; dc += step) {
+                    CellMap::const_iterator it = cells.find(cellKey(r, wrapColumn(column + dc)));
+                    if (it != cells.end()) offerAll(it->second, query, k, heap);
+                }
+                if (ring == 0) break;
+            }
+            if (heap.size() == k && heap.front().h <= outsideRingBound(query, ring)) break;
+        }
+        sort_heap(heap.begin(), heap.end(), candidateLess);
+        out.reserve(heap.size());
+        for (size_t i = 0; i < heap.size(); i++) {
+            Match match = {toKm(heap[i].h), heap[i].node};
+            out.push_back(match);
+        }
+    }
+
+    // Hotels within radiusKm of (latitude, longitude), nearest first, at most limit
+    void within(double latitude, double longitude, double radiusKm, size_t limit, vector<Match>& out) const {
+        out.clear();
+        if (limit == 0 || count == 0 || radiusKm < 0) return;
+        Query query(latitude, longitude);
+        double delta = radiusKm / EARTH_RADIUS_KM; // Angular radius
+        double hMax = delta >= GEO_PI ? 1.0 : sin(delta / 2) * sin(delta / 2);
+        vector<Candidate> found;
+
+        // Bounding box in cells; the longitude span widens with latitude and
+        // covers everything once the circle reaches a pole
+        int firstRow = rowOf(latitude - delta * 180 / GEO_PI);
+        int lastRow = rowOf(latitude + delta * 180 / GEO_PI);
+        int spanColumns = columns;
+        if (delta < GEO_PI / 2 && sin(delta) < query.cosPhi) {
+            double halfWidth = asin(sin(delta) / query.cosPhi);
+            spanColumns = min(columns, 2 * (int(halfWidth / cellRadians) + 1) + 1);
+        }
+        if (double(lastRow - firstRow + 1) * spanColumns > double(cells.size())) {
+            for (CellMap::const_iterator it = cells.begin(); it != cells.end(); ++it) {
+                collectWithin(it->second, query, hMax, found);
+            }
+        } else {
+            int firstColumn = spanColumns == columns ? 0 : columnOf(longitude) - spanColumns / 2;
+            for (int r = firstRow; r <= lastRow; r++) {
+                for (int c = 0; c < spanColumns; c++) {
+                    CellMap::const_iterator it = cells.find(cellKey(r, wrapColumn(firstColumn + c)));
+                    if (it != cells.end()) collectWithin(it->second, query, hMax, found);
+                }
+            }
+        }
+        size_t keep = min(limit, found.size());
+        partial_sort(found.begin(), found.begin() + keep, found.end(), candidateLess);
+        out.reserve(keep);
+        for (size_t i = 0; i < keep; i++) {
+            Match match = {toKm(found[i].h), found[i].node};
+            out.push_back(match);
+        }
+    }
+
+private:
+    struct Entry {
+        double phi;    // Latitude, radians
+        double lambda; // Longitude, radians
+        double cosPhi;
+        HotelNode* node;
+    };
+
+    struct Query {
+        double phi, lambda, cosPhi;
+        Query(double latitude, double longitude)
+            : phi(latitude * GEO_PI / 180), lambda(longitude * GEO_PI / 180), cosPhi(cos(phi)) {}
+    };
+
+    // Haversine term h = sin^2(d / 2R), which orders points the same as d
+    struct Candidate {
+        double h;
+        HotelNode* node;
+    };
+
+    typedef unordered_map<long long, vector<Entry> > CellMap;
+
+    double cellDegrees;
+    double cellRadians;
+    int rows;
+    int columns;
+    CellMap cells;
+    size_t count;
+
+    static double haversine(double phi1, double lambda1, double cosPhi1, double phi2, double lambda2, double cosPhi2) {
+        double a = sin((phi2 - phi1) / 2), b = sin((lambda2 - lambda1) / 2);
+        return min(1.0, a * a + cosPhi1 * cosPhi2 * b * b);
+    }
+
+    static double toKm(double h) { return 2 * EARTH_RADIUS_KM * asin(sqrt(h)); }
+
+    static bool candidateLess(const Candidate& a, const Candidate& b) {
+        return a.h != b.h ? a.h < b.h : a.node->id < b.node->id;
+    }
+
+    int rowOf(double latitude) const {
+        int row = int(floor((latitude + 90) / cellDegrees));
+        return row < 0 ? 0 : row >= rows ? rows - 1 : row;
+    }
+
+    int columnOf(double longitude) const { return wrapColumn(int(floor((longitude + 180) / cellDegrees))); }
+
+    int wrapColumn(int column) const {
+        column %= columns;
+        return column < 0 ? column + columns : column;
+    }
+
+    long long cellKey(int row, int column) const { return (long long)row * columns + column; }
+
+    void offerAll(const vector<Entry>& entries, const Query& query, size_t k, vector<Candidate>& heap) const {
+        for (size_t i = 0; i < entries.size(); i++) {
+            const Entry& e = entries[i];
+            Candidate candidate = {haversine(query.phi, query.lambda, query.cosPhi, e.phi, e.lambda, e.cosPhi), e.node};
+            if (heap.size() < k) {
+                heap.push_back(candidate);
+                push_heap(heap.begin(), heap.end(), candidateLess);
+            } else if (candidateLess(candidate, heap.front())) {
+                pop_heap(heap.begin(), heap.end(), candidateLess);
+                heap.back() = candidate;
+                push_heap(heap.begin(), heap.end(), candidateLess);
+            }
+        }
+    }
+
+    void collectWithin(const vector<Entry>& entries, const Query& query, double hMax, vector<Candidate>& found) const {
+        for (size_t i = 0; i < entries.size(); i++) {
+            const Entry& e = entries[i];
+            double h = haversine(query.phi, query.lambda, query.cosPhi, e.phi, e.lambda, e.cosPhi);
+            if (h <= hMax) {
+                Candidate candidate = {h, e.node};
+                found.push_back(candidate);
+            }
+        }
+    }
+
+    // Lower bound on h for any point outside rings 0..ring. Such a point is at
+    // least ring cells away in latitude, or else lies within ring + 1 cells of
+    // the query's latitude and at least ring cells away in longitude.
+    double outsideRingBound(const Query& query, int ring) const {
+        double s = sin(min(ring * cellRadians, GEO_PI) / 2);
+        double farthestPhi = min(GEO_PI / 2, fabs(query.phi) + (ring + 1) * cellRadians);
+        return min(s * s, query.cosPhi * cos(farthestPhi) * s * s);
+    }
+};
+
+const double GeoIndex::EARTH_RADIUS_KM = 6371.0;
+
+// Running totals behind the management report, kept by HotelLinkedList on
+// every add, update and remove so reading them never walks the list: hotels
+// and rooms overall and per location, and hotels per amenity. Locations and
+// amenities are keyed by the list's own dictionary ids, so a change is a few
+// array updates, one per amenity on the hotel, with no hashing.
+class HotelAggregates {
+public:
+    struct Totals {
+        long hotels;
+        long long rooms;
+    };
+
+    HotelAggregates() { clear(); }
+
+    // sign is +1 as a hotel arrives and -1 as it leaves
+    void apply(uint32_t location, int roomNumber, const vector<int>& amenityIds, int sign) {
+        if (location >= byLocation.size()) byLocation.resize(location + 1, Totals());
+        byLocation[location].hotels += sign;
+        byLocation[location].rooms += (long long)sign * roomNumber;
+        for (size_t i = 0; i < amenityIds.size(); i++) {
+            if (size_t(amenityIds[i]) >= byAmenity.size()) byAmenity.resize(amenityIds[i] + 1, 0);
+            byAmenity[amenityIds[i]] += sign;
+        }
+        overall.hotels += sign;
+        overall.rooms += (long long)sign * roomNumber;
+    }
+
+    void clear() {
+        overall = Totals();
+        byLocation.clear();
+        byAmenity.clear();
+    }
+
+    const Totals& total() const { return overall; }
+
+    // Ids run up to every location and amenity ever seen; gone ones read as zero
+    size_t locationIds() const { return byLocation.size(); }
+    const Totals& atLocation(uint32_t location) const { return byLocation[location]; }
+    size_t amenityIds() const { return byAmenity.size(); }
+    long withAmenity(int amenity) const { return byAmenity[amenity]; }
+
+private:
+    Totals overall;
+    vector<Totals> byLocation; // By location table id
+    vector<long> byAmenity;    // By amenity dictionary id
+};
+
+// Linked List for Hotels, indexed by id.
+// The list keeps insertion order for display; the hash index gives O(1)
+// lookup, insert and delete, and the count is kept alongside so size() is O(1).
+// Nodes and details come from slab pools, so clearList() releases whole chunks.
+// Every node also owns a dense slot number, which the amenity index uses as
+// its bitmap position. Location and room count are indexed in RoomIndex, and
+// coordinates, where known, in GeoIndex. HotelAggregates keeps the report's
+// per-location and per-amenity totals in step with every change.
+// Records are stored compactly: locations are interned in a shared table, and
+// services become a bitset over the amenity dictionary. Bits render back in
+// the order amenities have been written so far; the exact text is interned on
+// the side only when that would not reproduce it (an unusual order, spacing
+// or spelling, or amenities past the first 64).
+// emplaceHotel() builds the record straight from its fields: the name is
+// moved in and services and location are only read, so a database row costs
+// one allocation for a name too long for the small-string buffer and
+// nothing else once the pools are warm. The id and room index nodes come
+// from a pool that clearList() releases whole. addHotel() forwards a Hotel,
+// and addHotels() adds an import batch as one version.
+//
+// Multi-version reads: every change is stamped with the next list version
+// and published with a release store, never written over a record a reader
+// might be looking at. A ReadSnapshot pins the version current when it was
+// taken and walks the list without locks, seeing each hotel as it was at
+// that version even while one writer keeps adding, editing and removing.
+// Replaced versions and removed nodes are reclaimed once no pinned snapshot
+// is old enough to reach them; with no readers that is at the end of the
+// same call. Writers must still be serialized among themselves, and the id,
+// room, geo and amenity indexes are writer-side only.
+class HotelLinkedList {
+public:
+    atomic<HotelNode*> head;
+    HotelNode* tail;
+    HotelLinkedList()
+        : head(NULL), tail(NULL), index(&indexMemory), roomIndex(&indexMemory), published(0), activeReaders(0),
+          count(0) {
+        for (int i = 0; i < MAX_READERS; i++) readerSlots[i].version.store(IDLE, memory_order_relaxed);
+    }
+    ~HotelLinkedList() { clearList(); }
+
+    bool addHotel(Hotel&& hotel) {
+        return emplaceHotel(hotel.id, std::move(hotel.name), hotel.services, hotel.location, hotel.roomNumber,
+                            hotel.latitude, hotel.longitude);
+    }
+
+    bool emplaceHotel(int id, string&& name, string_view services, string_view location, int roomNumber,
+                      double latitude, double longitude) {
+        uint64_t version = published.load(memory_order_relaxed) + 1;
+        HotelNode* node = link(id, std::move(name), services, location, roomNumber, latitude, longitude, version);
+        if (!node) return false; // Duplicate ID, keep the existing record
+        roomIndex.add(node, locations[node->details()->location]);
+        publish(version);
+        return true;
+    }
+
+    // Add the hotels whose take[i] is set as one version, so readers see the
+    // whole batch appear at once, and hand them to the room index sorted.
+    // Returns how many were added; a duplicate id keeps the existing record.
+    size_t addHotels(vector<Hotel>& hotels, const vector<char>& take) {
+        uint64_t version = published.load(memory_order_relaxed) + 1;
+        vector<HotelNode*> added;
+        for (size_t i = 0; i < hotels.size(); i++) {
+            if (!take[i]) continue;
+            Hotel& hotel = hotels[i];
+            HotelNode* node = link(hotel.id, std::move(hotel.name), hotel.services, hotel.location,
+                                   hotel.roomNumber, hotel.latitude, hotel.longitude, version);
+            if (node) added.push_back(node);
+        }
+        if (added.empty()) return 0;
+        // Locations are resolved only now: interning may move the table
+        vector<pair<HotelNode*, const string*> > rooms(added.size());
+        for (size_t i = 0; i < added.size(); i++) {
+            rooms[i] = make_pair(added[i], &locations[added[i]->details()->location]);
+        }
+        roomIndex.addAll(rooms);
+        publish(version);
+        return added.size();
+    }
+
+    // Replace the stored fields of an existing hotel; the id selects the record.
+    // The new fields go into a fresh version, so readers never see a half-edit.
+    bool updateHotel(const Hotel& hotel) {
+        HotelNode* node = findHotel(hotel.id);
+        if (!node) return false;
+        HotelDetails* current = node->details();
+        uint64_t version = published.load(memory_order_relaxed) + 1;
+        string services = servicesOf(node);
+        aggregates.apply(current->location, node->roomNumber, amenityIndex.parse(services), -1);
+        amenityIndex.update(node->slot, services, hotel.services);
+        nameIndex.update(hotel.id, current->name, hotel.name);
+        const string& location = locationOf(node);
+        bool reindex = node->roomNumber != hotel.roomNumber || location != hotel.location;
+        if (reindex) roomIndex.remove(node, location);
+        bool moved = current->hasCoordinates() != hotel.hasCoordinates() ||
+                     (hotel.hasCoordinates() &&
+                      (current->latitude != hotel.latitude || current->longitude != hotel.longitude));
+        if (moved && current->hasCoordinates()) geoIndex.remove(node);
+
+        HotelDetails* next = detailsPool.create(string(hotel.name), current->location, hotel.roomNumber,
+                                                hotel.latitude, hotel.longitude);
+        if (location != hotel.location) next->location = locations.intern(hotel.location);
+        if (services != hotel.services) {
+            encodeServices(hotel.services, next);
+        } else {
+            next->amenities = current->amenities;
+            next->servicesText = current->servicesText;
+        }
+        next->version = version;
+        next->older = current;
+        node->latest.store(next, memory_order_release);
+        node->roomNumber = hotel.roomNumber;
+        retiredVersions.push_back(RetiredVersion(current, next));
+
+        aggregates.apply(next->location, hotel.roomNumber, amenityIndex.parse(hotel.services), 1);
+        if (reindex) roomIndex.add(node, hotel.location);
+        if (moved && hotel.hasCoordinates()) geoIndex.add(node);
+        publish(version);
+        return true;
+    }
+
+    // Unindex the hotel and mark it removed. The node stays linked until no
+    // snapshot from before the removal is still pinned.
+    bool removeHotel(int id) {
+        IdIndex::iterator it = index.find(id);
+        if (it == index.end()) return false;
+        HotelNode* node = it->second;
+        HotelDetails* current = node->details();
+        uint64_t version = published.load(memory_order_relaxed) + 1;
+        index.erase(it);
+        string services = servicesOf(node);
+        amenityIndex.remove(node->slot, services);
+        aggregates.apply(current->location, current->roomNumber, amenityIndex.parse(services), -1);
+        nameIndex.remove(id);
+        roomIndex.remove(node, locationOf(node));
+        if (current->hasCoordinates()) geoIndex.remove(node);
+        slots[node->slot] = NULL;
+        freeSlots.push_back(node->slot);
+
+        HotelDetails* marker = detailsPool.create(string(), current->location, current->roomNumber, NAN, NAN);
+        marker->removed = true;
+        marker->version = version;
+        marker->older = current;
+        node->latest.store(marker, memory_order_release);
+        retiredVersions.push_back(RetiredVersion(current, marker));
+        unlinkQueue.push_back(RetiredNode(node, version));
+        count--;
+        publish(version);
+        return true;
+    }
+
+    HotelNode* findHotel(int id) {
+        IdIndex::iterator it = index.find(id);
+        return it == index.end() ? NULL : it->second;
+    }
+
+    void displayHotels() {
+        ostringstream out;
+        out << "\n--- Hotel List ---\n";
+        ReadSnapshot snapshot(*this);
+        for (const HotelNode* node = snapshot.first(); node; node = snapshot.next(node)) {
+            const HotelDetails* details = snapshot.recordOf(node);
+            formatHotel(out, node->id, details->name, servicesOf(details), locationOf(details), details->roomNumber);
+        }
+        cout << out.str() << flush;
+    }
+
+    const string& locationOf(const HotelNode* node) const {
+        return locationOf(node->details());
+    }
+
+    string servicesOf(const HotelNode* node) const {
+        return servicesOf(node->details());
+    }
+
+    // Safe on any version a snapshot returned: the dictionaries never move
+    // what they have handed out
+    const string& locationOf(const HotelDetails* details) const {
+        return locations[details->location];
+    }
+
+    string servicesOf(const HotelDetails* details) const {
+        return details->servicesText == HotelDetails::NO_TEXT ? renderServices(details->amenities)
+                                                              : servicesTexts[details->servicesText];
+    }
+
+    // Decode a record back into a standalone Hotel
+    Hotel toHotel(const HotelNode* node) const {
+        return toHotel(node->id, node->details());
+    }
+
+    Hotel toHotel(int id, const HotelDetails* details) const {
+        Hotel hotel;
+        hotel.id = id;
+        hotel.name = details->name;
+        hotel.services = servicesOf(details);
+        hotel.location = locationOf(details);
+        hotel.roomNumber = details->roomNumber;
+        hotel.latitude = details->latitude;
+        hotel.longitude = details->longitude;
+        return hotel;
+    }
+
+    bool isHotelIdUnique(int id) {
+        return index.find(id) == index.end();
+    }
+
+    // A consistent copy of every hotel, taken without blocking the writer
+    list<Hotel> toList() const {
+        list<Hotel> hotelList;
+        ReadSnapshot snapshot(*this);
+        for (const HotelNode* node = snapshot.first(); node; node = snapshot.next(node)) {
+            hotelList.push_back(snapshot.toHotel(node));
+        }
+        return hotelList;
+    }
+
+    int size() {
+        return count;
+    }
+
+    // Pre-size the index before a bulk load so it does not rehash per insert
+    void reserve(size_t expected) {
+        index.reserve(expected);
+        slots.reserve(expected);
+    }
+
+    // Only call with no snapshot pinned
+    void clearList() {
+        reclaim();
+        // Only the strings need destructors; the slabs are then dropped whole
+        HotelNode* current = head.load(memory_order_relaxed);
+        while (current) {
+            current->details()->~HotelDetails();
+            current = current->next.load(memory_order_relaxed);
+        }
+        detailsPool.release();
+        nodePool.release();
+        head.store(NULL, memory_order_relaxed);
+        tail = NULL;
+        IdIndex(&indexMemory).swap(index);
+        slots.clear();
+        freeSlots.clear();
+        amenityIndex.clear();
+        aggregates.clear();
+        nameIndex.clear();
+        roomIndex.clear();
+        indexMemory.release();
+        geoIndex.clear();
+        locations.clear();
+        servicesTexts.clear();
+        renderOrder.clear();
+        amenityNames.clear();
+        amenityRanks.clear();
+        count = 0;
+    }
+
+    HotelNode* hotelAtSlot(uint32_t slot) {
+        return slot < slots.size() ? slots[slot] : NULL;
+    }
+
+    const AmenityIndex& amenities() const {
+        return amenityIndex;
+    }
+
+    // Report totals as of the last change; see HotelAggregates
+    const HotelAggregates& totals() const {
+        return aggregates;
+    }
+
+    const string& locationName(uint32_t location) const {
+        return locations[location];
+    }
+
+    // Hotels matching a boolean amenity query, in slot order
+    bool searchByServices(const string& query, vector<HotelNode*>& matches, string& error) {
+        CompressedBitmap result;
+        matches.clear();
+        if (!amenityIndex.query(query, result, error)) return false;
+        vector<uint32_t> matchSlots;
+        result.toVector(matchSlots);
+        matches.reserve(matchSlots.size());
+        for (size_t i = 0; i < matchSlots.size(); i++) matches.push_back(slots[matchSlots[i]]);
+        return true;
+    }
+
+    // Hotels whose names resemble the query, best first; see TrigramIndex::search
+    void searchByName(string_view query, size_t limit, vector<TrigramIndex::Match>& matches) const {
+        nameIndex.search(query, limit, matches);
+    }
+
+    // Hotels by room count, optionally at one location; see RoomIndex::query
+    void findByRooms(const string& location, int minRooms, int maxRooms, bool largestFirst, size_t limit,
+                     vector<HotelNode*>& matches) const {
+        roomIndex.query(location, minRooms, maxRooms, largestFirst, limit, matches);
+    }
+
+    // Walk the same hotels without collecting them; see RoomIndex::visit
+    template <typename Visit>
+    void forEachByRooms(const string& location, int minRooms, int maxRooms, bool largestFirst, Visit visit) const {
+        roomIndex.visit(location, minRooms, maxRooms, largestFirst, visit);
+    }
+
+    // The k hotels nearest a point, closest first; see GeoIndex::nearest
+    void nearestHotels(double latitude, double longitude, size_t k, vector<GeoIndex::Match>& matches) const {
+        geoIndex.nearest(latitude, longitude, k, matches);
+    }
+
+    // Hotels within radiusKm of a point, closest first, at most limit
+    void hotelsWithin(double latitude, double longitude, double radiusKm, size_t limit,
+                      vector<GeoIndex::Match>& matches) const {
+        geoIndex.within(latitude, longitude, radiusKm, limit, matches);
+    }
+
+    size_t chunkAllocationCount() const {
+        return nodePool.chunkAllocationCount() + detailsPool.chunkAllocationCount();
+    }
+
+    size_t locationCount() const { return locations.size(); }
+    size_t servicesTextCount() const { return servicesTexts.size(); }
+
+    // Versions and nodes waiting for old snapshots to be released
+    size_t retiredCount() const { return retiredVersions.size() + unlinkQueue.size() + freeQueue.size(); }
+
+    // The list as of the version current at construction. Taking and
+    // walking a snapshot never blocks and is never blocked by the writer.
+    // Nodes returned stay readable until the snapshot is destroyed.
+    class ReadSnapshot {
+    public:
+        explicit ReadSnapshot(const HotelLinkedList& list) : list(list) { snapshotVersion = list.pin(slot); }
+        ~ReadSnapshot() { list.unpin(slot); }
+
+        uint64_t version() const { return snapshotVersion; }
+
+        const HotelNode* first() const { return visibleFrom(list.head.load(memory_order_acquire)); }
+        const HotelNode* next(const HotelNode* node) const {
+            return visibleFrom(node->next.load(memory_order_acquire));
+        }
+
+        // The node's fields as of this snapshot; NULL if it was added later or already removed
+        const HotelDetails* recordOf(const HotelNode* node) const {
+            for (const HotelDetails* details = node->latest.load(memory_order_acquire); details;
+                 details = details->older) {
+                if (details->version <= snapshotVersion) return details->removed ? NULL : details;
+            }
+            return NULL;
+        }
+
+        Hotel toHotel(const HotelNode* node) const { return list.toHotel(node->id, recordOf(node)); }
+
+    private:
+        const HotelLinkedList& list;
+        uint64_t snapshotVersion;
+        int slot;
+
+        const HotelNode* visibleFrom(const HotelNode* node) const {
+            while (node && !recordOf(node)) node = node->next.load(memory_order_acquire);
+            return node;
+        }
+
+        ReadSnapshot(const ReadSnapshot&);
+        ReadSnapshot& operator=(const ReadSnapshot&);
+    };
+
+private:
+    static const int MAX_READERS = 64; // Snapshots pinned at once; more wait for a free slot
+    static const uint64_t IDLE = ~uint64_t(0);
+
+    struct alignas(64) ReaderSlot {
+        atomic<uint64_t> version; // Pinned version, or IDLE
+    };
+
+    struct RetiredVersion {
+        HotelDetails* details;
+        HotelDetails* newer; // Its replacement, whose older link is cleared on reclaim
+        RetiredVersion(HotelDetails* details, HotelDetails* newer) : details(details), newer(newer) {}
+    };
+
+    struct RetiredNode {
+        HotelNode* node;
+        uint64_t version; // Removed at this version; later, unlinked before it
+        RetiredNode(HotelNode* node, uint64_t version) : node(node), version(version) {}
+    };
+
+    typedef pmr::unordered_map<int, HotelNode*> IdIndex;
+
+    pmr::unsynchronized_pool_resource indexMemory; // Before the indexes that use it
+    SlabPool<HotelNode> nodePool;
+    SlabPool<HotelDetails> detailsPool;
+    IdIndex index;                        // id -> node
+    vector<HotelNode*> slots;             // slot -> node, NULL when free
+    vector<uint32_t> freeSlots;
+    AmenityIndex amenityIndex;
+    HotelAggregates aggregates;
+    TrigramIndex nameIndex;               // Hotel names, by id
+    RoomIndex roomIndex;
+    GeoIndex geoIndex;
+    StringTable locations;
+    StringTable servicesTexts;            // Services strings the amenity bits cannot reproduce
+    vector<int> renderOrder;              // Amenity ids in the order they are usually written
+    SegmentedArray<string> amenityNames;  // By amenity id, for rendering without the writer's index
+    SegmentedArray<double> amenityRanks;  // Position of each amenity in renderOrder
+    atomic<uint64_t> published;           // Version of the latest completed change
+    mutable atomic<int> activeReaders;
+    mutable ReaderSlot readerSlots[MAX_READERS];
+    deque<RetiredVersion> retiredVersions; // In the order they were replaced
+    deque<RetiredNode> unlinkQueue;        // Removed, still linked for older snapshots
+    deque<RetiredNode> freeQueue;          // Unlinked, waiting for snapshots that may stand on them
+    string rendered;                       // Scratch for encodeServices
+    int count;
+
+    // Snapshot registration. The reader's pin and the writer's publish are
+    // both sequentially consistent, so a writer scanning the slots either
+    // sees the pin or the reader sees the new version and pins that instead.
+    uint64_t pin(int& slot) const {
+        activeReaders.fetch_add(1);
+        static thread_local int hint = 0;
+        while (true) {
+            for (int n = 0; n < MAX_READERS; n++) {
+                int i = (hint + n) % MAX_READERS;
+                uint64_t expected = IDLE;
+                uint64_t seen = published.load();
+                if (!readerSlots[i].version.compare_exchange_strong(expected, seen)) continue;
+                uint64_t now;
+                while ((now = published.load()) != seen) {
+                    readerSlots[i].version.store(now);
+                    seen = now;
+                }
+                hint = i;
+                slot = i;
+                return seen;
+            }
+            this_thread::yield();
+        }
+    }
+
+    void unpin(int slot) const {
+        readerSlots[slot].version.store(IDLE, memory_order_release);
+        activeReaders.fetch_sub(1, memory_order_release);
+    }
+
+    // Append a hotel stamped with version and index it everywhere but the
+    // room index; the caller adds it there and publishes. NULL for a
+    // duplicate id.
+    HotelNode* link(int id, string&& name, string_view services, string_view location, int roomNumber,
+                    double latitude, double longitude, uint64_t version) {
+        if (index.count(id)) return NULL;
+        HotelDetails* details =
+            detailsPool.create(std::move(name), locations.intern(location), roomNumber, latitude, longitude);
+        encodeServices(services, details);
+        details->version = version;
+        HotelNode* newNode = nodePool.create(id, roomNumber, details);
+        newNode->prev = tail;
+        if (!tail) {
+            head.store(newNode, memory_order_release);
+        } else {
+            tail->next.store(newNode, memory_order_release);
+        }
+        tail = newNode;
+        index.emplace(id, newNode);
+        if (freeSlots.empty()) {
+            newNode->slot = uint32_t(slots.size());
+            slots.push_back(newNode);
+        } else {
+            newNode->slot = freeSlots.back();
+            freeSlots.pop_back();
+            slots[newNode->slot] = newNode;
+        }
+        amenityIndex.add(newNode->slot, services);
+        aggregates.apply(details->location, roomNumber, amenityIndex.parse(services), 1);
+        nameIndex.add(id, details->name);
+        if (details->hasCoordinates()) geoIndex.add(newNode);
+        count++;
+        return newNode;
+    }
+
+    // The oldest version any pinned snapshot may still be reading
+    uint64_t oldestPinned() const {
+        uint64_t oldest = published.load();
+        if (activeReaders.load() == 0) return oldest;
+        for (int i = 0; i < MAX_READERS; i++) {
+            uint64_t version = readerSlots[i].version.load();
+            if (version < oldest) oldest = version;
+        }
+        return oldest;
+    }
+
+    void publish(uint64_t version) {
+        published.store(version);
+        reclaim();
+    }
+
+    // Free what no pinned snapshot can reach. A removed node is unlinked once
+    // every snapshot is at or past its removal, and freed once every snapshot
+    // is past the extra version published after the unlink, since a reader
+    // pinned earlier may be standing on it.
+    void reclaim() {
+        if (retiredVersions.empty() && unlinkQueue.empty() && freeQueue.empty()) return;
+        uint64_t oldest = oldestPinned();
+        while (!retiredVersions.empty() && retiredVersions.front().newer->version <= oldest) {
+            retiredVersions.front().newer->older = NULL;
+            detailsPool.destroy(retiredVersions.front().details);
+            retiredVersions.pop_front();
+        }
+        bool unlinked = false;
+        uint64_t unlinkVersion = published.load(memory_order_relaxed) + 1;
+        while (!unlinkQueue.empty() && unlinkQueue.front().version <= oldest) {
+            HotelNode* node = unlinkQueue.front().node;
+            HotelNode* next = node->next.load(memory_order_relaxed);
+            if (node->prev) node->prev->next.store(next, memory_order_release);
+            else head.store(next, memory_order_release);
+            if (next) next->prev = node->prev;
+            else tail = node->prev;
+            freeQueue.push_back(RetiredNode(node, unlinkVersion));
+            unlinkQueue.pop_front();
+            unlinked = true;
+        }
+        if (unlinked) {
+            published.store(unlinkVersion);
+            oldest = oldestPinned();
+        }
+        while (!freeQueue.empty() && freeQueue.front().version <= oldest) {
+            HotelNode* node = freeQueue.front().node;
+            HotelDetails* details = node->details();
+            while (details) {
+                HotelDetails* older = details->older;
+                detailsPool.destroy(details);
+                details = older;
+            }
+            nodePool.destroy(node);
+            freeQueue.pop_front();
+        }
+    }
+
+    void encodeServices(string_view services, HotelDetails* details) {
+        const vector<int>& ids = amenityIndex.parse(services);
+        uint64_t bits = 0;
+        for (size_t i = 0; i < ids.size(); i++) {
+            if (ids[i] >= int(renderOrder.size())) placeAmenity(ids, i);
+            if (ids[i] < 64) bits |= uint64_t(1) << ids[i];
+        }
+        details->amenities = bits;
+        rendered.clear();
+        appendServices(bits, rendered);
+        details->servicesText = rendered == services ? HotelDetails::NO_TEXT : servicesTexts.intern(services);
+    }
+
+    // Slot a newly seen amenity into the render order: straight after the one
+    // written before it, else before the first known one written after it.
+    // Its rank lies between its neighbours' and never changes afterwards.
+    void placeAmenity(const vector<int>& ids, size_t position) {
+        vector<int>::iterator at = renderOrder.end();
+        if (position > 0) {
+            at = find(renderOrder.begin(), renderOrder.end(), ids[position - 1]) + 1;
+        } else {
+            for (size_t i = 1; i < ids.size() && at == renderOrder.end(); i++) {
+                if (ids[i] < int(renderOrder.size())) at = find(renderOrder.begin(), renderOrder.end(), ids[i]);
+            }
+        }
+        double rank;
+        if (renderOrder.empty()) rank = 0;
+        else if (at == renderOrder.end()) rank = amenityRanks[renderOrder.back()] + 1;
+        else if (at == renderOrder.begin()) rank = amenityRanks[renderOrder.front()] - 1;
+        else rank = (amenityRanks[*(at - 1)] + amenityRanks[*at]) / 2;
+        renderOrder.insert(at, ids[position]);
+        amenityNames.push_back(amenityIndex.amenityName(ids[position]));
+        amenityRanks.push_back(rank);
+    }
+
+    // The amenities set in bits, as a services string
+    string renderServices(uint64_t bits) const {
+        string text;
+        appendServices(bits, text);
+        return text;
+    }
+
+    // Append the amenities ordered by rank (ties, should a gap ever run out, by id)
+    void appendServices(uint64_t bits, string& text) const {
+        int ids[64];
+        int n = 0;
+        for (int id = 0; bits; id++, bits >>= 1) {
+            if (!(bits & 1)) continue;
+            int i = n++;
+            while (i > 0 && amenityRanks[ids[i - 1]] > amenityRanks[id]) {
+                ids[i] = ids[i - 1];
+                i--;
+            }
+            ids[i] = id;
+        }
+        for (int i = 0; i < n; i++) {
+            if (i) text += ", ";
+            text += amenityNames[ids[i]];
+        }
+    }
+
+    HotelLinkedList(const HotelLinkedList&);
+    HotelLinkedList& operator=(const HotelLinkedList&);
+};
+
+// Cold guest fields
+struct GuestDetails {
+    string name;
+    chrono::steady_clock::time_point joined; // When this process took the guest in
+
+    explicit GuestDetails(string&& name) : name(std::move(name)), joined(chrono::steady_clock::now()) {}
+};
+
+// Running queue figures for the management report, since start-up. Waits
+// are timed from when this process took the guest in, which for guests
+// loaded at start-up is the load.
+struct QueueTotals {
+    long served;
+    double servedWaitSeconds; // Summed over served guests
+    double longestWaitSeconds; // Longest any served guest waited
+};
+
+// Node for Guest Linked List (hot fields inline, name in the details slab).
+// queuePosition is the guest's ticket; the live place in line is its rank.
+struct GuestNode {
+    int id;
+    int queuePosition;
+    GuestNode* next;
+    GuestNode* prev;
+    GuestDetails* details;
+
+    GuestNode(int id, int queuePosition, GuestDetails* details)
+        : id(id), queuePosition(queuePosition), next(NULL), prev(NULL), details(details) {}
+
+    Guest toGuest() const {
+        Guest guest;
+        guest.id = id;
+        guest.name = details->name;
+        guest.queuePosition = queuePosition;
+        return guest;
+    }
+};
+
+// Fenwick (binary indexed) tree counting waiting guests per ticket number.
+// countUpTo(t) is the number of guests holding a ticket <= t, so a guest's
+// live rank, an enqueue, a cancel and a serve each cost O(log n). Tickets
+// map to slots relative to `base`; when a ticket falls outside the window
+// the tree is rebuilt around the live range in O(window), which amortizes
+// to O(1) per ticket because the window at least doubles.
+class TicketRankTree {
+public:
+    TicketRankTree() : base(1) {}
+
+    void add(int ticket, int delta) {
+        if (ticket < base || ticket - base >= int(counts.size())) rebuild(ticket);
+        int slot = ticket - base;
+        counts[slot] += delta;
+        for (int i = slot + 1; i <= int(tree.size()); i += i & -i) tree[i - 1] += delta;
+    }
+
+    int countUpTo(int ticket) const {
+        if (ticket < base) return 0;
+        int slot = min(ticket - base, int(counts.size()) - 1);
+        int total = 0;
+        for (int i = slot + 1; i > 0; i -= i & -i) total += tree[i - 1];
+        return total;
+    }
+
+    void clear() {
+        counts.clear();
+        tree.clear();
+        base = 1;
+    }
+
+private:
+    vector<int> counts; // counts[t - base], kept to rebuild the tree in O(n)
+    vector<int> tree;   // Fenwick array over counts, 1-based in the loops
+    int base;
+
+    // Re-centre the window on the tickets still waiting plus the new one
+    void rebuild(int ticket) {
+        int low = ticket, high = ticket;
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (counts[i]) {
+                low = min(low, base + int(i));
+                high = max(high, base + int(i));
+            }
+        }
+        size_t span = size_t(high - low) + 1;
+        size_t size = max<size_t>(64, span * 2);
+        vector<int> moved(size, 0);
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (counts[i]) moved[base + int(i) - low] = counts[i];
+        }
+        counts.swap(moved);
+        base = low;
+        tree = counts;
+        for (size_t i = 1; i <= tree.size(); i++) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent <= tree.size()) tree[parent - 1] += tree[i - 1];
+        }
+    }
+};
+
+// Linked List for Guests (acting as Queue).
+// Queue positions are tickets from an atomic counter: unique, increasing, and
+// safe to hand out from several check-in terminals at once. The list is kept
+// in ticket order and doubly linked, an id index finds any guest, a
+// TrigramIndex finds them by a misspelt name, and a TicketRankTree answers
+// "where am I now?" in O(log n). QueueTotals counts serves and their waits
+// for the management report as they happen. Like hotels, guests
+// are built in place by emplaceGuest() and index nodes come from a pool.
+class GuestLinkedList {
+public:
+    GuestNode* head;
+    GuestNode* tail; // To efficiently add to the end (enqueue)
+    GuestLinkedList() : head(NULL), tail(NULL), index(&indexMemory), count(0), nextTicket(1) {
+        totals = QueueTotals();
+        lastDeparture = Departure();
+    }
+    ~GuestLinkedList() { clearList(); }
+
+    // Next ticket number for a guest joining the queue
+    int issueTicket() {
+        return nextTicket.fetch_add(1);
+    }
+
+    // Make sure later tickets come after one that is already taken
+    void noteTicket(int ticket) {
+        int next = nextTicket.load();
+        while (ticket >= next && !nextTicket.compare_exchange_weak(next, ticket + 1)) {
+        }
+    }
+
+    bool addGuest(const Guest& guest) { // Enqueue
+        return emplaceGuest(guest.id, string(guest.name), guest.queuePosition);
+    }
+
+    bool addGuest(Guest&& guest) {
+        return emplaceGuest(guest.id, std::move(guest.name), guest.queuePosition);
+    }
+
+    bool emplaceGuest(int id, string&& name, int queuePosition) {
+        if (index.count(id)) {
+            return false; // Duplicate ID, keep the existing guest
+        }
+        noteTicket(queuePosition);
+        GuestNode* newNode = nodePool.create(id, queuePosition, detailsPool.create(std::move(name)));
+        // New tickets go at the tail; older ones (e.g. replayed) walk back to their place
+        GuestNode* after = tail;
+        while (after && after->queuePosition > queuePosition) after = after->prev;
+        newNode->prev = after;
+        newNode->next = after ? after->next : head;
+        if (newNode->next) newNode->next->prev = newNode;
+        else tail = newNode;
+        if (after) after->next = newNode;
+        else head = newNode;
+        index.emplace(id, newNode);
+        nameIndex.add(id, newNode->details->name);
+        ranks.add(queuePosition, 1);
+        count++;
+        return true;
+    }
+
+    Guest serveGuest() { // Dequeue
+        if (!head) {
+            return Guest(); // Return default Guest if queue is empty
+        }
+        Guest guest = head->toGuest();
+        double waited = secondsWaiting(head);
+        unlink(head);
+        lastDeparture.served = true;
+        lastDeparture.waited = waited;
+        lastDeparture.longestBefore = totals.longestWaitSeconds;
+        totals.served++;
+        totals.servedWaitSeconds += waited;
+        totals.longestWaitSeconds = max(totals.longestWaitSeconds, waited);
+        return guest;
+    }
+
+    // Undo the last serve or cancel after its database write failed: the
+    // guest goes back to their place with their original joining time, and
+    // a serve comes off the totals again
+    void takeBack(const Guest& guest) {
+        if (!addGuest(guest)) return;
+        GuestNode* node = findGuest(guest.id);
+        node->details->joined = lastDeparture.joined;
+        if (lastDeparture.served) {
+            totals.served--;
+            totals.servedWaitSeconds -= lastDeparture.waited;
+            totals.longestWaitSeconds = lastDeparture.longestBefore;
+        }
+        lastDeparture = Departure();
+    }
+
+    const QueueTotals& servedTotals() const {
+        return totals;
+    }
+
+    // How long the guest has been in line, as far as this process knows
+    static double secondsWaiting(const GuestNode* node) {
+        return chrono::duration<double>(chrono::steady_clock::now() - node->details->joined).count();
+    }
+
+    // Take a guest out of the queue wherever they are (cancellation)
+    bool removeGuest(int id) {
+        GuestNode* node = findGuest(id);
+        if (!node) return false;
+        unlink(node);
+        return true;
+    }
+
+    GuestNode* findGuest(int id) {
+        IdIndex::iterator it = index.find(id);
+        return it == index.end() ? NULL : it->second;
+    }
+
+    // Current place in line (1 = next to be served), or 0 if not queued
+    int rankOf(int id) {
+        GuestNode* node = findGuest(id);
+        return node ? ranks.countUpTo(node->queuePosition - 1) + 1 : 0;
+    }
+
+    // Queued guests whose names resemble the query, best first
+    void searchByName(string_view query, size_t limit, vector<TrigramIndex::Match>& matches) const {
+        nameIndex.search(query, limit, matches);
+    }
+
+    void displayGuests() {
+        ostringstream out;
+        out << "\n--- Guest Queue ---\n";
+        int rank = 1;
+        GuestNode* current = head;
+        while (current) {
+            formatGuest(out, current->id, current->details->name, current->queuePosition, rank++);
+            current = current->next;
+        }
+        cout << out.str() << flush;
+    }
+
+    bool isGuestIdUnique(int id) {
+        return index.find(id) == index.end();
+    }
+
+    list<Guest> toList() {
+        list<Guest> guestList;
+        GuestNode* current = head;
+        while (current) {
+            guestList.push_back(current->toGuest());
+            current = current->next;
+        }
+        return guestList;
+    }
+
+    int size() const {
+        return count;
+    }
+
+    void reserve(size_t expected) {
+        index.reserve(expected);
+    }
+
+    void clearList() {
+        GuestNode* current = head;
+        while (current) {
+            current->details->~GuestDetails();
+            current = current->next;
+        }
+        detailsPool.release();
+        nodePool.release();
+        head = NULL;
+        tail = NULL;
+        IdIndex(&indexMemory).swap(index);
+        indexMemory.release();
+        nameIndex.clear();
+        ranks.clear();
+        count = 0;
+        lastDeparture = Departure(); // Served totals are history and outlive a reload
+    }
+
+    size_t chunkAllocationCount() const {
+        return nodePool.chunkAllocationCount() + detailsPool.chunkAllocationCount();
+    }
+
+private:
+    typedef pmr::unordered_map<int, GuestNode*> IdIndex;
+
+    // What takeBack() needs to reverse the latest serve or cancel
+    struct Departure {
+        bool served;
+        chrono::steady_clock::time_point joined;
+        double waited;
+        double longestBefore;
+    };
+
+    pmr::unsynchronized_pool_resource indexMemory; // Before the index that uses it
+    SlabPool<GuestNode> nodePool;
+    SlabPool<GuestDetails> detailsPool;
+    IdIndex index; // id -> node
+    TrigramIndex nameIndex;
+    TicketRankTree ranks;
+    int count;
+    atomic<int> nextTicket;
+    QueueTotals totals;
+    Departure lastDeparture;
+
+    void unlink(GuestNode* node) {
+        lastDeparture.served = false;
+        lastDeparture.joined = node->details->joined;
+        if (node->prev) node->prev->next = node->next;
+        else head = node->next;
+        if (node->next) node->next->prev = node->prev;
+        else tail = node->prev;
+        ranks.add(node->queuePosition, -1);
+        index.erase(node->id);
+        nameIndex.remove(node->id);
+        detailsPool.destroy(node->details);
+        nodePool.destroy(node);
+        count--;
+    }
+
+    GuestLinkedList(const GuestLinkedList&);
+    GuestLinkedList& operator=(const GuestLinkedList&);
+};
+
+
+// Rooms booked per night at one hotel: a segment tree with lazy range add
+// over a window of nights, so booking or cancelling a stay and finding the
+// busiest night of any date range are each O(log n) in the window, however
+// long the stay. Each node keeps the busiest night below it including its
+// own pending addition, and pending additions are never pushed down, which
+// keeps busiest() const for concurrent readers.
+// The leaves are blocks of BLOCK nights whose own counts sit in a flat
+// array, scanned when a stay starts or ends inside the block. That keeps the
+// tree an eighth of the size, so a check at one of thousands of hotels
+// touches a few cache lines rather than one per level.
+// Like TicketRankTree, the window starts at `base` and, when a stay falls
+// outside it, is rebuilt around the booked nights at twice their spread;
+// nights outside the window have nothing booked.
+class RoomCalendar {
+public:
+    static constexpr int BLOCK = 8;
+
+    RoomCalendar() : base(0), span(0) {}
+
+    // Most rooms booked on any night in [checkIn, checkOut). Walks up from
+    // the two end blocks: every node taken on the left lies under l - 1 and
+    // every one on the right under r, so each side picks up the additions
+    // pending above it as it climbs.
+    int busiest(int checkIn, int checkOut) const {
+        int from = max(checkIn, base) - base;
+        int to = min(checkOut, base + span) - base;
+        if (from >= to) return 0;
+        const int NONE = numeric_limits<int>::min() / 2;
+        size_t leaves = size_t(span / BLOCK);
+        size_t l = leaves + from / BLOCK, r = leaves + (to - 1) / BLOCK + 1;
+        int left = NONE, right = NONE;
+        if (from % BLOCK) {
+            left = scanBlock(l, from, min(to, (from / BLOCK + 1) * BLOCK));
+            l++;
+        }
+        if (to % BLOCK && l < r) {
+            right = scanBlock(r - 1, (to - 1) / BLOCK * BLOCK, to);
+            r--;
+        }
+        while (l < r) {
+            if (l & 1) left = max(left, nodes[l++].peak);
+            if (r & 1) right = max(right, nodes[--r].peak);
+            l >>= 1;
+            r >>= 1;
+            left += nodes[l - 1].pending;
+            right += nodes[r].pending;
+        }
+        for (size_t node = l - 1; node > 1; node >>= 1) left += nodes[node >> 1].pending;
+        for (size_t node = r; node > 1; node >>= 1) right += nodes[node >> 1].pending;
+        return max(left, right);
+    }
+
+    // Book (rooms > 0) or release (rooms < 0) the nights [checkIn, checkOut)
+    void add(int checkIn, int checkOut, int rooms) {
+        if (checkIn >= checkOut) return;
+        if (checkIn < base || checkOut > base + span) grow(checkIn, checkOut);
+        add(1, 0, span, checkIn - base, checkOut - base, rooms);
+    }
+
+    int windowStart() const { return base; }
+    int windowNights() const { return span; }
+
+    // Most rooms booked on any night at all
+    int peak() const { return span ? nodes[1].peak : 0; }
+
+    // Booked nights with more than `rooms` booked, in date order. Nights with
+    // nothing booked never count, whatever `rooms` is.
+    void nightsAbove(int rooms, vector<int>& found) const {
+        found.clear();
+        rooms = max(rooms, 0);
+        if (peak() <= rooms) return;
+        vector<int> booked(span, 0);
+        collect(1, 0, span, 0, booked);
+        for (int i = 0; i < span; i++) {
+            if (booked[i] > rooms) found.push_back(base + i);
+        }
+    }
+
+private:
+    struct Node {
+        int peak;    // Busiest night in this subtree, counting `pending`
+        int pending; // Rooms added to every night in this subtree
+    };
+
+    vector<Node> nodes; // Heap order from 1; one leaf per block of nights
+    vector<int> nights; // Rooms booked per night by stays covering only part of its block
+    int base;
+    int span; // Nights in the window: a power of two, or 0 before the first booking
+
+    // Busiest of the nights [from, to) within one block, counting the
+    // block's own pending addition
+    int scanBlock(size_t leaf, int from, int to) const {
+        int best = nights[from];
+        for (int night = from + 1; night < to; night++) best = max(best, nights[night]);
+        return best + nodes[leaf].pending;
+    }
+
+    void add(size_t node, int low, int high, int from, int to, int rooms) {
+        if (from <= low && high <= to) {
+            nodes[node].peak += rooms;
+            nodes[node].pending += rooms;
+            return;
+        }
+        if (high - low == BLOCK) {
+            for (int night = max(from, low); night < min(to, high); night++) nights[night] += rooms;
+            nodes[node].peak = *max_element(nights.begin() + low, nights.begin() + high) + nodes[node].pending;
+            return;
+        }
+        int mid = (low + high) / 2;
+        if (from < mid) add(2 * node, low, mid, from, to, rooms);
+        if (to > mid) add(2 * node + 1, mid, high, from, to, rooms);
+        nodes[node].peak = max(nodes[2 * node].peak, nodes[2 * node + 1].peak) + nodes[node].pending;
+    }
+
+    // Rooms booked each night, with every pending addition applied
+    void collect(size_t node, int low, int high, int carried, vector<int>& booked) const {
+        carried += nodes[node].pending;
+        if (high - low == BLOCK) {
+            for (int night = low; night < high; night++) booked[night] = nights[night] + carried;
+            return;
+        }
+        int mid = (low + high) / 2;
+        collect(2 * node, low, mid, carried, booked);
+        collect(2 * node + 1, mid, high, carried, booked);
+    }
+
+    // Re-centre the window on the booked nights plus [checkIn, checkOut),
+    // with as much room again to spare
+    void grow(int checkIn, int checkOut) {
+        vector<int> booked(span, 0);
+        if (span > 0) collect(1, 0, span, 0, booked);
+        int low = checkIn, high = checkOut;
+        for (int i = 0; i < span; i++) {
+            if (booked[i]) {
+                low = min(low, base + i);
+                high = max(high, base + i + 1);
+            }
+        }
+        int size = 64;
+        while (size < 2 * (high - low)) size *= 2;
+        int start = low - (size - (high - low)) / 2;
+
+        nights.assign(size, 0);
+        for (int i = 0; i < span; i++) {
+            if (booked[i]) nights[base + i - start] = booked[i];
+        }
+        size_t leaves = size_t(size / BLOCK);
+        vector<Node> rebuilt(2 * leaves, Node());
+        for (size_t leaf = 0; leaf < leaves; leaf++) {
+            rebuilt[leaves + leaf].peak = *max_element(nights.begin() + leaf * BLOCK, nights.begin() + (leaf + 1) * BLOCK);
+        }
+        for (size_t node = leaves - 1; node >= 1; node--) {
+            rebuilt[node].peak = max(rebuilt[2 * node].peak, rebuilt[2 * node + 1].peak);
+        }
+        nodes.swap(rebuilt);
+        base = start;
+        span = size;
+    }
+};
+
+// Every booking, plus a RoomCalendar per hotel with rooms booked. A stay
+// fits when the hotel's room count less its busiest night in the range
+// covers the rooms asked for, an O(log n) check whatever the stay's length.
+// Hotels with nothing booked have no calendar.
+class BookingLedger {
+public:
+    BookingLedger() : nextId(1) {}
+
+    // Most rooms already booked at the hotel on any night of the stay
+    int busiestNight(int hotelId, int checkIn, int checkOut) const {
+        CalendarMap::const_iterator it = calendars.find(hotelId);
+        return it == calendars.end() ? 0 : it->second.nights.busiest(checkIn, checkOut);
+    }
+
+    // Most rooms booked at the hotel on any night, past or future
+    int busiestNight(int hotelId) const {
+        CalendarMap::const_iterator it = calendars.find(hotelId);
+        return it == calendars.end() ? 0 : it->second.nights.peak();
+    }
+
+    // Nights on which the hotel has more than `rooms` booked
+    void overbookedNights(int hotelId, int rooms, vector<int>& nights) const {
+        nights.clear();
+        CalendarMap::const_iterator it = calendars.find(hotelId);
+        if (it != calendars.end()) it->second.nights.nightsAbove(rooms, nights);
+    }
+
+    int bookingCount(int hotelId) const {
+        CalendarMap::const_iterator it = calendars.find(hotelId);
+        return it == calendars.end() ? 0 : it->second.bookings;
+    }
+
+    const Booking* findBooking(int id) const {
+        BookingMap::const_iterator it = bookings.find(id);
+        return it == bookings.end() ? NULL : &it->second;
+    }
+
+    // Ids run on from the highest ever loaded or added
+    int nextBookingId() const { return nextId; }
+
+    void add(const Booking& booking) {
+        HotelCalendar& calendar = calendars[booking.hotelId];
+        calendar.nights.add(booking.checkIn, booking.checkOut, booking.rooms);
+        calendar.bookings++;
+        bookings[booking.id] = booking;
+        nextId = max(nextId, booking.id + 1);
+    }
+
+    bool remove(int id) {
+        BookingMap::iterator it = bookings.find(id);
+        if (it == bookings.end()) return false;
+        const Booking& booking = it->second;
+        CalendarMap::iterator calendar = calendars.find(booking.hotelId);
+        calendar->second.nights.add(booking.checkIn, booking.checkOut, -booking.rooms);
+        if (--calendar->second.bookings == 0) calendars.erase(calendar);
+        bookings.erase(it);
+        return true;
+    }
+
+    void clear() {
+        bookings.clear();
+        calendars.clear();
+        nextId = 1;
+    }
+
+    size_t size() const { return bookings.size(); }
+    size_t calendarCount() const { return calendars.size(); }
+
+private:
+    struct HotelCalendar {
+        RoomCalendar nights;
+        int bookings;
+
+        HotelCalendar() : bookings(0) {}
+    };
+    typedef unordered_map<int, Booking> BookingMap;
+    typedef unordered_map<int, HotelCalendar> CalendarMap;
+
+    BookingMap bookings;
+    CalendarMap calendars;
+    int nextId;
+
+    BookingLedger(const BookingLedger&);
+    BookingLedger& operator=(const BookingLedger&);
+};
+
+// A hotel with rooms free for a stay
+struct FreeHotel {
+    HotelNode* node;
+    int freeRooms; // Fewest free on any night of the stay
+};
+
+static int freeRoomsFor(const BookingLedger& ledger, const HotelNode* node, int checkIn, int checkOut) {
+    return max(0, node->roomNumber - ledger.busiestNight(node->id, checkIn, checkOut));
+}
+
+// Whether a room count still covers every night booked at the hotel. If not,
+// message names the nights that would be overbooked.
+static bool roomsCoverBookings(const BookingLedger& ledger, int hotelId, int rooms, string& message) {
+    int busiest = ledger.busiestNight(hotelId);
+    if (rooms >= busiest) return true;
+    vector<int> nights;
+    ledger.overbookedNights(hotelId, rooms, nights);
+    if (nights.empty()) return true; // Nothing booked; a negative count is refused by the callers
+    message = "Error: " + to_string(busiest) + " rooms are booked on the busiest night; " +
+              to_string(nights.size()) + " night(s) from " + formatDate(nights.front()) + " to " +
+              formatDate(nights.back()) + " would be overbooked.";
+    return false;
+}
+
+// Hotels with at least `rooms` free every night of [checkIn, checkOut), at
+// one location or anywhere when it is blank, largest first, at most limit.
+// The room index skips hotels too small to ever qualify, and each remaining
+// one is an O(log n) calendar check, so the cost follows the hotels that
+// could fit rather than the number of nights or bookings.
+static void findFreeHotels(const HotelLinkedList& hotels, const BookingLedger& ledger, const string& location,
+                           int rooms, int checkIn, int checkOut, size_t limit, vector<FreeHotel>& matches) {
+    matches.clear();
+    if (limit == 0) return;
+    hotels.forEachByRooms(location, max(1, rooms), numeric_limits<int>::max(), true, [&](HotelNode* node) {
+        int free = freeRoomsFor(ledger, node, checkIn, checkOut);
+        if (free >= rooms) matches.push_back(FreeHotel{node, free});
+        return matches.size() < limit;
+    });
+}
+
+
+// ---------------------------------------------------------------------------
+// Record schemas
+// Hotels and guests describe their table once, as a compile-time list of
+// columns naming the member each one stores. The table DDL, the statement
+// SQL, the binds and column reads, and the snapshot's binary record layout
+// are all generated from that list, so a new field is one more column here.
+// SQL text is built by the compiler, and the bind, read and codec code for
+// each column is picked by its member type at compile time, so nothing is
+// looked up or switched on per row.
+// ---------------------------------------------------------------------------
+
+template <typename Record, typename Type>
+struct SchemaColumn {
+    typedef Type ValueType;
+    const char* name;
+    const char* declaration; // SQL type and constraints
+    Type Record::*member;
+};
+
+template <typename Record, typename Type>
+constexpr SchemaColumn<Record, Type> schemaColumn(const char* name, const char* declaration, Type Record::*member) {
+    return SchemaColumn<Record, Type>{name, declaration, member};
+}
+
+// Specialized for each stored record; the first column is the primary key
+template <typename Record>
+struct RecordSchema;
+
+template <>
+struct RecordSchema<Hotel> {
+    static constexpr const char* table = "Hotels";
+    static constexpr auto columns = make_tuple(schemaColumn("id", "INTEGER PRIMARY KEY", &Hotel::id),
+                                               schemaColumn("name", "TEXT", &Hotel::name),
+                                               schemaColumn("services", "TEXT", &Hotel::services),
+                                               schemaColumn("location", "TEXT", &Hotel::location),
+                                               schemaColumn("roomNumber", "INTEGER", &Hotel::roomNumber),
+                                               schemaColumn("latitude", "REAL", &Hotel::latitude),
+                                               schemaColumn("longitude", "REAL", &Hotel::longitude));
+};
+
+template <>
+struct RecordSchema<Guest> {
+    static constexpr const char* table = "Guests";
+    static constexpr auto columns = make_tuple(schemaColumn("id", "INTEGER PRIMARY KEY", &Guest::id),
+                                               schemaColumn("name", "TEXT", &Guest::name),
+                                               schemaColumn("queuePosition", "INTEGER", &Guest::queuePosition));
+};
+
+template <typename Record>
+constexpr int schemaColumnCount() {
+    return int(tuple_size<typename remove_const<decltype(RecordSchema<Record>::columns)>::type>::value);
+}
+
+template <typename Record, typename Visit, size_t... I>
+constexpr void visitColumns(Visit& visit, index_sequence<I...>) {
+    (visit(get<I>(RecordSchema<Record>::columns), integral_constant<int, int(I)>()), ...);
+}
+
+// Call visit(column, index) for every column in order. The index is an
+// integral_constant, so code for each column can use it at compile time.
+template <typename Record, typename Visit>
+constexpr void forEachColumn(Visit visit) {
+    visitColumns<Record>(visit, make_index_sequence<size_t(schemaColumnCount<Record>())>());
+}
+
+template <typename Column>
+using ColumnType = typename decay<Column>::type::ValueType;
+
+// Where a member is stored in the column list, and so in a row read by
+// selectSql(); -1 if it is not stored
+template <typename Record, typename Type>
+constexpr int schemaColumnIndex(Type Record::*member) {
+    int found = -1;
+    forEachColumn<Record>([&](const auto& column, auto index) {
+        if constexpr (is_same<ColumnType<decltype(column)>, Type>::value) {
+            if (column.member == member) found = index;
+        }
+    });
+    return found;
+}
+
+// SQL text assembled by the compiler; outgrowing the buffer is a compile error
+struct SchemaSql {
+    static const size_t CAPACITY = 512;
+    char text[CAPACITY];
+    size_t length;
+
+    constexpr SchemaSql() : text(), length(0) {}
+
+    constexpr SchemaSql& operator<<(const char* part) {
+        while (*part) text[length++] = *part++;
+        text[length] = '\0';
+        return *this;
+    }
+
+    constexpr const char* c_str() const { return text; }
+};
+
+enum ColumnListStyle {
+    COLUMN_DECLARATIONS, // name TYPE, ...
+    COLUMN_NAMES,        // name, ...
+    COLUMN_PLACEHOLDERS, // ?, ...
+    COLUMN_ASSIGNMENTS,  // name=?, ... without the key
+    COLUMN_EXCLUDED      // name=excluded.name, ... without the key
+};
+
+template <typename Record>
+constexpr void appendColumns(SchemaSql& sql, ColumnListStyle style) {
+    bool first = true;
+    forEachColumn<Record>([&](const auto& column, auto index) {
+        if (index == 0 && (style == COLUMN_ASSIGNMENTS || style == COLUMN_EXCLUDED)) return;
+        if (!first) sql << ", ";
+        first = false;
+        switch (style) {
+            case COLUMN_DECLARATIONS: sql << column.name << " " << column.declaration; break;
+            case COLUMN_NAMES: sql << column.name; break;
+            case COLUMN_PLACEHOLDERS: sql << "?"; break;
+            case COLUMN_ASSIGNMENTS: sql << column.name << "=?"; break;
+            case COLUMN_EXCLUDED: sql << column.name << "=excluded." << column.name; break;
+        }
+    });
+}
+
+template <typename Record>
+constexpr const char* schemaKey() {
+    return get<0>(RecordSchema<Record>::columns).name;
+}
+
+template <typename Record>
+constexpr SchemaSql createTableSql() {
+    SchemaSql sql;
+    sql << "CREATE TABLE IF NOT EXISTS " << RecordSchema<Record>::table << " (";
+    appendColumns<Record>(sql, COLUMN_DECLARATIONS);
+    sql << ");";
+    return sql;
+}
+
+// Every column in order, as bindRecord() binds them; upsert replaces a row with the same key
+template <typename Record>
+constexpr SchemaSql insertSql(bool upsert) {
+    SchemaSql sql;
+    sql << "INSERT INTO " << RecordSchema<Record>::table << " (";
+    appendColumns<Record>(sql, COLUMN_NAMES);
+    sql << ") VALUES (";
+    appendColumns<Record>(sql, COLUMN_PLACEHOLDERS);
+    sql << ")";
+    if (upsert) {
+        sql << " ON CONFLICT(" << schemaKey<Record>() << ") DO UPDATE SET ";
+        appendColumns<Record>(sql, COLUMN_EXCLUDED);
+    }
+    sql << ";";
+    return sql;
+}
+
+// The other columns, then the key, as bindUpdate() binds them
+template <typename Record>
+constexpr SchemaSql updateSql() {
+    SchemaSql sql;
+    sql << "UPDATE " << RecordSchema<Record>::table << " SET ";
+    appendColumns<Record>(sql, COLUMN_ASSIGNMENTS);
+    sql << " WHERE " << schemaKey<Record>() << "=?;";
+    return sql;
+}
+
+template <typename Record>
+constexpr SchemaSql deleteSql() {
+    SchemaSql sql;
+    sql << "DELETE FROM " << RecordSchema<Record>::table << " WHERE " << schemaKey<Record>() << "=?;";
+    return sql;
+}
+
+// Every column in order, as readRecord() reads them, then the rest of the query
+template <typename Record>
+constexpr SchemaSql selectSql(const char* rest) {
+    SchemaSql sql;
+    sql << "SELECT ";
+    appendColumns<Record>(sql, COLUMN_NAMES);
+    sql << " FROM " << RecordSchema<Record>::table << rest;
+    return sql;
+}
+
+// Per-type binds and reads. REAL columns hold NaN as NULL, which is how a
+// hotel without coordinates is stored.
+static inline void bindValue(sqlite3_stmt* stmt, int index, int value) {
+    sqlite3_bind_int(stmt, index, value);
+}
+
+static inline void bindValue(sqlite3_stmt* stmt, int index, const string& value) {
+    sqlite3_bind_text(stmt, index, value.data(), int(value.size()), SQLITE_STATIC);
+}
+
+static inline void bindValue(sqlite3_stmt* stmt, int index, double value) {
+    if (std::isnan(value)) sqlite3_bind_null(stmt, index);
+    else sqlite3_bind_double(stmt, index, value);
+}
+
+// A text column in place, valid until the statement steps again. Lengths
+// come from SQLite, so nothing is scanned for the terminator.
+static string_view columnText(sqlite3_stmt* stmt, int column) {
+    const char* text = (const char*)sqlite3_column_text(stmt, column);
+    return text ? string_view(text, size_t(sqlite3_column_bytes(stmt, column))) : string_view();
+}
+
+static double columnReal(sqlite3_stmt* stmt, int column) {
+    return sqlite3_column_type(stmt, column) == SQLITE_NULL ? NAN : sqlite3_column_double(stmt, column);
+}
+
+static inline void readValue(sqlite3_stmt* stmt, int column, int& value) {
+    value = sqlite3_column_int(stmt, column);
+}
+
+static inline void readValue(sqlite3_stmt* stmt, int column, string& value) {
+    value = columnText(stmt, column);
+}
+
+static inline void readValue(sqlite3_stmt* stmt, int column, double& value) {
+    value = columnReal(stmt, column);
+}
+
+// Bind every column from ?1, for insertSql()
+template <typename Record>
+void bindRecord(sqlite3_stmt* stmt, const Record& record) {
+    forEachColumn<Record>([&](const auto& column, auto index) { bindValue(stmt, index + 1, record.*column.member); });
+}
+
+// Bind the other columns from ?1 and the key last, for updateSql()
+template <typename Record>
+void bindUpdate(sqlite3_stmt* stmt, const Record& record) {
+    forEachColumn<Record>([&](const auto& column, auto index) {
+        bindValue(stmt, index == 0 ? schemaColumnCount<Record>() : int(index), record.*column.member);
+    });
+}
+
+// Read a row selected by selectSql()
+template <typename Record>
+void readRecord(sqlite3_stmt* stmt, Record& record) {
+    forEachColumn<Record>([&](const auto& column, auto index) { readValue(stmt, index, record.*column.member); });
+}
+
+// Binary record layout, as the snapshot stores records: a fixed part holding
+// the int32 columns, a uint32 byte length for each text column and the
+// doubles, each group in column order, then the text bytes in column order.
+// No tags or padding; host byte order. Only these three types can be stored.
+template <typename Type>
+struct CodecField;
+
+template <>
+struct CodecField<int> {
+    static const int group = 0;
+    static const size_t width = 4;
+};
+
+template <>
+struct CodecField<string> {
+    static const int group = 1; // The length; the bytes follow the fixed part
+    static const size_t width = 4;
+};
+
+template <>
+struct CodecField<double> {
+    static const int group = 2;
+    static const size_t width = 8;
+};
+
+static_assert(sizeof(int) == 4 && sizeof(double) == 8, "the record layout assumes 32-bit int and 64-bit double");
+
+template <typename Record>
+constexpr size_t codecFixedBytes() {
+    size_t bytes = 0;
+    forEachColumn<Record>([&](const auto& column, auto) { bytes += CodecField<ColumnType<decltype(column)>>::width; });
+    return bytes;
+}
+
+// Where a column sits in the fixed part
+template <typename Record>
+constexpr size_t codecOffset(int target) {
+    int targetGroup = 0;
+    forEachColumn<Record>([&](const auto& column, auto index) {
+        if (index == target) targetGroup = CodecField<ColumnType<decltype(column)>>::group;
+    });
+    size_t offset = 0;
+    forEachColumn<Record>([&](const auto& column, auto index) {
+        typedef CodecField<ColumnType<decltype(column)>> Field;
+        if (Field::group < targetGroup || (Field::group == targetGroup && index < target)) offset += Field::width;
+    });
+    return offset;
+}
+
+// Append a record's encoding to out
+template <typename Record>
+void encodeRecord(const Record& record, string& out) {
+    size_t start = out.size();
+    out.resize(start + codecFixedBytes<Record>());
+    forEachColumn<Record>([&](const auto& column, auto index) {
+        typedef ColumnType<decltype(column)> Type;
+        constexpr size_t offset = codecOffset<Record>(decltype(index)::value);
+        char* field = &out[start + offset];
+        const Type& value = record.*column.member;
+        if constexpr (is_same<Type, string>::value) {
+            uint32_t length = uint32_t(value.size());
+            memcpy(field, &length, sizeof(length));
+        } else {
+            memcpy(field, &value, sizeof(value));
+        }
+    });
+    forEachColumn<Record>([&](const auto& column, auto) {
+        if constexpr (is_same<ColumnType<decltype(column)>, string>::value) out += record.*column.member;
+    });
+}
+
+// Decode the record at cursor and step past it; false if the bytes run out
+template <typename Record>
+bool decodeRecord(const char*& cursor, const char* end, Record& record) {
+    constexpr size_t fixedBytes = codecFixedBytes<Record>();
+    if (size_t(end - cursor) < fixedBytes) return false;
+    const char* fixed = cursor;
+    cursor += fixedBytes;
+    bool ok = true;
+    forEachColumn<Record>([&](const auto& column, auto index) {
+        typedef ColumnType<decltype(column)> Type;
+        constexpr size_t offset = codecOffset<Record>(decltype(index)::value);
+        const char* field = fixed + offset;
+        Type& value = record.*column.member;
+        if constexpr (is_same<Type, string>::value) {
+            uint32_t length;
+            memcpy(&length, field, sizeof(length));
+            if (!ok || size_t(end - cursor) < length) {
+                ok = false;
+                return;
+            }
+            value.assign(cursor, length);
+            cursor += length;
+        } else {
+            memcpy(&value, field, sizeof(value));
+        }
+    });
+    return ok;
+}
+
+// Generated statement text
+static constexpr SchemaSql INSERT_HOTEL_SQL = insertSql<Hotel>(false);
+static constexpr SchemaSql UPSERT_HOTEL_SQL = insertSql<Hotel>(true);
+static constexpr SchemaSql UPDATE_HOTEL_SQL = updateSql<Hotel>();
+static constexpr SchemaSql DELETE_HOTEL_SQL = deleteSql<Hotel>();
+static constexpr SchemaSql SELECT_HOTEL_SQL = selectSql<Hotel>(" WHERE id=?;");
+static constexpr SchemaSql LOAD_HOTELS_SQL = selectSql<Hotel>(";");
+static constexpr SchemaSql HOTEL_PAGE_NEXT_SQL = selectSql<Hotel>(" WHERE id > ? ORDER BY id LIMIT ?;");
+static constexpr SchemaSql HOTEL_PAGE_PREV_SQL = selectSql<Hotel>(" WHERE id < ? ORDER BY id DESC LIMIT ?;");
+static constexpr SchemaSql INSERT_GUEST_SQL = insertSql<Guest>(false);
+static constexpr SchemaSql UPSERT_GUEST_SQL = insertSql<Guest>(true);
+static constexpr SchemaSql DELETE_GUEST_SQL = deleteSql<Guest>();
+static constexpr SchemaSql SELECT_GUEST_SQL = selectSql<Guest>(" WHERE id=?;");
+static constexpr SchemaSql LOAD_GUESTS_SQL = selectSql<Guest>(" ORDER BY queuePosition, id;");
+static constexpr SchemaSql GUEST_PAGE_NEXT_SQL =
+    selectSql<Guest>(" WHERE (queuePosition, id) > (?, ?) ORDER BY queuePosition, id LIMIT ?;");
+static constexpr SchemaSql GUEST_PAGE_PREV_SQL =
+    selectSql<Guest>(" WHERE (queuePosition, id) < (?, ?) ORDER BY queuePosition DESC, id DESC LIMIT ?;");
+
+
+// Statements prepared once per connection and reused.
+// acquire() resets the statement and clears old bindings before handing it
+// out, and counts executions so the reuse can be checked under load.
+enum StatementId {
+    STMT_INSERT_HOTEL,
+    STMT_UPDATE_HOTEL,
+    STMT_DELETE_HOTEL,
+    STMT_INSERT_GUEST,
+    STMT_DELETE_GUEST,
+    STMT_HOTEL_PAGE_NEXT,
+    STMT_HOTEL_PAGE_PREV,
+    STMT_GUEST_PAGE_NEXT,
+    STMT_GUEST_PAGE_PREV,
+    STMT_SELECT_HOTEL,
+    STMT_SELECT_GUEST,
+    STMT_UPSERT_HOTEL,
+    STMT_UPSERT_GUEST,
+    STMT_INSERT_BOOKING,
+    STMT_DELETE_BOOKING,
+    STMT_COUNT
+};
+
+class StatementCache {
+public:
+    StatementCache() : handle(NULL) {
+        for (int i = 0; i < STMT_COUNT; i++) {
+            statements[i] = NULL;
+            executions[i] = 0;
+        }
+    }
+
+    bool prepareAll(sqlite3* connection) {
+        handle = connection;
+        for (int i = 0; i < STMT_COUNT; i++) {
+            if (sqlite3_prepare_v3(handle, definitions[i].sql, -1, SQLITE_PREPARE_PERSISTENT,
+                                   &statements[i], NULL) != SQLITE_OK) {
+                cerr << "Error preparing " << definitions[i].name << " statement: " << sqlite3_errmsg(handle) << endl;
+                return false;
+            }
+            executions[i] = 0;
+        }
+        return true;
+    }
+
+    sqlite3_stmt* acquire(StatementId id) {
+        sqlite3_stmt* stmt = statements[id];
+        if (stmt) {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            executions[id]++;
+        }
+        return stmt;
+    }
+
+    // Reset after stepping so the statement holds no locks or bound buffers
+    void release(sqlite3_stmt* stmt) {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+
+    void finalizeAll() {
+        for (int i = 0; i < STMT_COUNT; i++) {
+            sqlite3_finalize(statements[i]);
+            statements[i] = NULL;
+        }
+        handle = NULL;
+    }
+
+    unsigned long long executionCount(StatementId id) const { return executions[id]; }
+
+    void printStats() const {
+        cout << "\n--- Statement Cache ---\n";
+        for (int i = 0; i < STMT_COUNT; i++) {
+            cout << left << setw(14) << definitions[i].name << right << setw(10) << executions[i]
+                 << " executions, prepared once\n";
+        }
+    }
+
+private:
+    struct Definition {
+        const char* name;
+        const char* sql;
+    };
+    static const Definition definitions[STMT_COUNT];
+
+    sqlite3* handle;
+    sqlite3_stmt* statements[STMT_COUNT];
+    unsigned long long executions[STMT_COUNT];
+
+    StatementCache(const StatementCache&);
+    StatementCache& operator=(const StatementCache&);
+};
+
+const StatementCache::Definition StatementCache::definitions[STMT_COUNT] = {
+    {"insert hotel", INSERT_HOTEL_SQL.c_str()},
+    {"update hotel", UPDATE_HOTEL_SQL.c_str()},
+    {"delete hotel", DELETE_HOTEL_SQL.c_str()},
+    {"insert guest", INSERT_GUEST_SQL.c_str()},
+    {"delete guest", DELETE_GUEST_SQL.c_str()},
+    {"hotel page >", HOTEL_PAGE_NEXT_SQL.c_str()},
+    {"hotel page <", HOTEL_PAGE_PREV_SQL.c_str()},
+    {"guest page >", GUEST_PAGE_NEXT_SQL.c_str()},
+    {"guest page <", GUEST_PAGE_PREV_SQL.c_str()},
+    {"select hotel", SELECT_HOTEL_SQL.c_str()},
+    {"select guest", SELECT_GUEST_SQL.c_str()},
+    {"upsert hotel", UPSERT_HOTEL_SQL.c_str()},
+    {"upsert guest", UPSERT_GUEST_SQL.c_str()},
+    {"insert booking", "INSERT INTO Bookings (id, hotelId, guestName, checkIn, checkOut, rooms) "
+                       "VALUES (?, ?, ?, ?, ?, ?);"},
+    {"delete booking", "DELETE FROM Bookings WHERE id=?;"},
+};
+
+// Log-linear latency histogram in the style of HdrHistogram. Each power of
+// two is split into 16 sub-buckets, so any recorded value is known to within
+// 1/16 (about 6%) across the whole nanosecond-to-hours range, in a fixed
+// 976-bucket array. Recording is three relaxed atomic adds and is safe from
+// any thread.
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 4;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    LatencyHistogram() { clear(); }
+
+    void record(uint64_t nanos) {
+        buckets[indexOf(nanos)].fetch_add(1, memory_order_relaxed);
+        total.fetch_add(1, memory_order_relaxed);
+        sum.fetch_add(nanos, memory_order_relaxed);
+        uint64_t seen = largest.load(memory_order_relaxed);
+        while (nanos > seen && !largest.compare_exchange_weak(seen, nanos, memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return total.load(memory_order_relaxed); }
+    uint64_t sumNanos() const { return sum.load(memory_order_relaxed); }
+    uint64_t maxNanos() const { return largest.load(memory_order_relaxed); }
+
+    // Value at the given quantile (0..1), as the midpoint of its bucket
+    uint64_t quantile(double fraction) const {
+        uint64_t recorded = count();
+        if (recorded == 0) return 0;
+        uint64_t target = max<uint64_t>(1, uint64_t(ceil(fraction * double(recorded)))); // Nearest rank
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i].load(memory_order_relaxed);
+            if (seen >= target) return min(maxNanos(), (lowerBound(i) + upperBound(i)) / 2);
+        }
+        return maxNanos();
+    }
+
+    void clear() {
+        for (int i = 0; i < BUCKETS; i++) buckets[i].store(0, memory_order_relaxed);
+        total.store(0, memory_order_relaxed);
+        sum.store(0, memory_order_relaxed);
+        largest.store(0, memory_order_relaxed);
+    }
+
+    static int indexOf(uint64_t value) {
+        if (value < uint64_t(SUB_COUNT)) return int(value);
+#if defined(__GNUC__)
+        int msb = 63 - __builtin_clzll(value);
+#else
+        int msb = 0;
+        while (value >> (msb + 1)) msb++;
+#endif
+        int shift = msb - SUB_BITS;
+        return (shift + 1) * SUB_COUNT + int((value >> shift) & (SUB_COUNT - 1));
+    }
+
+    static uint64_t lowerBound(int index) {
+        if (index < SUB_COUNT) return uint64_t(index);
+        int shift = index / SUB_COUNT - 1;
+        return uint64_t(SUB_COUNT + index % SUB_COUNT) << shift;
+    }
+
+    static uint64_t upperBound(int index) {
+        if (index < SUB_COUNT) return uint64_t(index);
+        return lowerBound(index) + (uint64_t(1) << (index / SUB_COUNT - 1)) - 1;
+    }
+
+private:
+    atomic<uint64_t> buckets[BUCKETS];
+    atomic<uint64_t> total;
+    atomic<uint64_t> sum;
+    atomic<uint64_t> largest;
+
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+};
+
+// Everything that is timed: the public operations, and each place SQLite is
+// called, so a slow desk can be traced to the database, the in-memory store
+// or the console.
+enum MetricId {
+    MET_OP_ADD_HOTEL,
+    MET_OP_UPDATE_HOTEL,
+    MET_OP_DELETE_HOTEL,
+    MET_OP_ENQUEUE_GUEST,
+    MET_OP_SERVE_GUEST,
+    MET_OP_CANCEL_GUEST,
+    MET_OP_ADD_STOP,
+    MET_OP_FIND_HOTEL,
+    MET_OP_LIST_HOTELS,
+    MET_OP_QUEUE_POSITION,
+    MET_OP_SEARCH_SERVICES,
+    MET_OP_SEARCH_NAMES,
+    MET_OP_FIND_BY_ROOMS,
+    MET_OP_NEAREST_HOTELS,
+    MET_OP_HOTELS_WITHIN,
+    MET_OP_REFRESH,
+    MET_OP_BOOK_ROOMS,
+    MET_OP_CANCEL_BOOKING,
+    MET_OP_FREE_ROOMS,
+    MET_OP_REPORT,
+    MET_OP_CONSOLE_WRITE,
+    MET_SQL_INSERT_HOTEL,
+    MET_SQL_UPDATE_HOTEL,
+    MET_SQL_DELETE_HOTEL,
+    MET_SQL_INSERT_GUEST,
+    MET_SQL_DELETE_GUEST,
+    MET_SQL_PAGE_QUERY,
+    MET_SQL_LOAD_HOTELS,
+    MET_SQL_LOAD_GUESTS,
+    MET_SQL_INSERT_BOOKING,
+    MET_SQL_DELETE_BOOKING,
+    MET_SQL_LOAD_BOOKINGS,
+    MET_SQL_EXEC,
+    MET_SQL_IMPORT_BATCH,
+    MET_SQL_REPLAY_CHANGES,
+    MET_SQL_COMPACT_CHANGES,
+    MET_SQL_WRITE_BEHIND_FLUSH,
+    MET_SNAPSHOT_LOAD,
+    MET_SNAPSHOT_WRITE,
+    MET_COUNT
+};
+
+class MetricsRegistry {
+public:
+    MetricsRegistry() : enabled(true) {
+        for (int i = 0; i < MET_COUNT; i++) errors[i].store(0, memory_order_relaxed);
+    }
+
+    bool isEnabled() const { return enabled.load(memory_order_relaxed); }
+    void setEnabled(bool on) { enabled.store(on, memory_order_relaxed); }
+
+    void record(MetricId id, uint64_t nanos, bool ok) {
+        histograms[id].record(nanos);
+        if (!ok) errors[id].fetch_add(1, memory_order_relaxed);
+    }
+
+    const LatencyHistogram& histogram(MetricId id) const { return histograms[id]; }
+    uint64_t errorCount(MetricId id) const { return errors[id].load(memory_order_relaxed); }
+
+    void printStats(ostream& out) const {
+        out << "\n--- Latency (microseconds) ---\n"
+            << left << setw(24) << "metric" << right << setw(10) << "count" << setw(8) << "errors" << setw(11) << "mean"
+            << setw(11) << "p50" << setw(11) << "p99" << setw(11) << "p99.9" << setw(11) << "max" << "\n";
+        for (int i = 0; i < MET_COUNT; i++) {
+            const LatencyHistogram& h = histograms[i];
+            if (h.count() == 0) continue;
+            out << left << setw(24) << string(definitions[i].family) + "/" + definitions[i].name << right
+                << setw(10) << h.count() << setw(8) << errorCount(MetricId(i)) << fixed << setprecision(1)
+                << setw(11) << h.sumNanos() / 1e3 / h.count() << setw(11) << h.quantile(0.50) / 1e3
+                << setw(11) << h.quantile(0.99) / 1e3 << setw(11) << h.quantile(0.999) / 1e3
+                << setw(11) << h.maxNanos() / 1e3 << "\n";
+        }
+    }
+
+    // Prometheus text exposition format: one summary per family with the
+    // operation as a label, plus error counters
+    void writePrometheus(ostream& out) const {
+        const char* families[] = {"operation", "sqlite", "snapshot"};
+        const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+        for (int f = 0; f < 3; f++) {
+            string metric = string("cms_") + families[f] + "_duration_seconds";
+            out << "# HELP " << metric << " Latency of " << families[f] << " calls.\n"
+                << "# TYPE " << metric << " summary\n";
+            for (int i = 0; i < MET_COUNT; i++) {
+                if (string(definitions[i].family) != families[f]) continue;
+                const LatencyHistogram& h = histograms[i];
+                string label = string("{name=\"") + definitions[i].name + "\"";
+                for (int q = 0; q < 4; q++) {
+                    out << metric << label << ",quantile=\"" << quantiles[q] << "\"} " << h.quantile(quantiles[q]) / 1e9 << "\n";
+                }
+                out << metric << "_sum" << label << "} " << h.sumNanos() / 1e9 << "\n"
+                    << metric << "_count" << label << "} " << h.count() << "\n";
+            }
+            string errorMetric = string("cms_") + families[f] + "_errors_total";
+            out << "# HELP " << errorMetric << " Failed " << families[f] << " calls.\n"
+                << "# TYPE " << errorMetric << " counter\n";
+            for (int i = 0; i < MET_COUNT; i++) {
+                if (string(definitions[i].family) != families[f]) continue;
+                out << errorMetric << "{name=\"" << definitions[i].name << "\"} " << errorCount(MetricId(i)) << "\n";
+            }
+        }
+    }
+
+private:
+    struct Definition {
+        const char* family;
+        const char* name;
+    };
+    static const Definition definitions[MET_COUNT];
+
+    LatencyHistogram histograms[MET_COUNT];
+    atomic<uint64_t> errors[MET_COUNT];
+    atomic<bool> enabled;
+};
+
+const MetricsRegistry::Definition MetricsRegistry::definitions[MET_COUNT] = {
+    {"operation", "add_hotel"},
+    {"operation", "update_hotel"},
+    {"operation", "delete_hotel"},
+    {"operation", "enqueue_guest"},
+    {"operation", "serve_guest"},
+    {"operation", "cancel_guest"},
+    {"operation", "add_stop"},
+    {"operation", "find_hotel"},
+    {"operation", "list_hotels"},
+    {"operation", "queue_position"},
+    {"operation", "search_services"},
+    {"operation", "search_names"},
+    {"operation", "find_by_rooms"},
+    {"operation", "nearest_hotels"},
+    {"operation", "hotels_within"},
+    {"operation", "refresh"},
+    {"operation", "book_rooms"},
+    {"operation", "cancel_booking"},
+    {"operation", "free_rooms"},
+    {"operation", "report"},
+    {"operation", "console_write"},
+    {"sqlite", "insert_hotel"},
+    {"sqlite", "update_hotel"},
+    {"sqlite", "delete_hotel"},
+    {"sqlite", "insert_guest"},
+    {"sqlite", "delete_guest"},
+    {"sqlite", "page_query"},
+    {"sqlite", "load_hotels"},
+    {"sqlite", "load_guests"},
+    {"sqlite", "insert_booking"},
+    {"sqlite", "delete_booking"},
+    {"sqlite", "load_bookings"},
+    {"sqlite", "exec"},
+    {"sqlite", "import_batch"},
+    {"sqlite", "replay_changes"},
+    {"sqlite", "compact_changes"},
+    {"sqlite", "write_behind_flush"},
+    {"snapshot", "load"},
+    {"snapshot", "write"},
+};
+
+MetricsRegistry metrics;
+
+// Times the enclosing scope into one metric; call fail() on error paths.
+// Costs two clock reads when metrics are on and one flag test when off.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(MetricId id) : id(id), ok(true), running(metrics.isEnabled()) {
+        if (running) start = chrono::steady_clock::now();
+    }
+    ~ScopedTimer() {
+        if (running) {
+            metrics.record(id, uint64_t(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()), ok);
+        }
+    }
+    void fail() { ok = false; }
+
+private:
+    MetricId id;
+    bool ok;
+    bool running;
+    chrono::steady_clock::time_point start;
+
+    ScopedTimer(const ScopedTimer&);
+    ScopedTimer& operator=(const ScopedTimer&);
+};
+
+// sqlite3_step timed into a metric; anything but a row or done counts as an error
+static int timedStep(sqlite3_stmt* stmt, MetricId id) {
+    ScopedTimer timer(id);
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) timer.fail();
+    return rc;
+}
+
+// How writes reach the disk. The defaults match plain SQLite: every change
+// commits on its own with the journal mode and sync level already set in
+// the database file.
+struct DurabilityOptions {
+    bool writeBehind;    // Queue changes for a background writer
+    int flushRows;       // Commit once this many distinct rows are pending...
+    int flushMillis;     // ...or this long after the oldest pending change
+    string journalMode;  // PRAGMA journal_mode, e.g. WAL; empty keeps the file's
+    string synchronous;  // PRAGMA synchronous: OFF, NORMAL, FULL or EXTRA; empty keeps the default
+    int shards;          // Hotel shard files; 0 keeps hotels in the main file
+
+    DurabilityOptions() : writeBehind(false), flushRows(512), flushMillis(50), shards(0) {}
+};
+
+// Apply the journal mode and sync level to one connection
+static bool applyDurability(sqlite3* connection, const DurabilityOptions& options) {
+    sqlite3_busy_timeout(connection, 5000); // The writer thread and readers may briefly contend
+    string pragmas;
+    if (!options.journalMode.empty()) pragmas += "PRAGMA journal_mode=" + options.journalMode + ";";
+    if (!options.synchronous.empty()) pragmas += "PRAGMA synchronous=" + options.synchronous + ";";
+    if (pragmas.empty()) return true;
+    char* errMsg;
+    if (sqlite3_exec(connection, pragmas.c_str(), NULL, NULL, &errMsg) != SQLITE_OK) {
+        cerr << "Error setting durability options: " << errMsg << endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+// Write-behind persistence. Callers update memory and hand the row here;
+// changes to the same (table, id) coalesce so only the latest state is
+// written, and a background thread commits whatever is pending in one
+// transaction once flushRows rows are waiting or flushMillis have passed.
+// The writer has its own connection and prepared statements, so it never
+// shares a transaction with the foreground connection.
+class WriteBehindWriter {
+public:
+    WriteBehindWriter()
+        : connection(NULL), running(false), stopping(false), flushRequested(false), failing(false), queuedSeq(0),
+          committedSeq(0), failedCommits(0), droppedRows(0), flushRows(512), flushMillis(50), committedRows(0),
+          commits(0) {}
+    ~WriteBehindWriter() { stop(); }
+
+    bool start(const char* path, const DurabilityOptions& options) {
+        if (sqlite3_open(path, &connection) != SQLITE_OK || !applyDurability(connection, options) ||
+            !writerStatements.prepareAll(connection)) {
+            cerr << "Error starting write-behind writer: " << sqlite3_errmsg(connection) << endl;
+            sqlite3_close(connection);
+            connection = NULL;
+            return false;
+        }
+        flushRows = max(1, options.flushRows);
+        flushMillis = max(1, options.flushMillis);
+        committedRows = 0;
+        commits = 0;
+        failing = false;
+        failedCommits = 0;
+        droppedRows = 0;
+        stopping = false;
+        running = true;
+        worker = thread(&WriteBehindWriter::run, this);
+        return true;
+    }
+
+    // Commit everything still pending, then shut the writer down. False if
+    // some changes could not be committed and were given up.
+    bool stop() {
+        if (!running) return droppedRows == 0;
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+        writerStatements.finalizeAll();
+        sqlite3_close(connection);
+        connection = NULL;
+        running = false;
+        return droppedRows == 0;
+    }
+
+    bool active() const { return running; }
+
+    void saveHotel(const Hotel& hotel) {
+        PendingWrite write;
+        write.table = TABLE_HOTELS;
+        write.remove = false;
+        write.hotel = hotel;
+        queue(hotel.id, write);
+    }
+
+    void removeHotel(int id) {
+        PendingWrite write;
+        write.table = TABLE_HOTELS;
+        write.remove = true;
+        write.hotel.id = id;
+        queue(id, write);
+    }
+
+    void saveGuest(const Guest& guest) {
+        PendingWrite write;
+        write.table = TABLE_GUESTS;
+        write.remove = false;
+        write.guest = guest;
+        queue(guest.id, write);
+    }
+
+    void removeGuest(int id) {
+        PendingWrite write;
+        write.table = TABLE_GUESTS;
+        write.remove = true;
+        write.guest.id = id;
+        queue(id, write);
+    }
+
+    // Block until every change queued before the call is committed. False if
+    // a commit fails first: the changes stay queued and are retried, but
+    // reads of SQLite would not see them yet.
+    bool flush() {
+        if (!running) return droppedRows == 0;
+        unique_lock<mutex> guard(lock);
+        unsigned long long target = queuedSeq;
+        if (committedSeq >= target) return true;
+        unsigned long long failures = failedCommits;
+        flushRequested = true;
+        wake.notify_all();
+        flushed.wait(guard, [this, target, failures] { return committedSeq >= target || failedCommits > failures; });
+        return committedSeq >= target;
+    }
+
+    size_t pendingCount() {
+        lock_guard<mutex> guard(lock);
+        return pending.size();
+    }
+
+    unsigned long long rowsCommitted() const { return committedRows; }
+    unsigned long long commitCount() const { return commits; }
+    unsigned long long rowsDropped() const { return droppedRows; }
+
+private:
+    enum { MAX_RETRY_MILLIS = 2000, STOP_ATTEMPTS = 5 };
+
+    enum { TABLE_HOTELS, TABLE_GUESTS };
+
+    struct PendingWrite {
+        int table;
+        bool remove; // Delete the row; otherwise insert or replace it
+        Hotel hotel;
+        Guest guest;
+    };
+
+    typedef unordered_map<long long, PendingWrite> PendingMap; // (table << 32 | id) -> latest state
+
+    sqlite3* connection;
+    StatementCache writerStatements;
+    thread worker;
+    mutex lock; // Guards everything below
+    condition_variable wake;
+    condition_variable flushed;
+    PendingMap pending;
+    chrono::steady_clock::time_point oldestPending;
+    bool running;
+    bool stopping;
+    bool flushRequested;
+    bool failing;                     // The last commit failed; its rows are pending again
+    unsigned long long queuedSeq;     // Changes accepted so far
+    unsigned long long committedSeq;  // Changes known to be on disk
+    unsigned long long failedCommits; // Commit attempts that failed
+    atomic<unsigned long long> droppedRows; // Given up at shutdown; never cleared until restarted
+    int flushRows;
+    int flushMillis;
+    atomic<unsigned long long> committedRows;
+    atomic<unsigned long long> commits;
+
+    void queue(int id, const PendingWrite& write) {
+        bool full;
+        {
+            lock_guard<mutex> guard(lock);
+            if (pending.empty()) oldestPending = chrono::steady_clock::now();
+            pending[(long long)write.table << 32 | uint32_t(id)] = write;
+            queuedSeq++;
+            full = int(pending.size()) >= flushRows;
+        }
+        if (full) wake.notify_one();
+    }
+
+    // A failed batch goes back into `pending` under any newer change to the
+    // same row and is retried, backing off up to MAX_RETRY_MILLIS between
+    // attempts. committedSeq only moves on a successful commit, so nothing
+    // is reported flushed that is not on disk. At shutdown the writer gives
+    // up after STOP_ATTEMPTS more failures and counts what it dropped.
+    void run() {
+        unique_lock<mutex> guard(lock);
+        int retryMillis = flushMillis;
+        int stopFailures = 0;
+        while (true) {
+            if (pending.empty()) {
+                if (stopping) break;
+                wake.wait(guard);
+                continue;
+            }
+            chrono::steady_clock::time_point due =
+                oldestPending + chrono::milliseconds(failing ? retryMillis : flushMillis);
+            bool ready = failing ? flushRequested : stopping || flushRequested || int(pending.size()) >= flushRows;
+            if (!ready && chrono::steady_clock::now() < due) {
+                wake.wait_until(guard, due);
+                continue;
+            }
+
+            PendingMap batch;
+            batch.swap(pending);
+            unsigned long long seq = queuedSeq;
+            flushRequested = false;
+            guard.unlock();
+            bool ok = commit(batch);
+            guard.lock();
+            if (ok) {
+                committedSeq = seq;
+                failing = false;
+                retryMillis = flushMillis;
+            } else {
+                for (PendingMap::iterator it = batch.begin(); it != batch.end(); ++it) pending.insert(*it);
+                oldestPending = chrono::steady_clock::now();
+                failing = true;
+                failedCommits++;
+                retryMillis = min(retryMillis * 2, int(MAX_RETRY_MILLIS));
+                if (stopping && ++stopFailures >= STOP_ATTEMPTS) {
+                    droppedRows += pending.size();
+                    cerr << "Error: write-behind gave up on " << pending.size() << " change(s) at shutdown after "
+                         << stopFailures << " failed commits" << endl;
+                    pending.clear();
+                    committedSeq = queuedSeq;
+                }
+            }
+            flushed.notify_all();
+        }
+    }
+
+    bool commit(const PendingMap& batch) {
+        ScopedTimer timer(MET_SQL_WRITE_BEHIND_FLUSH);
+        char* errMsg;
+        if (sqlite3_exec(connection, "BEGIN IMMEDIATE;", NULL, NULL, &errMsg) != SQLITE_OK) {
+            cerr << "Error starting write-behind transaction: " << errMsg << endl;
+            sqlite3_free(errMsg);
+            timer.fail();
+            return false;
+        }
+        bool ok = true;
+        for (PendingMap::const_iterator it = batch.begin(); ok && it != batch.end(); ++it) {
+            const PendingWrite& write = it->second;
+            sqlite3_stmt* stmt;
+            if (write.table == TABLE_HOTELS) {
+                stmt = writerStatements.acquire(write.remove ? STMT_DELETE_HOTEL : STMT_UPSERT_HOTEL);
+                if (write.remove) sqlite3_bind_int(stmt, 1, write.hotel.id);
+                else bindRecord(stmt, write.hotel);
+            } else {
+                stmt = writerStatements.acquire(write.remove ? STMT_DELETE_GUEST : STMT_UPSERT_GUEST);
+                if (write.remove) sqlite3_bind_int(stmt, 1, write.guest.id);
+                else bindRecord(stmt, write.guest);
+            }
+            ok = sqlite3_step(stmt) == SQLITE_DONE;
+            if (!ok) cerr << "Error writing behind: " << sqlite3_errmsg(connection) << endl;
+            writerStatements.release(stmt);
+        }
+        if (ok && sqlite3_exec(connection, "COMMIT;", NULL, NULL, &errMsg) != SQLITE_OK) {
+            cerr << "Error committing write-behind batch: " << errMsg << endl;
+            sqlite3_free(errMsg);
+            ok = false;
+        }
+        if (!ok) {
+            sqlite3_exec(connection, "ROLLBACK;", NULL, NULL, NULL);
+            timer.fail();
+            return false;
+        }
+        committedRows += batch.size();
+        commits++;
+        return true;
+    }
+
+    WriteBehindWriter(const WriteBehindWriter&);
+    WriteBehindWriter& operator=(const WriteBehindWriter&);
+};
+
+
+
+// Fixed set of threads for fan-out work. run() hands out task indexes
+// 0..count-1 and returns once all of them have finished. The calling thread
+// takes tasks too, so a pool started with one thread runs everything inline.
+class WorkerPool {
+public:
+    WorkerPool() : task(NULL), taskCount(0), nextTask(0), unfinished(0), stopping(false) {}
+    ~WorkerPool() { stop(); }
+
+    void start(int threads) {
+        stop();
+        stopping = false;
+        for (int i = 1; i < threads; i++) workers.push_back(thread(&WorkerPool::work, this));
+    }
+
+    void stop() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+        workers.clear();
+    }
+
+    int threadCount() const { return int(workers.size()) + 1; }
+
+    void run(int count, const function<void(int)>& body) {
+        lock_guard<mutex> serial(runLock); // One batch at a time
+        unique_lock<mutex> guard(lock);
+        task = &body;
+        taskCount = count;
+        nextTask = 0;
+        unfinished = count;
+        wake.notify_all();
+        drain(guard);
+        finished.wait(guard, [this] { return unfinished == 0; });
+        task = NULL;
+    }
+
+private:
+    vector<thread> workers;
+    mutex runLock;
+    mutex lock; // Guards everything below
+    condition_variable wake;
+    condition_variable finished;
+    const function<void(int)>* task;
+    int taskCount;
+    int nextTask;
+    int unfinished;
+    bool stopping;
+
+    // Run tasks from the current batch until none are left to claim
+    void drain(unique_lock<mutex>& guard) {
+        while (task && nextTask < taskCount) {
+            int index = nextTask++;
+            const function<void(int)>* body = task;
+            guard.unlock();
+            (*body)(index);
+            guard.lock();
+            if (--unfinished == 0) finished.notify_all();
+        }
+    }
+
+    void work() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [this] { return stopping || (task && nextTask < taskCount); });
+            if (stopping) return;
+            drain(guard);
+        }
+    }
+
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+};
+
+// Hotels partitioned across several database files (--shards N). A hotel
+// lives in the shard picked by a hash of its lower-cased location, so each
+// town's hotels share one file and one connection; guests have no location
+// and stay in the main file. Work that spans shards runs one task per shard
+// on the worker pool and the caller merges the results.
+class ShardSet {
+public:
+    struct Shard {
+        string path;
+        sqlite3* connection;
+        StatementCache statements;
+        WriteBehindWriter writer; // Running only with durability.writeBehind
+        long long changeSeq;      // Last ChangeLog sequence applied to memory, -1 before loading
+
+        Shard() : connection(NULL), changeSeq(-1) {}
+    };
+
+    ShardSet() {}
+    ~ShardSet() { close(); }
+
+    bool active() const { return !shards.empty(); }
+    int count() const { return int(shards.size()); }
+    Shard& operator[](int index) { return *shards[index]; }
+
+    // FNV-1a, which unlike std::hash is the same on every build, so rows
+    // written by one binary are found by the next
+    int shardFor(const string& location) const {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < location.size(); i++) {
+            hash ^= uint32_t(tolower((unsigned char)location[i]));
+            hash *= 16777619u;
+        }
+        return int(hash % shards.size());
+    }
+
+    Shard& add(const string& path) {
+        shards.push_back(new Shard());
+        shards.back()->path = path;
+        return *shards.back();
+    }
+
+    // Threads used by forEach, including the caller
+    void setThreads(int threads) { pool.start(max(1, threads)); }
+    int threadCount() const { return pool.threadCount(); }
+
+    // Run task(shardIndex) for every shard on the pool and wait for all
+    void forEach(const function<void(int)>& task) { pool.run(count(), task); }
+
+    bool flush() {
+        bool ok = true;
+        for (size_t i = 0; i < shards.size(); i++) ok = shards[i]->writer.flush() && ok;
+        return ok;
+    }
+
+    bool close() {
+        bool ok = true;
+        pool.stop();
+        for (size_t i = 0; i < shards.size(); i++) {
+            ok = shards[i]->writer.stop() && ok;
+            shards[i]->statements.finalizeAll();
+            sqlite3_close(shards[i]->connection);
+            delete shards[i];
+        }
+        shards.clear();
+        return ok;
+    }
+
+private:
+    vector<Shard*> shards;
+    WorkerPool pool;
+
+    ShardSet(const ShardSet&);
+    ShardSet& operator=(const ShardSet&);
+};
+
+// Global Data
+HotelLinkedList hotelList;
+GuestLinkedList guestQueue;
+list<ItineraryStop> itinerary;
+sqlite3* db;
+StatementCache statements; // Prepared write statements for db
+DurabilityOptions durability;
+WriteBehindWriter writeBehind; // Running only with durability.writeBehind
+ShardSet shards; // Hotel shard files, open only with durability.shards
+BookingLedger bookings;
+
+// Function prototypes
+void initializeDatabase(const char* path = "tourism.db");
+bool closeDatabase();
+bool flushPendingWrites();
+void adminMenu();
+void customerMenu();
+bool authenticateAdmin();
+void addHotel();
+void updateHotel();
+void viewHotels();
+void deleteHotel();
+bool saveHotelToDatabase(const Hotel& hotel);
+bool updateHotelInDatabase(const Hotel& hotel, const string& previousLocation = "");
+bool deleteHotelFromDatabase(int id, const string& location = "");
+void loadHotelsFromDatabase();
+void addGuest();
+void serveGuest();
+void displayGuestQueue();
+void checkQueuePosition();
+void leaveQueue();
+bool saveGuestToDatabase(const Guest& guest);
+bool deleteGuestFromDatabase(int id);
+void loadGuestsFromDatabase();
+void loadBookingsFromDatabase();
+void viewStats();
+enum PageSource { PAGE_HOTELS, PAGE_GUESTS };
+void browsePages(PageSource source);
+void bulkImport();
+void searchHotelsByServices();
+void findHotelsByName();
+void findGuestsByName();
+void findHotelsByRooms();
+void findHotelsNearItinerary();
+void addStopToItinerary();
+void viewItinerary();
+void checkFreeRooms();
+void findFreeHotelsForStay();
+void bookRooms();
+void cancelBooking();
+void managementReport();
+bool isHotelIdUnique(int id);
+bool isGuestIdUnique(int id);
+bool addHotelRecord(Hotel&& hotel, string& message);
+bool updateHotelRecord(const Hotel& hotel, string& message);
+bool deleteHotelRecord(int id, string& message);
+bool enqueueGuest(Guest& guest, string& message);
+bool serveNextGuest(Guest& served, string& message);
+bool cancelGuest(int id, string& message);
+bool addItineraryStop(const ItineraryStop& stop, string& message);
+bool setHotelCoordinates(int id, double latitude, double longitude, string& message);
+bool bookHotelRooms(Booking& booking, string& message);
+bool cancelBookingRecord(int id, string& message);
+bool verifyReport(string& message);
+void openSession();
+bool closeSession();
+#ifdef CMS_BENCHMARKS
+int runBenchmark(const string& name, const string& jsonPath, bool quick);
+#endif
+int runImportCommand(const string& table, const string& path, int batchSize);
+int runBatch(const string& path);
+int runReplay(const string& path, double rate);
+int runServer(int port, int workers);
+int runLoadgen(int port, int connectionCount, double seconds, int writePercent);
+int runVerifyReport();
+
+const int DEFAULT_IMPORT_BATCH_SIZE = 50000;
+
+bool loadSnapshot(const char* path);
+bool writeSnapshot(const char* path);
+bool replayChangesSince(long long seq);
+bool refreshFromDatabase(string& message);
+void refreshData();
+
+const char* const SNAPSHOT_PATH = "tourism.snapshot";
+
+bool catalogueSeeded();
+bool markCatalogueSeeded();
+
+// Predefined hotels near Lalibela
+void addPredefinedHotels() {
+    hotelList.clearList(); // Clear existing list first if needed
+    list<Hotel> predefinedHotels; // Initialize as an empty list
+
+    Hotel hotel1 = {1, "Lalibela Lodge", "Free Wi-Fi, Restaurant, Pool", "Lalibela", 20, 12.0285, 39.0468};
+    predefinedHotels.push_back(hotel1);
+    Hotel hotel2 = {2, "Mountain View Hotel", "Spa, Free Breakfast", "Lalibela", 15, 12.0340, 39.0505};
+    predefinedHotels.push_back(hotel2);
+    Hotel hotel3 = {3, "Rock-Hewn Inn", "Bar, Room Service", "Lalibela", 25, 12.0322, 39.0428};
+    predefinedHotels.push_back(hotel3);
+    Hotel hotel4 = {4, "Zion Hotel", "Free Parking, Conference Room", "Lalibela", 30, 12.0271, 39.0395};
+    predefinedHotels.push_back(hotel4);
+    Hotel hotel5 = {5, "St. George Guesthouse", "Free Wi-Fi, Garden", "Lalibela", 10, 12.0308, 39.0410};
+    predefinedHotels.push_back(hotel5);
+    Hotel hotel6 = {6, "Axum Hotel", "Restaurant, Free Parking", "Lalibela", 18, 12.0356, 39.0452};
+    predefinedHotels.push_back(hotel6);
+    Hotel hotel7 = {7, "Queen Sheba Hotel", "Pool, Spa, Gym", "Lalibela", 22, 12.0297, 39.0489};
+    predefinedHotels.push_back(hotel7);
+    Hotel hotel8 = {8, "Ethiopian Heritage Hotel", "Free Breakfast, Bar", "Lalibela", 12, 12.0333, 39.0379};
+    predefinedHotels.push_back(hotel8);
+    Hotel hotel9 = {9, "Bete Maryam Hotel", "Free Wi-Fi, Restaurant", "Lalibela", 14, 12.0318, 39.0442};
+    predefinedHotels.push_back(hotel9);
+    Hotel hotel10 = {10, "Tekle Haymanot Lodge", "Garden, Room Service", "Lalibela", 16, 12.0262, 39.0431};
+    predefinedHotels.push_back(hotel10);
+
+
+    for (list<Hotel>::iterator hotel_iter = predefinedHotels.begin(); hotel_iter != predefinedHotels.end(); ++hotel_iter) {
+        if (hotelList.isHotelIdUnique(hotel_iter->id)) {
+            saveHotelToDatabase(*hotel_iter); // Listings page from the database, so seed it too
+            hotelList.addHotel(std::move(*hotel_iter));
+        }
+    }
+}
+
+// Predefined itineraries
+void addPredefinedItinerary() {
+    itinerary.clear(); // Clear existing itinerary if needed
+    itinerary.push_back(ItineraryStop("1. Visit the Rock-Hewn Churches of Lalibela", 12.0316, 39.0411));
+    itinerary.push_back(ItineraryStop("2. Explore Asheton Maryam Monastery", 12.0603, 39.0636));
+    itinerary.push_back(ItineraryStop("3. Hike to the top of Mount Abuna Yosef", 12.1561, 39.1911));
+    itinerary.push_back(ItineraryStop("4. Visit the Lalibela Market", 12.0290, 39.0475));
+    itinerary.push_back(ItineraryStop("5. Attend a traditional coffee ceremony"));
+}
+
+// Open the database and bring memory up to date, seeding on first run
+void openSession() {
+    initializeDatabase();
+    if (!loadSnapshot(SNAPSHOT_PATH)) {
+        loadHotelsFromDatabase();
+        loadGuestsFromDatabase();
+    }
+    loadBookingsFromDatabase(); // Not in the snapshot; bookings are read fresh each start
+    if (!catalogueSeeded()) {
+        addPredefinedHotels(); // Seed the catalogue on first run only
+        if (flushPendingWrites()) markCatalogueSeeded();
+    }
+}
+
+// Snapshot for a fast next start, then close the database. False if
+// changes were lost on the way.
+bool closeSession() {
+    writeSnapshot(SNAPSHOT_PATH);
+    return closeDatabase();
+}
+
+// Leading durability and storage options, which apply to every mode:
+//   --write-behind  --flush-rows N  --flush-ms N  --journal MODE  --synchronous LEVEL  --shards N
+// Returns how many arguments were consumed, or -1 on a bad option.
+const int MAX_SHARDS = 256;
+
+static int parseDurabilityOptions(int argc, char* argv[], DurabilityOptions& options) {
+    const char* journalModes[] = {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"};
+    const char* syncLevels[] = {"OFF", "NORMAL", "FULL", "EXTRA"};
+    int i = 1;
+    while (i < argc) {
+        string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        string value = hasValue ? argv[i + 1] : "";
+        transform(value.begin(), value.end(), value.begin(), ::toupper);
+        if (option == "--write-behind") {
+            options.writeBehind = true;
+            i++;
+        } else if ((option == "--flush-rows" || option == "--flush-ms") && hasValue && atoi(argv[i + 1]) > 0) {
+            (option == "--flush-rows" ? options.flushRows : options.flushMillis) = atoi(argv[i + 1]);
+            i += 2;
+        } else if (option == "--shards" && hasValue && atoi(argv[i + 1]) > 0 && atoi(argv[i + 1]) <= MAX_SHARDS) {
+            options.shards = atoi(argv[i + 1]);
+            i += 2;
+        } else if (option == "--journal" && hasValue &&
+                   find(journalModes, journalModes + 6, value) != journalModes + 6) {
+            options.journalMode = value;
+            i += 2;
+        } else if (option == "--synchronous" && hasValue && find(syncLevels, syncLevels + 4, value) != syncLevels + 4) {
+            options.synchronous = value;
+            i += 2;
+        } else if (option == "--flush-rows" || option == "--flush-ms" || option == "--journal" || option == "--synchronous" ||
+                   option == "--shards") {
+            cerr << "Invalid value for " << option << "\n"
+                 << "Usage: [--write-behind] [--flush-rows N] [--flush-ms N] "
+                 << "[--journal DELETE|TRUNCATE|PERSIST|MEMORY|WAL|OFF] [--synchronous OFF|NORMAL|FULL|EXTRA] "
+                 << "[--shards 1-" << MAX_SHARDS << "]\n";
+            return -1;
+        } else {
+            break;
+        }
+    }
+    return i - 1;
+}
+
+int main(int argc, char* argv[]) {
+    int consumed = parseDurabilityOptions(argc, argv, durability);
+    if (consumed < 0) return 1;
+    argv[consumed] = argv[0];
+    argc -= consumed;
+    argv += consumed;
+
+#ifdef CMS_BENCHMARKS
+    if (argc >= 3 && string(argv[1]) == "--bench") {
+        string jsonPath;
+        bool quick = false;
+        for (int i = 3; i < argc; i++) {
+            if (string(argv[i]) == "--json" && i + 1 < argc) jsonPath = argv[++i];
+            else if (string(argv[i]) == "--quick") quick = true;
+        }
+        return runBenchmark(argv[2], jsonPath, quick);
+    }
+#else
+    if (argc >= 2 && string(argv[1]) == "--bench") {
+        cerr << "Benchmarks are built into the ContactMGMTSysBench target.\n";
+        return 1;
+    }
+#endif
+    if (argc >= 4 && string(argv[1]) == "--import") {
+        return runImportCommand(argv[2], argv[3], argc >= 5 ? atoi(argv[4]) : DEFAULT_IMPORT_BATCH_SIZE);
+    }
+    if (argc >= 3 && string(argv[1]) == "--batch") {
+        return runBatch(argv[2]);
+    }
+    if (argc >= 3 && string(argv[1]) == "--replay") {
+        return runReplay(argv[2], argc >= 4 ? atof(argv[3]) : 0);
+    }
+    if (argc >= 3 && string(argv[1]) == "--serve") {
+        return runServer(atoi(argv[2]), argc >= 4 ? atoi(argv[3]) : 0);
+    }
+    if (argc >= 3 && string(argv[1]) == "--loadgen") {
+        return runLoadgen(atoi(argv[2]), argc >= 4 ? atoi(argv[3]) : 8, argc >= 5 ? atof(argv[4]) : 10,
+                          argc >= 6 ? atoi(argv[5]) : 10);
+    }
+    if (argc >= 2 && string(argv[1]) == "--verify-report") {
+        return runVerifyReport();
+    }
+
+    openSession();
+
+    int userType;
+    do {
+        cout << "\nLalibela Tourism Management\n";
+        cout << "1. Admin\n2. Customer\n3. Exit\nChoice: ";
+        cin >> userType;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+        switch(userType) {
+            case 1:
+                if(authenticateAdmin()) adminMenu();
+                else cout << "Access denied!\n";
+                break;
+            case 2: customerMenu(); break;
+            case 3: cout << "Exiting...\n"; break;
+            default: cout << "Invalid choice!\n";
+        }
+    } while(userType != 3);
+
+    return closeSession() ? 0 : 1;
+}
+
+// Result of a query returning a single number, such as a COUNT(*), or -1 if it fails
+static long long selectNumber(sqlite3* connection, const char* sql) {
+    sqlite3_stmt* stmt;
+    long long value = -1;
+    if (sqlite3_prepare_v2(connection, sql, -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return value;
+}
+
+// Highest ChangeLog sequence number ever handed out; AUTOINCREMENT keeps it
+// in sqlite_sequence even after the log is trimmed
+static long long currentChangeSeq(sqlite3* connection) {
+    return selectNumber(connection, "SELECT COALESCE((SELECT seq FROM sqlite_sequence WHERE name='ChangeLog'), 0);");
+}
+
+static long long currentChangeSeq() {
+    return currentChangeSeq(db);
+}
+
+// How far the in-memory lists have applied the main file's change log, per
+// table: everything up to and including this sequence, or -1 before the
+// first load. Each shard keeps its own position for its hotels.
+struct ChangeCursor {
+    long long hotels;
+    long long guests;
+};
+
+static ChangeCursor changeCursor = {-1, -1};
+
+static bool execSql(sqlite3* connection, const char* sql) {
+    ScopedTimer timer(MET_SQL_EXEC);
+    char* errMsg;
+    if (sqlite3_exec(connection, sql, NULL, NULL, &errMsg) != SQLITE_OK) {
+        cerr << "Error running \"" << sql << "\": " << errMsg << endl;
+        sqlite3_free(errMsg);
+        timer.fail();
+        return false;
+    }
+    return true;
+}
+
+// Runs a connection's reads as one consistent view of the file, so a change-log
+// position read first matches the rows read after it. Does nothing inside a
+// transaction that is already open.
+class ReadTransaction {
+public:
+    explicit ReadTransaction(sqlite3* connection) : connection(sqlite3_get_autocommit(connection) ? connection : NULL) {
+        if (this->connection && !execSql(this->connection, "BEGIN;")) this->connection = NULL;
+    }
+    ~ReadTransaction() {
+        if (connection) execSql(connection, "COMMIT;");
+    }
+
+private:
+    sqlite3* connection;
+
+    ReadTransaction(const ReadTransaction&);
+    ReadTransaction& operator=(const ReadTransaction&);
+};
+
+static bool execSql(const char* sql) {
+    return execSql(db, sql);
+}
+
+// Write the listed rows through one connection in a single transaction.
+// written[row] is set for each row that went in and failed counts the rest.
+// Returns false, with none of the rows written, if the transaction did not commit.
+static bool writeHotelRows(sqlite3* connection, StatementCache& cache, StatementId statement,
+                           const vector<Hotel>& hotels, const vector<size_t>& rows, vector<char>& written, long& failed) {
+    if (!execSql(connection, "BEGIN IMMEDIATE;")) {
+        failed += long(rows.size());
+        return false;
+    }
+    long rowErrors = 0;
+    for (size_t i = 0; i < rows.size(); i++) {
+        const Hotel& hotel = hotels[rows[i]];
+        sqlite3_stmt* stmt = cache.acquire(statement);
+        bindRecord(stmt, hotel);
+        if (sqlite3_step(stmt) == SQLITE_DONE) {
+            written[rows[i]] = 1;
+        } else if (rowErrors++ < 5) {
+            cerr << "Error writing hotel " << hotel.id << ": " << sqlite3_errmsg(connection) << endl;
+        }
+        cache.release(stmt);
+    }
+    if (!execSql(connection, "COMMIT;")) {
+        execSql(connection, "ROLLBACK;");
+        for (size_t i = 0; i < rows.size(); i++) written[rows[i]] = 0;
+        failed += long(rows.size());
+        return false;
+    }
+    failed += rowErrors;
+    return true;
+}
+
+// Write hotels to their shards, one transaction per shard, all shards at
+// once. Returns false if any shard's transaction did not commit; the other
+// shards keep their rows, and written and failed are as above.
+static bool writeHotelsToShards(const vector<Hotel>& hotels, StatementId statement, vector<char>& written, long& failed) {
+    vector<vector<size_t> > rows(shards.count());
+    for (size_t i = 0; i < hotels.size(); i++) rows[shards.shardFor(hotels[i].location)].push_back(i);
+    written.assign(hotels.size(), 0);
+    vector<long> shardFailed(shards.count(), 0);
+    vector<char> committed(shards.count(), 1);
+    shards.forEach([&](int index) {
+        if (rows[index].empty()) return;
+        ShardSet::Shard& shard = shards[index];
+        committed[index] = writeHotelRows(shard.connection, shard.statements, statement, hotels, rows[index],
+                                          written, shardFailed[index]);
+    });
+    for (int i = 0; i < shards.count(); i++) failed += shardFailed[i];
+    return count(committed.begin(), committed.end(), 0) == 0;
+}
+
+// Create a record's table, or add the schema columns an older build's table
+// lacks; databases from before hotels had coordinates gain them this way
+template <typename Record>
+static bool createRecordTable(sqlite3* connection) {
+    static constexpr SchemaSql createTable = createTableSql<Record>();
+    const char* table = RecordSchema<Record>::table;
+    char* errMsg;
+    if (sqlite3_exec(connection, createTable.c_str(), NULL, NULL, &errMsg) != SQLITE_OK) {
+        cerr << "Error creating " << table << " table: " << errMsg << endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+    sqlite3_stmt* stmt;
+    string sql = string("SELECT name FROM pragma_table_info('") + table + "');";
+    if (sqlite3_prepare_v2(connection, sql.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+        cerr << "Error reading " << table << " schema: " << sqlite3_errmsg(connection) << endl;
+        return false;
+    }
+    unordered_set<string> present;
+    while (sqlite3_step(stmt) == SQLITE_ROW) present.insert(string(columnText(stmt, 0)));
+    sqlite3_finalize(stmt);
+
+    bool ok = true;
+    forEachColumn<Record>([&](const auto& column, auto) {
+        if (!ok || present.count(column.name)) return;
+        string alter = string("ALTER TABLE ") + table + " ADD COLUMN " + column.name + " " + column.declaration + ";";
+        if (sqlite3_exec(connection, alter.c_str(), NULL, NULL, &errMsg) != SQLITE_OK) {
+            cerr << "Error adding " << column.name << " to " << table << ": " << errMsg << endl;
+            sqlite3_free(errMsg);
+            ok = false;
+        }
+    });
+    return ok;
+}
+
+// The same orderings as RoomIndex, for queries run straight against the file.
+// A large import drops them and builds each once at the end.
+static const char* const CREATE_HOTEL_INDEXES_SQL =
+    "CREATE INDEX IF NOT EXISTS idx_hotels_rooms ON Hotels (roomNumber, id);"
+    "CREATE INDEX IF NOT EXISTS idx_hotels_location_rooms ON Hotels (location COLLATE NOCASE, roomNumber, id);";
+static const char* const DROP_HOTEL_INDEXES_SQL =
+    "DROP INDEX IF EXISTS idx_hotels_rooms;"
+    "DROP INDEX IF EXISTS idx_hotels_location_rooms;";
+
+// Create the tables, indexes and change-log triggers on one connection.
+// Shard files get the same schema, so the shared statements prepare on them.
+static bool createSchema(sqlite3* connection) {
+
+    // Keyset pagination walks the queue in (queuePosition, id) order
+    char* createGuestQueueIndex = (char*)
+        "CREATE INDEX IF NOT EXISTS idx_guests_queue ON Guests (queuePosition, id);";
+
+    // Stays as readable dates, checkOut being the day the guest leaves.
+    // Bookings are kept in the main file; shard files get the empty table
+    // too so every connection prepares the same statements.
+    char* createBookingsTable = (char*)
+        "CREATE TABLE IF NOT EXISTS Bookings ("
+        "id INTEGER PRIMARY KEY, "
+        "hotelId INTEGER NOT NULL, "
+        "guestName TEXT, "
+        "checkIn TEXT NOT NULL, "
+        "checkOut TEXT NOT NULL, "
+        "rooms INTEGER NOT NULL);"
+        "CREATE INDEX IF NOT EXISTS idx_bookings_hotel ON Bookings (hotelId, checkIn);";
+
+    // Every insert, update and delete is logged with a rising sequence number
+    // so a snapshot can be brought up to date by replaying only later changes
+    char* createChangeLog = (char*)
+        "CREATE TABLE IF NOT EXISTS ChangeLog ("
+        "seq INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "tableName TEXT NOT NULL, "
+        "rowId INTEGER NOT NULL);"
+        "CREATE TRIGGER IF NOT EXISTS hotels_log_insert AFTER INSERT ON Hotels BEGIN "
+        "INSERT INTO ChangeLog (tableName, rowId) VALUES ('Hotels', NEW.id); END;"
+        "CREATE TRIGGER IF NOT EXISTS hotels_log_update AFTER UPDATE ON Hotels BEGIN "
+        "INSERT INTO ChangeLog (tableName, rowId) VALUES ('Hotels', OLD.id); "
+        "INSERT INTO ChangeLog (tableName, rowId) SELECT 'Hotels', NEW.id WHERE NEW.id != OLD.id; END;"
+        "CREATE TRIGGER IF NOT EXISTS hotels_log_delete AFTER DELETE ON Hotels BEGIN "
+        "INSERT INTO ChangeLog (tableName, rowId) VALUES ('Hotels', OLD.id); END;"
+        "CREATE TRIGGER IF NOT EXISTS guests_log_insert AFTER INSERT ON Guests BEGIN "
+        "INSERT INTO ChangeLog (tableName, rowId) VALUES ('Guests', NEW.id); END;"
+        "CREATE TRIGGER IF NOT EXISTS guests_log_update AFTER UPDATE ON Guests BEGIN "
+        "INSERT INTO ChangeLog (tableName, rowId) VALUES ('Guests', OLD.id); "
+        "INSERT INTO ChangeLog (tableName, rowId) SELECT 'Guests', NEW.id WHERE NEW.id != OLD.id; END;"
+        "CREATE TRIGGER IF NOT EXISTS guests_log_delete AFTER DELETE ON Guests BEGIN "
+        "INSERT INTO ChangeLog (tableName, rowId) VALUES ('Guests', OLD.id); END;";
+
+    if (!createRecordTable<Hotel>(connection) || !createRecordTable<Guest>(connection)) {
+        return false;
+    }
+
+    char* errMsg;
+    if (sqlite3_exec(connection, createGuestQueueIndex, NULL, NULL, &errMsg) != SQLITE_OK) {
+        cerr << "Error creating Guests index: " << errMsg << endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+    if (sqlite3_exec(connection, CREATE_HOTEL_INDEXES_SQL, NULL, NULL, &errMsg) != SQLITE_OK) {
+        cerr << "Error creating Hotels indexes: " << errMsg << endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+    if (sqlite3_exec(connection, createBookingsTable, NULL, NULL, &errMsg) != SQLITE_OK) {
+        cerr << "Error creating Bookings table: " << errMsg << endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+    if (sqlite3_exec(connection, createChangeLog, NULL, NULL, &errMsg) != SQLITE_OK) {
+        cerr << "Error creating change log: " << errMsg << endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+    return true;
+}
+
+// Every hotel in one file, and the change-log position they reflect. False,
+// with changeSeq untouched, unless the whole table was read.
+static bool readHotels(sqlite3* connection, vector<Hotel>& hotels, long long& changeSeq) {
+    ReadTransaction snapshot(connection);
+    long long seq = currentChangeSeq(connection);
+    sqlite3_stmt* stmt;
+    if (seq < 0 || sqlite3_prepare_v2(connection, LOAD_HOTELS_SQL.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+        cerr << "Error loading hotels from " << sqlite3_db_filename(connection, "main") << ": "
+             << sqlite3_errmsg(connection) << endl;
+        return false;
+    }
+    hotels.reserve(size_t(max(0LL, selectNumber(connection, "SELECT COUNT(*) FROM Hotels;"))));
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        hotels.push_back(Hotel());
+        readRecord(stmt, hotels.back());
+    }
+    if (rc != SQLITE_DONE) {
+        cerr << "Error loading hotels from " << sqlite3_db_filename(connection, "main") << ": "
+             << sqlite3_errmsg(connection) << endl;
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) return false;
+    changeSeq = seq;
+    return true;
+}
+
+// Hotels written before sharding was turned on move out of the main file once
+static bool moveHotelsToShards() {
+    vector<Hotel> hotels;
+    long long changeSeq;
+    if (!readHotels(db, hotels, changeSeq)) {
+        cerr << "Error reading hotels to shard; they stay in the main file for now." << endl;
+        return false;
+    }
+
+    vector<char> written;
+    long failed = 0;
+    if (!writeHotelsToShards(hotels, STMT_UPSERT_HOTEL, written, failed) || failed > 0) {
+        cerr << "Error moving hotels into shards; they stay in the main file for now." << endl;
+        return false;
+    }
+    string layout = "INSERT INTO ShardLayout (shards) VALUES (" + to_string(shards.count()) + ");";
+    if (!execSql("BEGIN IMMEDIATE;")) return false;
+    if (!execSql("DELETE FROM Hotels;") || !execSql(layout.c_str()) || !execSql("COMMIT;")) {
+        execSql("ROLLBACK;");
+        return false;
+    }
+    if (!hotels.empty()) cout << "Moved " << hotels.size() << " hotel(s) into " << shards.count() << " shards.\n";
+    return true;
+}
+
+// Open the shard files next to the main one (tourism.db -> tourism.shard0.db, ...).
+// The shard count is recorded in the main file, because a different count
+// would look for each town's hotels in the wrong shard.
+static bool openShards(const char* path) {
+    if (!execSql("CREATE TABLE IF NOT EXISTS ShardLayout (shards INTEGER NOT NULL);")) return false;
+    int recorded = 0;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT COALESCE(MAX(shards), 0) FROM ShardLayout;", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) recorded = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    if (recorded != 0 && recorded != durability.shards) {
+        cerr << "Hotels in " << path << " are split across " << recorded
+             << " shard files; start with --shards " << recorded << "." << endl;
+        return false;
+    }
+    if (durability.shards == 0) return true;
+
+    string stem = path;
+    if (stem.size() > 3 && stem.compare(stem.size() - 3, 3, ".db") == 0) stem.resize(stem.size() - 3);
+    for (int i = 0; i < durability.shards; i++) {
+        ShardSet::Shard& shard = shards.add(stem + ".shard" + to_string(i) + ".db");
+        if (sqlite3_open(shard.path.c_str(), &shard.connection) != SQLITE_OK ||
+            !applyDurability(shard.connection, durability) || !createSchema(shard.connection) ||
+            !shard.statements.prepareAll(shard.connection)) {
+            cerr << "Error opening shard " << shard.path << ": " << sqlite3_errmsg(shard.connection) << endl;
+            return false;
+        }
+        if (durability.writeBehind && !shard.writer.start(shard.path.c_str(), durability)) {
+            return false;
+        }
+    }
+    shards.setThreads(min(durability.shards, int(max(1u, thread::hardware_concurrency()))));
+    return recorded != 0 || moveHotelsToShards();
+}
+
+// PRAGMA user_version of the main file once the predefined hotels are in it,
+// so deleting them all, or a load that finds nothing, does not seed again
+const int CATALOGUE_SEEDED = 1;
+
+bool catalogueSeeded() {
+    return selectNumber(db, "PRAGMA user_version;") >= CATALOGUE_SEEDED;
+}
+
+bool markCatalogueSeeded() {
+    return execSql(("PRAGMA user_version = " + to_string(CATALOGUE_SEEDED) + ";").c_str());
+}
+
+// Initialize SQLite Database
+void initializeDatabase(const char* path) {
+    if (sqlite3_open(path, &db)) {
+        cerr << "Error opening SQLite database: " << sqlite3_errmsg(db) << endl;
+        exit(1);
+    }
+    // Files from before the seeding marker were seeded on their first run
+    bool existing = selectNumber(db, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'Hotels';") > 0;
+    if (!applyDurability(db, durability) || !createSchema(db)) {
+        exit(1);
+    }
+    if (existing && !catalogueSeeded() && !markCatalogueSeeded()) {
+        exit(1);
+    }
+    if (!statements.prepareAll(db)) {
+        exit(1);
+    }
+    if (durability.writeBehind && !writeBehind.start(path, durability)) {
+        exit(1);
+    }
+    if (!openShards(path)) {
+        exit(1);
     }
 
     cout << "Database initialized successfully.\n";
 }
 
-// Close SQLite Database
-void closeDatabase() {
-    sqlite3_close(db);
-    cout << "Database connection closed.\n";
+// Make every change accepted so far visible to reads on db. False if a
+// write-behind commit failed; the changes stay queued and are retried.
+bool flushPendingWrites() {
+    bool ok = writeBehind.flush();
+    return shards.flush() && ok;
+}
+
+// Close SQLite Database. False if write-behind changes were given up.
+bool closeDatabase() {
+    bool ok = writeBehind.stop(); // Commits anything still pending
+    ok = shards.close() && ok;
+    statements.finalizeAll();
+    sqlite3_close(db);
+    if (!ok) cerr << "Error: some changes were not saved to the database." << endl;
+    cout << "Database connection closed.\n";
+    return ok;
+}
+
+
+// Check if hotel ID is unique
+bool isHotelIdUnique(int id) {
+    return hotelList.isHotelIdUnique(id);
+}
+
+// Check if guest ID is unique
+bool isGuestIdUnique(int id) {
+    return guestQueue.isGuestIdUnique(id);
+}
+
+// Admin authentication
+bool authenticateAdmin() {
+    string password;
+    cout << "Enter admin password: ";
+    getline(cin, password);
+    return (password == "admin123"); // Simple password check
+}
+
+// Admin menu
+void adminMenu() {
+    int choice;
+    do {
+        cout << "\nAdmin Menu\n"
+             << "1. Add Hotel\n"
+             << "2. Update Hotel\n"
+             << "3. View Hotels\n"
+             << "4. Delete Hotel\n"
+             << "5. Bulk Import\n"
+             << "6. Stats\n"
+             << "7. Serve Next Guest\n"
+             << "8. Refresh From Database\n"
+             << "9. Find Guest by Name\n"
+             << "10. Management Report\n"
+             << "11. Back\nChoice: ";
+        cin >> choice;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+        switch(choice) {
+            case 1: addHotel(); break;
+            case 2: updateHotel(); break;
+            case 3: viewHotels(); break;
+            case 4: deleteHotel(); break;
+            case 5: bulkImport(); break;
+            case 6: viewStats(); break;
+            case 7: serveGuest(); break;
+            case 8: refreshData(); break;
+            case 9: findGuestsByName(); break;
+            case 10: managementReport(); break;
+        }
+    } while(choice != 11);
+}
+
+// Add a new hotel
+void addHotel() {
+    Hotel hotel;
+    cout << "Enter Hotel ID: ";
+    cin >> hotel.id;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+    if (!isHotelIdUnique(hotel.id)) {
+        cout << "Error: Hotel ID already exists. Please enter a unique ID.\n";
+        return;
+    }
+
+    cout << "Enter Hotel Name: ";
+    getline(cin, hotel.name);
+    cout << "Enter Services: ";
+    getline(cin, hotel.services);
+    cout << "Enter Location: ";
+    getline(cin, hotel.location);
+    cout << "Enter Room Number: ";
+    cin >> hotel.roomNumber;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+    string coordinates;
+    cout << "Enter Coordinates as latitude,longitude (blank for none): ";
+    getline(cin, coordinates);
+    if (!parseCoordinates(coordinates, hotel.latitude, hotel.longitude)) {
+        cout << "Error: coordinates must look like 12.03,39.04.\n";
+        return;
+    }
+
+    string message;
+    addHotelRecord(std::move(hotel), message);
+    cout << message << "\n";
+}
+
+// Insert (or upsert) one hotel through a connection's statements, or queue
+// it on that connection's write-behind writer when one is running
+static bool writeHotelRow(sqlite3* connection, StatementCache& cache, WriteBehindWriter& writer,
+                          StatementId statement, const Hotel& hotel) {
+    if (writer.active()) {
+        writer.saveHotel(hotel);
+        return true;
+    }
+    sqlite3_stmt* stmt = cache.acquire(statement);
+    if (!stmt) {
+        cerr << "Error: insert statement is not prepared" << endl;
+        return false;
+    }
+    bindRecord(stmt, hotel);
+
+    bool ok = timedStep(stmt, statement == STMT_INSERT_HOTEL ? MET_SQL_INSERT_HOTEL : MET_SQL_UPDATE_HOTEL) == SQLITE_DONE;
+    if (!ok) {
+        cerr << "Error inserting hotel into database: " << sqlite3_errmsg(connection) << endl;
+    }
+    cache.release(stmt);
+    return ok;
+}
+
+static bool updateHotelRow(sqlite3* connection, StatementCache& cache, WriteBehindWriter& writer, const Hotel& hotel) {
+    if (writer.active()) {
+        writer.saveHotel(hotel);
+        return true;
+    }
+    sqlite3_stmt* stmt = cache.acquire(STMT_UPDATE_HOTEL);
+    if (!stmt) {
+        cerr << "Error: update statement is not prepared" << endl;
+        return false;
+    }
+    bindUpdate(stmt, hotel);
+
+    bool ok = timedStep(stmt, MET_SQL_UPDATE_HOTEL) == SQLITE_DONE;
+    if (!ok) {
+        cerr << "Error updating hotel: " << sqlite3_errmsg(connection) << endl;
+    }
+    cache.release(stmt);
+    return ok;
+}
+
+static bool deleteHotelRow(sqlite3* connection, StatementCache& cache, WriteBehindWriter& writer, int id) {
+    if (writer.active()) {
+        writer.removeHotel(id);
+        return true;
+    }
+    sqlite3_stmt* stmt = cache.acquire(STMT_DELETE_HOTEL);
+    if (!stmt) {
+        cerr << "Error: delete statement is not prepared" << endl;
+        return false;
+    }
+    sqlite3_bind_int(stmt, 1, id);
+
+    bool ok = timedStep(stmt, MET_SQL_DELETE_HOTEL) == SQLITE_DONE;
+    if (!ok) {
+        cerr << "Error deleting hotel from database: " << sqlite3_errmsg(connection) << endl;
+    }
+    cache.release(stmt);
+    return ok;
+}
+
+// Save hotel to database
+bool saveHotelToDatabase(const Hotel& hotel) {
+    if (shards.active()) {
+        ShardSet::Shard& shard = shards[shards.shardFor(hotel.location)];
+        return writeHotelRow(shard.connection, shard.statements, shard.writer, STMT_INSERT_HOTEL, hotel);
+    }
+    return writeHotelRow(db, statements, writeBehind, STMT_INSERT_HOTEL, hotel);
+}
+
+// Write edited hotel fields back to the database. With shards a new
+// location can move the row to another file: previousLocation names the
+// shard it leaves, and when it is not known every other shard drops the id.
+//
+// A move is three steps, each committed before the next starts: the old row
+// takes the new fields, which marks it as leaving since its location no
+// longer maps to its shard; the new copy is written; the old row is deleted.
+// Shards' write-behind writers commit independently, so each is flushed in
+// between. Stopped part way, the files hold the marked row alone, which
+// loads as the new state, or both copies, and readShardHotels keeps the one
+// whose location maps to its shard. So once the old row is marked the
+// update stands, and a later step that fails only leaves the old row behind.
+bool updateHotelInDatabase(const Hotel& hotel, const string& previousLocation) {
+    if (!shards.active()) {
+        return updateHotelRow(db, statements, writeBehind, hotel);
+    }
+    int target = shards.shardFor(hotel.location);
+    int previous = previousLocation.empty() ? -1 : shards.shardFor(previousLocation);
+    ShardSet::Shard& shard = shards[target];
+    if (previous == target) {
+        return updateHotelRow(shard.connection, shard.statements, shard.writer, hotel);
+    }
+    if (previous >= 0) {
+        ShardSet::Shard& old = shards[previous];
+        if (!updateHotelRow(old.connection, old.statements, old.writer, hotel)) return false;
+        if (!old.writer.flush()) {
+            cerr << "Warning: hotel " << hotel.id << " is not moved to " << shard.path << " yet." << endl;
+            return true;
+        }
+    }
+    if (!writeHotelRow(shard.connection, shard.statements, shard.writer, STMT_UPSERT_HOTEL, hotel) ||
+        !shard.writer.flush()) {
+        cerr << "Warning: hotel " << hotel.id << " is not moved to " << shard.path << " yet." << endl;
+        return previous >= 0;
+    }
+    for (int i = 0; i < shards.count(); i++) {
+        if (i == target || (previous >= 0 && i != previous)) continue;
+        if (!deleteHotelRow(shards[i].connection, shards[i].statements, shards[i].writer, hotel.id)) return false;
+    }
+    return true;
+}
+
+// Remove a hotel row from the database. With shards, an unknown location
+// means the id is deleted from every shard.
+bool deleteHotelFromDatabase(int id, const string& location) {
+    if (!shards.active()) {
+        return deleteHotelRow(db, statements, writeBehind, id);
+    }
+    int owner = location.empty() ? -1 : shards.shardFor(location);
+    for (int i = 0; i < shards.count(); i++) {
+        if (owner >= 0 && i != owner) continue;
+        if (!deleteHotelRow(shards[i].connection, shards[i].statements, shards[i].writer, id)) return false;
+    }
+    return true;
+}
+
+// Read every shard's hotels concurrently, one vector per shard, and the
+// change-log position each reflects. False if any shard was not read in
+// full, in which case the caller should keep the hotels it has.
+// A hotel whose location maps to another shard was stopped part way through
+// a move (see updateHotelInDatabase). If the shard it maps to has a copy,
+// that copy wins; otherwise this is the new state. Either way the move is
+// finished in the files, so later writes find the row where they look.
+static bool readShardHotels(vector<vector<Hotel> >& loaded, vector<long long>& changeSeqs) {
+    loaded.assign(shards.count(), vector<Hotel>());
+    changeSeqs.assign(shards.count(), -1);
+    vector<char> read(shards.count(), 0);
+    vector<vector<size_t> > misplaced(shards.count());
+    shards.forEach([&loaded, &changeSeqs, &read, &misplaced](int index) {
+        read[index] = readHotels(shards[index].connection, loaded[index], changeSeqs[index]);
+        for (size_t i = 0; i < loaded[index].size(); i++) {
+            if (shards.shardFor(loaded[index][i].location) != index) misplaced[index].push_back(i);
+        }
+    });
+    if (find(read.begin(), read.end(), 0) != read.end()) return false;
+
+    // Usually there is nothing misplaced, and nothing more to do
+    unordered_set<int> misplacedIds;
+    for (size_t s = 0; s < misplaced.size(); s++) {
+        for (size_t i = 0; i < misplaced[s].size(); i++) misplacedIds.insert(loaded[s][misplaced[s][i]].id);
+    }
+    if (misplacedIds.empty()) return true;
+    unordered_set<int> placed; // Misplaced ids that also have a copy where they belong, or already kept
+    for (size_t s = 0; s < loaded.size(); s++) {
+        for (size_t i = 0; i < loaded[s].size(); i++) {
+            const Hotel& hotel = loaded[s][i];
+            if (misplacedIds.count(hotel.id) && shards.shardFor(hotel.location) == int(s)) placed.insert(hotel.id);
+        }
+    }
+    vector<pair<int, int> > stale; // (shard, id) of copies that lost
+    vector<Hotel> unmoved;          // Only copies, still in the shard they left
+    for (size_t s = 0; s < misplaced.size(); s++) {
+        vector<Hotel>& hotels = loaded[s];
+        for (size_t k = misplaced[s].size(); k-- > 0;) {
+            size_t i = misplaced[s][k];
+            if (placed.insert(hotels[i].id).second) {
+                unmoved.push_back(hotels[i]);
+                continue;
+            }
+            stale.push_back(make_pair(int(s), hotels[i].id));
+            hotels[i] = std::move(hotels.back());
+            hotels.pop_back();
+        }
+    }
+    for (size_t i = 0; i < stale.size(); i++) {
+        ShardSet::Shard& shard = shards[stale[i].first];
+        deleteHotelRow(shard.connection, shard.statements, shard.writer, stale[i].second);
+    }
+    for (size_t i = 0; i < unmoved.size(); i++) updateHotelInDatabase(unmoved[i]);
+    cerr << "Finished " << stale.size() + unmoved.size() << " hotel move(s) left part way." << endl;
+    return true;
+}
+
+// Load hotels from database
+void loadHotelsFromDatabase() {
+    if (!flushPendingWrites()) {
+        cerr << "Error: pending changes are not saved yet; keeping the hotels in memory." << endl;
+        return;
+    }
+    ScopedTimer timer(MET_SQL_LOAD_HOTELS);
+    if (shards.active()) {
+        // Shards are read in parallel; the in-memory indexes are built here
+        vector<vector<Hotel> > loaded;
+        vector<long long> changeSeqs;
+        if (!readShardHotels(loaded, changeSeqs)) {
+            cerr << "Error: not every shard could be read; keeping the hotels in memory." << endl;
+            timer.fail();
+            return;
+        }
+        hotelList.clearList();
+        for (int i = 0; i < shards.count(); i++) shards[i].changeSeq = changeSeqs[i];
+        size_t total = 0;
+        for (size_t i = 0; i < loaded.size(); i++) total += loaded[i].size();
+        hotelList.reserve(total);
+        for (size_t i = 0; i < loaded.size(); i++) {
+            for (size_t j = 0; j < loaded[i].size(); j++) hotelList.addHotel(std::move(loaded[i][j]));
+            vector<Hotel>().swap(loaded[i]);
+        }
+        return;
+    }
+    hotelList.clearList();
+    ReadTransaction snapshot(db);
+    changeCursor.hotels = currentChangeSeq();
+    hotelList.reserve(size_t(max(0LL, selectNumber(db, "SELECT COUNT(*) FROM Hotels;"))));
+    sqlite3_stmt* stmt;
+
+    // Built in place from the column buffers; only the name is copied out
+    constexpr int ID = schemaColumnIndex(&Hotel::id), NAME = schemaColumnIndex(&Hotel::name),
+                  SERVICES = schemaColumnIndex(&Hotel::services), LOCATION = schemaColumnIndex(&Hotel::location),
+                  ROOMS = schemaColumnIndex(&Hotel::roomNumber), LATITUDE = schemaColumnIndex(&Hotel::latitude),
+                  LONGITUDE = schemaColumnIndex(&Hotel::longitude);
+    if (sqlite3_prepare_v2(db, LOAD_HOTELS_SQL.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+        cerr << "Error loading hotels from database: " << sqlite3_errmsg(db) << endl;
+        timer.fail();
+        return;
+    }
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        string_view name = columnText(stmt, NAME);
+        hotelList.emplaceHotel(sqlite3_column_int(stmt, ID), string(name), columnText(stmt, SERVICES),
+                               columnText(stmt, LOCATION), sqlite3_column_int(stmt, ROOMS),
+                               columnReal(stmt, LATITUDE), columnReal(stmt, LONGITUDE));
+    }
+    if (rc != SQLITE_DONE) {
+        // Built in place, so what was read stays; a refresh reconciles the rest
+        cerr << "Error loading hotels from database: " << sqlite3_errmsg(db) << endl;
+        timer.fail();
+    }
+    sqlite3_finalize(stmt);
+}
+
+// Update hotel details
+void updateHotel() {
+    int id;
+    cout << "Enter Hotel ID to update: ";
+    cin >> id;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+    HotelNode* hotelNode = hotelList.findHotel(id);
+    if (hotelNode) {
+        Hotel hotel;
+        hotel.id = id;
+        cout << "New name (" << hotelNode->details()->name << "): ";
+        getline(cin, hotel.name);
+        cout << "New services (" << hotelList.servicesOf(hotelNode) << "): ";
+        getline(cin, hotel.services);
+        cout << "New location (" << hotelList.locationOf(hotelNode) << "): ";
+        getline(cin, hotel.location);
+        cout << "New room number (" << hotelNode->roomNumber << "): ";
+        cin >> hotel.roomNumber;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+        string coordinates;
+        cout << "New coordinates as latitude,longitude (";
+        if (hotelNode->details()->hasCoordinates()) {
+            cout << hotelNode->details()->latitude << "," << hotelNode->details()->longitude;
+        } else {
+            cout << "none";
+        }
+        cout << "; blank for none): ";
+        getline(cin, coordinates);
+        if (!parseCoordinates(coordinates, hotel.latitude, hotel.longitude)) {
+            cout << "Error: coordinates must look like 12.03,39.04.\n";
+            return;
+        }
+
+        string message;
+        updateHotelRecord(hotel, message);
+        cout << message << "\n";
+        return;
+    }
+    cout << "Hotel not found!\n";
+}
+
+// View hotels one page at a time
+void viewHotels() {
+    browsePages(PAGE_HOTELS);
+}
+
+// Delete a hotel
+void deleteHotel() {
+    int id;
+    cout << "Enter Hotel ID to delete: ";
+    cin >> id;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+    string message;
+    deleteHotelRecord(id, message);
+    cout << message << "\n";
+}
+
+// Hotel count in every shard, counted on all shards at once
+static void printShardStats() {
+    if (!flushPendingWrites()) cerr << "Warning: counts leave out changes not saved yet." << endl;
+    vector<long long> counts(shards.count(), -1);
+    shards.forEach([&counts](int index) {
+        counts[index] = selectNumber(shards[index].connection, "SELECT COUNT(*) FROM Hotels;");
+    });
+    cout << "\n--- Shards (" << shards.threadCount() << " loader threads) ---\n";
+    long long total = 0;
+    for (int i = 0; i < shards.count(); i++) {
+        cout << left << setw(28) << shards[i].path << right << setw(10) << counts[i] << " hotels\n";
+        total += max(0LL, counts[i]);
+    }
+    cout << left << setw(28) << "total" << right << setw(10) << total << " hotels\n";
+}
+
+// Latency of every operation and SQLite call, statement use, and an optional
+// Prometheus dump for the monitoring host to pick up
+void viewStats() {
+    metrics.printStats(cout);
+    statements.printStats();
+    if (shards.active()) printShardStats();
+
+    string path;
+    cout << "\nWrite Prometheus metrics to file (blank to skip): ";
+    getline(cin, path);
+    if (path.empty()) return;
+    ofstream out(path.c_str());
+    metrics.writePrometheus(out);
+    if (out) cout << "Metrics written to " << path << "\n";
+    else cerr << "Error writing metrics to " << path << endl;
+}
+
+// Customer menu
+void customerMenu() {
+    int choice;
+    do {
+        cout << "\nCustomer Menu\n"
+             << "1. View Hotels\n"
+             << "2. Join Queue\n"
+             << "3. View Queue\n"
+             << "4. Add Itinerary Stop\n"
+             << "5. View Itinerary\n"
+             << "6. Search Hotels by Services\n"
+             << "7. Check My Position\n"
+             << "8. Leave Queue\n"
+             << "9. Find Hotels by Location and Rooms\n"
+             << "10. Hotels Near Itinerary Stops\n"
+             << "11. Find Hotel by Name\n"
+             << "12. Check Free Rooms\n"
+             << "13. Find Hotels with Free Rooms\n"
+             << "14. Book Rooms\n"
+             << "15. Cancel Booking\n"
+             << "16. Back\nChoice: ";
+        cin >> choice;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+        switch(choice) {
+            case 1: viewHotels(); break;
+            case 2: addGuest(); break;
+            case 3: displayGuestQueue(); break;
+            case 4: addStopToItinerary(); break;
+            case 5: viewItinerary(); break;
+            case 6: searchHotelsByServices(); break;
+            case 7: checkQueuePosition(); break;
+            case 8: leaveQueue(); break;
+            case 9: findHotelsByRooms(); break;
+            case 10: findHotelsNearItinerary(); break;
+            case 11: findHotelsByName(); break;
+            case 12: checkFreeRooms(); break;
+            case 13: findFreeHotelsForStay(); break;
+            case 14: bookRooms(); break;
+            case 15: cancelBooking(); break;
+        }
+    } while(choice != 16);
+}
+
+// Find hotels by amenities, e.g. "Pool AND Spa AND NOT Bar"
+void searchHotelsByServices() {
+    const size_t shown = 20;
+    string query;
+    cout << "Services query (AND, OR, NOT, parentheses): ";
+    getline(cin, query);
+
+    vector<HotelNode*> matches;
+    string error;
+    bool valid;
+    {
+        ScopedTimer timer(MET_OP_SEARCH_SERVICES);
+        valid = hotelList.searchByServices(query, matches, error);
+        if (!valid) timer.fail();
+    }
+    if (!valid) {
+        cout << "Invalid query: " << error << "\n";
+        return;
+    }
+    ostringstream out;
+    out << "\n--- " << matches.size() << " matching hotel(s) ---\n";
+    for (size_t i = 0; i < matches.size() && i < shown; i++) {
+        HotelNode* node = matches[i];
+        formatHotel(out, node->id, node->details()->name, hotelList.servicesOf(node), hotelList.locationOf(node),
+                    node->roomNumber);
+    }
+    if (matches.size() > shown) out << "... and " << matches.size() - shown << " more\n";
+    cout << out.str() << flush;
+}
+
+// Typo-tolerant lookup by hotel name, e.g. "Rock Hewn Inn" for "Rock-Hewn Inn"
+void findHotelsByName() {
+    const size_t shown = 10;
+    string query;
+    cout << "Hotel name (spelling need not be exact): ";
+    getline(cin, query);
+
+    vector<TrigramIndex::Match> matches;
+    {
+        ScopedTimer timer(MET_OP_SEARCH_NAMES);
+        hotelList.searchByName(query, shown, matches);
+    }
+    if (matches.empty()) {
+        cout << "No hotel names look like that.\n";
+        return;
+    }
+    ostringstream out;
+    out << "\n--- Closest hotel names ---\n";
+    for (size_t i = 0; i < matches.size(); i++) {
+        HotelNode* node = hotelList.findHotel(matches[i].id);
+        formatHotel(out, node->id, node->details()->name, hotelList.servicesOf(node), hotelList.locationOf(node),
+                    node->roomNumber);
+    }
+    cout << out.str() << flush;
+}
+
+// Typo-tolerant lookup of a queued guest, e.g. "Queen Saba"
+void findGuestsByName() {
+    const size_t shown = 10;
+    string query;
+    cout << "Guest name (spelling need not be exact): ";
+    getline(cin, query);
+
+    vector<TrigramIndex::Match> matches;
+    {
+        ScopedTimer timer(MET_OP_SEARCH_NAMES);
+        guestQueue.searchByName(query, shown, matches);
+    }
+    if (matches.empty()) {
+        cout << "No queued guest names look like that.\n";
+        return;
+    }
+    ostringstream out;
+    out << "\n--- Closest guest names ---\n";
+    for (size_t i = 0; i < matches.size(); i++) {
+        GuestNode* node = guestQueue.findGuest(matches[i].id);
+        formatGuest(out, node->id, node->details->name, node->queuePosition, guestQueue.rankOf(node->id));
+    }
+    cout << out.str() << flush;
+}
+
+// Range and top-k lookups on location and room count, e.g. "Lalibela, at
+// least 20 rooms, largest first"
+void findHotelsByRooms() {
+    const size_t shown = 20;
+    string location, line;
+    int minRooms = 0, maxRooms = numeric_limits<int>::max();
+    cout << "Location (blank for any): ";
+    getline(cin, location);
+    cout << "Minimum rooms (blank for none): ";
+    getline(cin, line);
+    if (!line.empty()) minRooms = atoi(line.c_str());
+    cout << "Maximum rooms (blank for none): ";
+    getline(cin, line);
+    if (!line.empty()) maxRooms = atoi(line.c_str());
+    cout << "Largest first? (y/n): ";
+    getline(cin, line);
+    bool largestFirst = !line.empty() && (line[0] == 'y' || line[0] == 'Y');
+
+    vector<HotelNode*> matches;
+    {
+        ScopedTimer timer(MET_OP_FIND_BY_ROOMS);
+        hotelList.findByRooms(location, minRooms, maxRooms, largestFirst, shown, matches);
+    }
+    ostringstream out;
+    out << "\n--- " << matches.size() << " hotel(s)" << (matches.size() == shown ? " (first " + to_string(shown) + ")" : "")
+        << " ---\n";
+    for (size_t i = 0; i < matches.size(); i++) {
+        HotelNode* node = matches[i];
+        formatHotel(out, node->id, node->details()->name, hotelList.servicesOf(node), hotelList.locationOf(node),
+                    node->roomNumber);
+    }
+    cout << out.str() << flush;
+}
+
+// Ask for check-in and check-out dates; false after telling the user why
+static bool promptStay(int& checkIn, int& checkOut) {
+    string line;
+    cout << "Check-in date (YYYY-MM-DD): ";
+    getline(cin, line);
+    if (!parseDate(line, checkIn)) {
+        cout << "Invalid date.\n";
+        return false;
+    }
+    cout << "Check-out date (YYYY-MM-DD): ";
+    getline(cin, line);
+    if (!parseDate(line, checkOut)) {
+        cout << "Invalid date.\n";
+        return false;
+    }
+    if (checkOut <= checkIn) {
+        cout << "Check-out must be after check-in.\n";
+        return false;
+    }
+    return true;
+}
+
+// Rooms free every night of a stay at one hotel
+void checkFreeRooms() {
+    int id, checkIn, checkOut;
+    cout << "Enter Hotel ID: ";
+    cin >> id;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+    HotelNode* node = hotelList.findHotel(id);
+    if (!node) {
+        cout << "Hotel not found!\n";
+        return;
+    }
+    if (!promptStay(checkIn, checkOut)) return;
+    int free;
+    {
+        ScopedTimer timer(MET_OP_FREE_ROOMS);
+        free = freeRoomsFor(bookings, node, checkIn, checkOut);
+    }
+    cout << node->details()->name << ": " << free << " of " << node->roomNumber << " room(s) free every night from "
+         << formatDate(checkIn) << " to " << formatDate(checkOut) << "\n";
+}
+
+// Which hotels have, say, 3 rooms free from the 12th to the 15th
+void findFreeHotelsForStay() {
+    const size_t shown = 20;
+    string location, line;
+    int checkIn, checkOut;
+    cout << "Location (blank for any): ";
+    getline(cin, location);
+    if (!promptStay(checkIn, checkOut)) return;
+    cout << "Rooms needed: ";
+    getline(cin, line);
+    int rooms = max(1, atoi(line.c_str()));
+
+    vector<FreeHotel> matches;
+    {
+        ScopedTimer timer(MET_OP_FREE_ROOMS);
+        findFreeHotels(hotelList, bookings, location, rooms, checkIn, checkOut, shown, matches);
+    }
+    ostringstream out;
+    out << "\n--- " << matches.size() << " hotel(s) with " << rooms << " room(s) free"
+        << (matches.size() == shown ? " (first " + to_string(shown) + ")" : "") << " ---\n";
+    for (size_t i = 0; i < matches.size(); i++) {
+        HotelNode* node = matches[i].node;
+        out << matches[i].freeRooms << " free: ";
+        formatHotel(out, node->id, node->details()->name, hotelList.servicesOf(node), hotelList.locationOf(node),
+                    node->roomNumber);
+    }
+    cout << out.str() << flush;
+}
+
+void bookRooms() {
+    Booking booking;
+    string line;
+    cout << "Enter Hotel ID: ";
+    cin >> booking.hotelId;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+    if (!promptStay(booking.checkIn, booking.checkOut)) return;
+    cout << "Rooms: ";
+    getline(cin, line);
+    booking.rooms = atoi(line.c_str());
+    cout << "Guest Name: ";
+    getline(cin, booking.guestName);
+
+    string message;
+    bookHotelRooms(booking, message);
+    cout << message << "\n";
+}
+
+void cancelBooking() {
+    int id;
+    cout << "Enter Booking ID: ";
+    cin >> id;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+    string message;
+    cancelBookingRecord(id, message);
+    cout << message << "\n";
+}
+
+// Add a guest to the queue
+void addGuest() {
+    Guest guest;
+    cout << "Enter Guest ID: ";
+    cin >> guest.id;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+    if (!isGuestIdUnique(guest.id)) {
+        cout << "Error: Guest ID already exists. Please enter a unique ID.\n";
+        return;
+    }
+
+    cout << "Enter Guest Name: ";
+    getline(cin, guest.name);
+
+    string message;
+    enqueueGuest(guest, message);
+    cout << message << "\n";
+}
+
+// Save guest to database
+bool saveGuestToDatabase(const Guest& guest) {
+    if (writeBehind.active()) {
+        writeBehind.saveGuest(guest);
+        return true;
+    }
+    sqlite3_stmt* stmt = statements.acquire(STMT_INSERT_GUEST);
+    if (!stmt) {
+        cerr << "Error: insert statement is not prepared" << endl;
+        return false;
+    }
+    bindRecord(stmt, guest);
+
+    bool ok = timedStep(stmt, MET_SQL_INSERT_GUEST) == SQLITE_DONE;
+    if (!ok) {
+        cerr << "Error inserting guest into database: " << sqlite3_errmsg(db) << endl;
+    }
+    statements.release(stmt);
+    return ok;
+}
+
+// Remove a served guest from the database
+bool deleteGuestFromDatabase(int id) {
+    if (writeBehind.active()) {
+        writeBehind.removeGuest(id);
+        return true;
+    }
+    sqlite3_stmt* stmt = statements.acquire(STMT_DELETE_GUEST);
+    if (!stmt) {
+        cerr << "Error: delete statement is not prepared" << endl;
+        return false;
+    }
+    sqlite3_bind_int(stmt, 1, id);
+
+    bool ok = timedStep(stmt, MET_SQL_DELETE_GUEST) == SQLITE_DONE;
+    if (!ok) {
+        cerr << "Error deleting guest from database: " << sqlite3_errmsg(db) << endl;
+    }
+    statements.release(stmt);
+    return ok;
+}
+
+// Load guests from database
+void loadGuestsFromDatabase() {
+    if (!flushPendingWrites()) {
+        cerr << "Error: pending changes are not saved yet; keeping the guest queue in memory." << endl;
+        return;
+    }
+    ScopedTimer timer(MET_SQL_LOAD_GUESTS);
+    guestQueue.clearList();
+    ReadTransaction snapshot(db);
+    changeCursor.guests = currentChangeSeq();
+    guestQueue.reserve(size_t(max(0LL, selectNumber(db, "SELECT COUNT(*) FROM Guests;"))));
+    sqlite3_stmt* stmt;
+
+    constexpr int ID = schemaColumnIndex(&Guest::id), NAME = schemaColumnIndex(&Guest::name),
+                  POSITION = schemaColumnIndex(&Guest::queuePosition);
+    if (sqlite3_prepare_v2(db, LOAD_GUESTS_SQL.c_str(), -1, &stmt, NULL) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            string_view name = columnText(stmt, NAME);
+            guestQueue.emplaceGuest(sqlite3_column_int(stmt, ID), string(name), sqlite3_column_int(stmt, POSITION));
+        }
+        sqlite3_finalize(stmt);
+    } else {
+        cerr << "Error loading guests from database: " << sqlite3_errmsg(db) << endl;
+    }
+}
+
+// Load bookings from database, rebuilding each hotel's room calendar
+void loadBookingsFromDatabase() {
+    ScopedTimer timer(MET_SQL_LOAD_BOOKINGS);
+    bookings.clear();
+    char* sql = (char*) "SELECT id, hotelId, guestName, checkIn, checkOut, rooms FROM Bookings;";
+    sqlite3_stmt* stmt;
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        cerr << "Error loading bookings from database: " << sqlite3_errmsg(db) << endl;
+        timer.fail();
+        return;
+    }
+    long skipped = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        Booking booking;
+        booking.id = sqlite3_column_int(stmt, 0);
+        booking.hotelId = sqlite3_column_int(stmt, 1);
+        booking.guestName = string(columnText(stmt, 2));
+        booking.rooms = sqlite3_column_int(stmt, 5);
+        if (!parseDate(string(columnText(stmt, 3)), booking.checkIn) ||
+            !parseDate(string(columnText(stmt, 4)), booking.checkOut) || booking.nights() < 1 || booking.rooms < 1) {
+            skipped++;
+            continue;
+        }
+        bookings.add(booking);
+    }
+    sqlite3_finalize(stmt);
+    if (skipped) cerr << "Skipped " << skipped << " booking(s) with unreadable dates or room counts" << endl;
+}
+
+// Serve the next guest in the queue
+void serveGuest() {
+    Guest servedGuest;
+    string message;
+    serveNextGuest(servedGuest, message);
+    cout << message << "\n";
+}
+
+// Pick up changes other processes made to the database
+void refreshData() {
+    string message;
+    refreshFromDatabase(message);
+    cout << message << "\n";
+}
+
+// Show a guest where they currently stand in line
+void checkQueuePosition() {
+    int id;
+    cout << "Enter Guest ID: ";
+    cin >> id;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+    GuestNode* node = guestQueue.findGuest(id);
+    if (!node) {
+        cout << "Guest not found in the queue.\n";
+        return;
+    }
+    int position = guestQueue.rankOf(id);
+    cout << node->details->name << " is number " << position << " in line (Ticket #" << node->queuePosition
+         << ", " << position - 1 << " ahead)\n";
+}
+
+// Let a guest leave the queue from wherever they are
+void leaveQueue() {
+    int id;
+    cout << "Enter Guest ID: ";
+    cin >> id;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+    string message;
+    cancelGuest(id, message);
+    cout << message << "\n";
+}
+
+// Display the guest queue one page at a time
+void displayGuestQueue() {
+    browsePages(PAGE_GUESTS);
+}
+
+// Add a stop to the itinerary
+void addStopToItinerary() {
+    string description, line;
+    cout << "Enter stop: ";
+    getline(cin, description);
+    ItineraryStop stop(description);
+    cout << "Coordinates as latitude,longitude (blank for none): ";
+    getline(cin, line);
+    if (!parseCoordinates(line, stop.latitude, stop.longitude)) {
+        cout << "Error: coordinates must look like 12.03,39.04.\n";
+        return;
+    }
+    string message;
+    addItineraryStop(stop, message);
+    cout << message << "\n";
+}
+
+// View the itinerary
+void viewItinerary() {
+    cout << "\n--- Itinerary ---\n";
+    for (list<ItineraryStop>::iterator stop_iter = itinerary.begin(); stop_iter != itinerary.end(); ++stop_iter) {
+        cout << stop_iter->description;
+        if (stop_iter->hasCoordinates()) {
+            cout << " (" << fixed << setprecision(4) << stop_iter->latitude << ", " << stop_iter->longitude << ")"
+                 << defaultfloat;
+        }
+        cout << "\n";
+    }
+}
+
+// The closest hotels to every itinerary stop that has coordinates
+void findHotelsNearItinerary() {
+    size_t k = 3;
+    string line;
+    cout << "Hotels per stop (blank for " << k << "): ";
+    getline(cin, line);
+    if (!line.empty() && atoi(line.c_str()) > 0) k = size_t(atoi(line.c_str()));
+
+    ostringstream out;
+    out << fixed << setprecision(2);
+    vector<GeoIndex::Match> matches;
+    for (list<ItineraryStop>::iterator stop_iter = itinerary.begin(); stop_iter != itinerary.end(); ++stop_iter) {
+        out << "\n--- " << stop_iter->description << " ---\n";
+        if (!stop_iter->hasCoordinates()) {
+            out << "No coordinates for this stop.\n";
+            continue;
+        }
+        {
+            ScopedTimer timer(MET_OP_NEAREST_HOTELS);
+            hotelList.nearestHotels(stop_iter->latitude, stop_iter->longitude, k, matches);
+        }
+        if (matches.empty()) out << "No hotels with coordinates.\n";
+        for (size_t i = 0; i < matches.size(); i++) {
+            out << matches[i].km << " km: " << matches[i].node->details()->name << " (ID " << matches[i].node->id
+                << ", " << matches[i].node->roomNumber << " rooms)\n";
+        }
+    }
+    cout << out.str() << flush;
+}
+
+
+// ---------------------------------------------------------------------------
+// Operations
+// Every change to the catalogue, queue and itinerary, without prompts. The
+// menus and the command engine both come through here, so memory and the
+// database stay in step however a request arrives. If the database write
+// fails the in-memory change is undone and false is returned.
+// ---------------------------------------------------------------------------
+
+// The record is saved first and then moved into the list, which cannot fail
+// once the id is known to be free
+bool addHotelRecord(Hotel&& hotel, string& message) {
+    ScopedTimer timer(MET_OP_ADD_HOTEL);
+    if (hotel.roomNumber < 0) {
+        message = "Error: room number cannot be negative.";
+        timer.fail();
+        return false;
+    }
+    if (!validCoordinates(hotel.latitude, hotel.longitude)) {
+        message = "Error: coordinates are out of range.";
+        timer.fail();
+        return false;
+    }
+    if (!hotelList.isHotelIdUnique(hotel.id)) {
+        message = "Error: Hotel ID already exists.";
+        timer.fail();
+        return false;
+    }
+    if (!saveHotelToDatabase(hotel)) {
+        message = "Error: hotel could not be saved.";
+        timer.fail();
+        return false;
+    }
+    hotelList.addHotel(std::move(hotel));
+    message = "Hotel added successfully!";
+    return true;
+}
+
+bool updateHotelRecord(const Hotel& hotel, string& message) {
+    ScopedTimer timer(MET_OP_UPDATE_HOTEL);
+    if (hotel.roomNumber < 0) {
+        message = "Error: room number cannot be negative.";
+        timer.fail();
+        return false;
+    }
+    if (!validCoordinates(hotel.latitude, hotel.longitude)) {
+        message = "Error: coordinates are out of range.";
+        timer.fail();
+        return false;
+    }
+    HotelNode* node = hotelList.findHotel(hotel.id);
+    if (!node) {
+        message = "Hotel not found!";
+        timer.fail();
+        return false;
+    }
+    if (!roomsCoverBookings(bookings, hotel.id, hotel.roomNumber, message)) {
+        timer.fail();
+        return false;
+    }
+    Hotel previous = hotelList.toHotel(node);
+    hotelList.updateHotel(hotel);
+    if (!updateHotelInDatabase(hotel, previous.location)) {
+        hotelList.updateHotel(previous);
+        message = "Error: hotel could not be updated.";
+        timer.fail();
+        return false;
+    }
+    message = "Hotel updated successfully!";
+    return true;
+}
+
+bool deleteHotelRecord(int id, string& message) {
+    ScopedTimer timer(MET_OP_DELETE_HOTEL);
+    HotelNode* node = hotelList.findHotel(id);
+    if (!node) {
+        message = "Hotel not found!";
+        timer.fail();
+        return false;
+    }
+    if (bookings.bookingCount(id) > 0) {
+        message = "Error: hotel still has " + to_string(bookings.bookingCount(id)) + " booking(s); cancel them first.";
+        timer.fail();
+        return false;
+    }
+    Hotel previous = hotelList.toHotel(node);
+    hotelList.removeHotel(id);
+    if (!deleteHotelFromDatabase(id, previous.location)) {
+        hotelList.addHotel(std::move(previous));
+        message = "Error: hotel could not be deleted.";
+        timer.fail();
+        return false;
+    }
+    message = "Hotel deleted successfully!";
+    return true;
+}
+
+// Issues the guest a ticket and stores it in guest.queuePosition
+bool enqueueGuest(Guest& guest, string& message) {
+    ScopedTimer timer(MET_OP_ENQUEUE_GUEST);
+    if (!guestQueue.isGuestIdUnique(guest.id)) {
+        message = "Error: Guest ID already exists.";
+        timer.fail();
+        return false;
+    }
+    guest.queuePosition = guestQueue.issueTicket();
+    guestQueue.addGuest(guest);
+    if (!saveGuestToDatabase(guest)) {
+        guestQueue.removeGuest(guest.id);
+        message = "Error: guest could not be saved.";
+        timer.fail();
+        return false;
+    }
+    ostringstream out;
+    out << "Guest added to queue! Position: " << guestQueue.rankOf(guest.id) << " (Ticket #" << guest.queuePosition << ")";
+    message = out.str();
+    return true;
+}
+
+bool serveNextGuest(Guest& served, string& message) {
+    ScopedTimer timer(MET_OP_SERVE_GUEST);
+    if (!guestQueue.head) {
+        message = "Queue is empty!";
+        timer.fail();
+        return false;
+    }
+    served = guestQueue.serveGuest();
+    if (!deleteGuestFromDatabase(served.id)) {
+        guestQueue.takeBack(served); // Its ticket puts it back at the head
+        message = "Error: guest could not be removed from the database.";
+        timer.fail();
+        return false;
+    }
+    message = "Serving guest: " + served.name + " (ID: " + to_string(served.id) + ")";
+    return true;
+}
+
+bool cancelGuest(int id, string& message) {
+    ScopedTimer timer(MET_OP_CANCEL_GUEST);
+    GuestNode* node = guestQueue.findGuest(id);
+    if (!node) {
+        message = "Guest not found in the queue.";
+        timer.fail();
+        return false;
+    }
+    Guest previous = node->toGuest();
+    guestQueue.removeGuest(id);
+    if (!deleteGuestFromDatabase(id)) {
+        guestQueue.takeBack(previous);
+        message = "Error: guest could not be removed from the database.";
+        timer.fail();
+        return false;
+    }
+    message = "Guest left the queue.";
+    return true;
+}
+
+// Move a hotel, or clear its position with NaN coordinates
+bool setHotelCoordinates(int id, double latitude, double longitude, string& message) {
+    HotelNode* node = hotelList.findHotel(id);
+    if (!node) {
+        message = "Hotel not found!";
+        return false;
+    }
+    Hotel hotel = hotelList.toHotel(node);
+    hotel.latitude = latitude;
+    hotel.longitude = longitude;
+    return updateHotelRecord(hotel, message);
+}
+
+// Bookings are written straight to the main file even with write-behind on:
+// a stay is only confirmed once it is on disk. The check and the booking run
+// under the same exclusive lock in server mode, so two desks cannot both take
+// the last room, and the row covers every night, so a stay is never half booked.
+static bool saveBookingToDatabase(const Booking& booking) {
+    sqlite3_stmt* stmt = statements.acquire(STMT_INSERT_BOOKING);
+    if (!stmt) {
+        cerr << "Error: insert statement is not prepared" << endl;
+        return false;
+    }
+    string checkIn = formatDate(booking.checkIn), checkOut = formatDate(booking.checkOut);
+    sqlite3_bind_int(stmt, 1, booking.id);
+    sqlite3_bind_int(stmt, 2, booking.hotelId);
+    sqlite3_bind_text(stmt, 3, booking.guestName.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, checkIn.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, checkOut.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 6, booking.rooms);
+
+    bool ok = timedStep(stmt, MET_SQL_INSERT_BOOKING) == SQLITE_DONE;
+    if (!ok) {
+        cerr << "Error inserting booking into database: " << sqlite3_errmsg(db) << endl;
+    }
+    statements.release(stmt);
+    return ok;
+}
+
+static bool deleteBookingFromDatabase(int id) {
+    sqlite3_stmt* stmt = statements.acquire(STMT_DELETE_BOOKING);
+    if (!stmt) {
+        cerr << "Error: delete statement is not prepared" << endl;
+        return false;
+    }
+    sqlite3_bind_int(stmt, 1, id);
+
+    bool ok = timedStep(stmt, MET_SQL_DELETE_BOOKING) == SQLITE_DONE;
+    if (!ok) {
+        cerr << "Error deleting booking from database: " << sqlite3_errmsg(db) << endl;
+    }
+    statements.release(stmt);
+    return ok;
+}
+
+// Holds booking.rooms rooms for every night of the stay and fills in
+// booking.id; nothing is booked unless all the nights have the rooms free
+bool bookHotelRooms(Booking& booking, string& message) {
+    ScopedTimer timer(MET_OP_BOOK_ROOMS);
+    HotelNode* node = hotelList.findHotel(booking.hotelId);
+    if (!node) {
+        message = "Hotel not found!";
+        timer.fail();
+        return false;
+    }
+    if (booking.rooms < 1 || booking.nights() < 1 || booking.nights() > MAX_STAY_NIGHTS) {
+        message = "Error: book at least one room for 1 to " + to_string(MAX_STAY_NIGHTS) + " nights.";
+        timer.fail();
+        return false;
+    }
+    int free = freeRoomsFor(bookings, node, booking.checkIn, booking.checkOut);
+    if (free < booking.rooms) {
+        message = "Sorry, only " + to_string(free) + " room(s) free every night from " + formatDate(booking.checkIn) +
+                  " to " + formatDate(booking.checkOut) + ".";
+        timer.fail();
+        return false;
+    }
+    booking.id = bookings.nextBookingId();
+    if (!saveBookingToDatabase(booking)) {
+        message = "Error: booking could not be saved.";
+        timer.fail();
+        return false;
+    }
+    bookings.add(booking);
+    message = "Booked " + to_string(booking.rooms) + " room(s) at " + node->details()->name + " from " +
+              formatDate(booking.checkIn) + " to " + formatDate(booking.checkOut) + " (Booking #" +
+              to_string(booking.id) + ")";
+    return true;
+}
+
+bool cancelBookingRecord(int id, string& message) {
+    ScopedTimer timer(MET_OP_CANCEL_BOOKING);
+    if (!bookings.findBooking(id)) {
+        message = "Booking not found!";
+        timer.fail();
+        return false;
+    }
+    if (!deleteBookingFromDatabase(id)) {
+        message = "Error: booking could not be cancelled.";
+        timer.fail();
+        return false;
+    }
+    bookings.remove(id);
+    message = "Booking #" + to_string(id) + " cancelled.";
+    return true;
+}
+
+bool addItineraryStop(const ItineraryStop& stop, string& message) {
+    ScopedTimer timer(MET_OP_ADD_STOP);
+    if (stop.description.empty()) {
+        message = "Error: stop is empty.";
+        timer.fail();
+        return false;
+    }
+    if (!validCoordinates(stop.latitude, stop.longitude)) {
+        message = "Error: coordinates are out of range.";
+        timer.fail();
+        return false;
+    }
+    itinerary.push_back(stop);
+    message = "Stop added to itinerary!";
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------
+// Paged listings
+// Pages are read from SQLite with keyset queries (WHERE key > last ORDER BY
+// key LIMIT n), so fetching any page costs the same however large the table
+// is. Each page is rendered into one buffer and written in a single call.
+// ---------------------------------------------------------------------------
+
+const int DEFAULT_PAGE_SIZE = 10;
+
+// Position of a page in its listing. Hotels are keyed by id; the guest queue
+// by (queuePosition, id).
+struct PageCursor {
+    int firstPosition, firstId; // Key of the first row shown
+    int lastPosition, lastId;   // Key of the last row shown
+};
+
+struct PageRow {
+    pair<int, int> key; // (queuePosition, id) for guests; (0, id) for hotels
+    string text;
+};
+
+// Read and render up to limit rows from a stepped page statement
+static void readPageRows(sqlite3* connection, sqlite3_stmt* stmt, PageSource source, int limit, vector<PageRow>& rows) {
+    int rc = SQLITE_DONE;
+    while (int(rows.size()) < limit && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        ostringstream text;
+        PageRow row;
+        if (source == PAGE_HOTELS) {
+            Hotel hotel;
+            readRecord(stmt, hotel);
+            formatHotel(text, hotel.id, hotel.name, hotel.services, hotel.location, hotel.roomNumber);
+            row.key = make_pair(0, hotel.id);
+        } else {
+            // The stored column is the ticket; the place in line comes from the rank tree
+            Guest guest;
+            readRecord(stmt, guest);
+            formatGuest(text, guest.id, guest.name, guest.queuePosition, guestQueue.rankOf(guest.id));
+            row.key = make_pair(guest.queuePosition, guest.id);
+        }
+        row.text = text.str();
+        rows.push_back(row);
+    }
+    if (int(rows.size()) < limit && rc != SQLITE_DONE) {
+        cerr << "Error reading page: " << sqlite3_errmsg(connection) << endl;
+    }
+}
+
+static bool pageRowBefore(const PageRow& a, const PageRow& b) { return a.key < b.key; }
+static bool pageRowAfter(const PageRow& a, const PageRow& b) { return b.key < a.key; }
+
+// Fetch up to limit rows after (or, if backwards, before) the given key and
+// render them into out in listing order. Returns the number of rows rendered
+// and sets hasMore when further rows exist in that direction. With shards,
+// every shard fetches its own next limit + 1 hotels and the union is cut back
+// to the first limit + 1.
+int fetchPage(PageSource source, int afterPosition, int afterId, bool backwards, int limit,
+              ostream& out, PageCursor& cursor, bool& hasMore) {
+    ScopedTimer timer(MET_SQL_PAGE_QUERY);
+    StatementId id;
+    if (source == PAGE_HOTELS) id = backwards ? STMT_HOTEL_PAGE_PREV : STMT_HOTEL_PAGE_NEXT;
+    else id = backwards ? STMT_GUEST_PAGE_PREV : STMT_GUEST_PAGE_NEXT;
+
+    // Rows come back in key order, or reversed for a backwards fetch.
+    // One extra row tells us whether there is more.
+    vector<PageRow> rows;
+    if (source == PAGE_HOTELS && shards.active()) {
+        vector<vector<PageRow> > shardRows(shards.count());
+        shards.forEach([&](int index) {
+            ShardSet::Shard& shard = shards[index];
+            sqlite3_stmt* stmt = shard.statements.acquire(id);
+            sqlite3_bind_int(stmt, 1, afterId);
+            sqlite3_bind_int(stmt, 2, limit + 1);
+            readPageRows(shard.connection, stmt, source, limit + 1, shardRows[index]);
+            shard.statements.release(stmt);
+        });
+        for (size_t i = 0; i < shardRows.size(); i++) rows.insert(rows.end(), shardRows[i].begin(), shardRows[i].end());
+        sort(rows.begin(), rows.end(), backwards ? pageRowAfter : pageRowBefore);
+        if (int(rows.size()) > limit + 1) rows.resize(limit + 1);
+    } else {
+        sqlite3_stmt* stmt = statements.acquire(id);
+        if (!stmt) {
+            cerr << "Error: page statement is not prepared" << endl;
+            return 0;
+        }
+        int param = 1;
+        if (source == PAGE_GUESTS) sqlite3_bind_int(stmt, param++, afterPosition);
+        sqlite3_bind_int(stmt, param++, afterId);
+        sqlite3_bind_int(stmt, param, limit + 1);
+        readPageRows(db, stmt, source, limit + 1, rows);
+        statements.release(stmt);
+    }
+
+    hasMore = int(rows.size()) > limit;
+    if (hasMore) rows.pop_back();
+    if (rows.empty()) return 0;
+    if (backwards) reverse(rows.begin(), rows.end());
+    for (size_t i = 0; i < rows.size(); i++) out << rows[i].text;
+    cursor.firstPosition = rows.front().key.first;
+    cursor.firstId = rows.front().key.second;
+    cursor.lastPosition = rows.back().key.first;
+    cursor.lastId = rows.back().key.second;
+    return int(rows.size());
+}
+
+// Interactive pager: next/prev page, jump to an id, change page size
+void browsePages(PageSource source) {
+    // Pages are read back from SQLite
+    if (!flushPendingWrites()) cerr << "Warning: pages leave out changes not saved yet." << endl;
+    const char* title = source == PAGE_HOTELS ? "Hotel List" : "Guest Queue";
+    int pageSize = DEFAULT_PAGE_SIZE;
+    int startPosition = numeric_limits<int>::min();
+    int startId = numeric_limits<int>::min();
+    bool backwards = false;
+    PageCursor cursor = {startPosition, startId, startPosition, startId};
+    bool shown = false; // Whether cursor holds a page that was displayed
+
+    while (true) {
+        ostringstream page;
+        bool hasMore;
+        page << "\n--- " << title << " ---\n";
+        int rows = fetchPage(source, startPosition, startId, backwards, pageSize, page, cursor, hasMore);
+        if (rows == 0 && shown) {
+            // Nothing further that way: stay on the page we were showing
+            page << (backwards ? "Already at the first page.\n" : "Already at the last page.\n");
+            rows = fetchPage(source, cursor.firstPosition, cursor.firstId - 1, false, pageSize, page, cursor, hasMore);
+        }
+        if (rows == 0) {
+            page << "No entries.\n";
+        }
+        shown = rows > 0;
+        page << "[n]ext, [p]rev, [g]o to id, [s]ize (" << pageSize << "), [q]uit: ";
+        {
+            ScopedTimer timer(MET_OP_CONSOLE_WRITE);
+            cout << page.str() << flush;
+        }
+
+        string command;
+        if (!getline(cin, command) || command.empty() || command[0] == 'q') return;
+        switch (command[0]) {
+            case 'n':
+                startPosition = cursor.lastPosition;
+                startId = cursor.lastId;
+                backwards = false;
+                break;
+            case 'p':
+                startPosition = cursor.firstPosition;
+                startId = cursor.firstId;
+                backwards = true;
+                break;
+            case 'g': {
+                int id;
+                cout << "Start from ID: ";
+                cin >> id;
+                cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+                // Hotels resume at the id itself; the queue resumes at that guest's place
+                startPosition = numeric_limits<int>::min();
+                startId = id - 1;
+                if (source == PAGE_GUESTS) {
+                    GuestNode* node = guestQueue.findGuest(id);
+                    if (node) startPosition = node->queuePosition;
+                }
+                backwards = false;
+                break;
+            }
+            case 's':
+                cout << "Page size: ";
+                cin >> pageSize;
+                cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+                if (pageSize < 1) pageSize = DEFAULT_PAGE_SIZE;
+                startPosition = cursor.firstPosition; // Redraw from the current first row
+                startId = cursor.firstId - 1;
+                backwards = false;
+                break;
+        }
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// Binary snapshot
+// On clean shutdown the hotels and guest queue are written to one file:
+//
+//   SnapshotHeader
+//   hotel records: int32 id, int32 roomNumber, uint32 name/services/location
+//                  lengths, double latitude/longitude (NaN when unknown),
+//                  then the three strings' bytes
+//   guest records: int32 id, int32 queuePosition, uint32 name length, name
+//
+// Records are written and read by encodeRecord() and decodeRecord(), which
+// derive this layout from the record schemas.
+//
+// Integers are stored in host byte order (checked through byteOrder). On
+// startup the file is memory-mapped, verified and loaded straight into the
+// slab pools, and only ChangeLog entries newer than the snapshot are read
+// back from SQLite. Any mismatch falls back to the full database load.
+// ---------------------------------------------------------------------------
+
+const uint32_t SNAPSHOT_VERSION = 2; // 2 added hotel coordinates
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];        // "CMSSNAP\0"
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t hotelCount;
+    uint64_t guestCount;
+    int64_t changeSeq;    // Last ChangeLog sequence the snapshot includes
+    uint64_t payloadBytes;
+    uint64_t checksum;    // FNV-1a over the payload
+};
+
+static void snapshotChecksum(uint64_t& hash, const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+const uint64_t SNAPSHOT_CHECKSUM_SEED = 14695981039346656037ULL;
+
+// The snapshot this session started from or last wrote, which change-log
+// compaction must not trim past; empty when there is none
+static string sessionSnapshotPath;
+
+// Read-only view of a whole file
+class MappedFile {
+public:
+    MappedFile() : data(NULL), length(0) {
+#ifdef _WIN32
+        file = INVALID_HANDLE_VALUE;
+        mapping = NULL;
+#else
+        fd = -1;
+#endif
+    }
+    ~MappedFile() { close(); }
+
+    bool open(const char* path) {
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) return false;
+        length = size_t(size.QuadPart);
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping) return false;
+        data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        return data != NULL;
+#else
+        fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) return false;
+        length = size_t(info.st_size);
+        void* mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) return false;
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        data = (const char*)mapped;
+        return true;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+        mapping = NULL;
+#else
+        if (data) munmap((void*)data, length);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        data = NULL;
+        length = 0;
+    }
+
+    const char* bytes() const { return data; }
+    size_t size() const { return length; }
+
+private:
+    const char* data;
+    size_t length;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+// Load hotels and guests from a snapshot file, then replay later changes.
+// Returns false, leaving both lists empty, if the snapshot cannot be used.
+bool loadSnapshot(const char* path) {
+    if (shards.active()) return false; // The change log covers the main file only; shards load in parallel instead
+    sessionSnapshotPath = path;
+    ScopedTimer timer(MET_SNAPSHOT_LOAD);
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    SnapshotHeader header;
+    if (file.size() < sizeof(header)) return false;
+    memcpy(&header, file.bytes(), sizeof(header));
+    if (memcmp(header.magic, "CMSSNAP", 8) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.byteOrder != SNAPSHOT_BYTE_ORDER || header.payloadBytes != file.size() - sizeof(header)) {
+        cerr << "Snapshot " << path << " has an unknown format; loading from the database.\n";
+        timer.fail();
+        return false;
+    }
+    const char* payload = file.bytes() + sizeof(header);
+    uint64_t checksum = SNAPSHOT_CHECKSUM_SEED;
+    snapshotChecksum(checksum, payload, size_t(header.payloadBytes));
+    if (checksum != header.checksum) {
+        cerr << "Snapshot " << path << " failed its checksum; loading from the database.\n";
+        timer.fail();
+        return false;
+    }
+    long long seq = currentChangeSeq();
+    if (seq < header.changeSeq) {
+        cerr << "Snapshot " << path << " is newer than the database; loading from the database.\n";
+        timer.fail();
+        return false;
+    }
+
+    hotelList.clearList();
+    guestQueue.clearList();
+    hotelList.reserve(size_t(header.hotelCount));
+    const char* cursor = payload;
+    const char* end = payload + header.payloadBytes;
+    bool ok = true;
+    Hotel hotel;
+    for (uint64_t i = 0; ok && i < header.hotelCount; i++) {
+        ok = decodeRecord(cursor, end, hotel);
+        if (ok) hotelList.addHotel(std::move(hotel));
+    }
+    Guest guest;
+    for (uint64_t i = 0; ok && i < header.guestCount; i++) {
+        ok = decodeRecord(cursor, end, guest);
+        if (ok) guestQueue.addGuest(guest);
+    }
+    if (!ok || cursor != end) {
+        cerr << "Snapshot " << path << " is damaged; loading from the database.\n";
+        hotelList.clearList();
+        guestQueue.clearList();
+        timer.fail();
+        return false;
+    }
+    if (!replayChangesSince(header.changeSeq)) {
+        cerr << "Snapshot " << path << " is older than the change log reaches; loading from the database.\n";
+        hotelList.clearList();
+        guestQueue.clearList();
+        timer.fail();
+        return false;
+    }
+    return true;
+}
+
+enum SyncResult { SYNC_OK, SYNC_GAP, SYNC_FAILED };
+
+static bool sameHotel(const Hotel& a, const Hotel& b) {
+    return a.id == b.id && a.name == b.name && a.services == b.services && a.location == b.location &&
+           a.roomNumber == b.roomNumber && (a.latitude == b.latitude || (std::isnan(a.latitude) && std::isnan(b.latitude))) &&
+           (a.longitude == b.longitude || (std::isnan(a.longitude) && std::isnan(b.longitude)));
+}
+
+// Apply the rows a file's change log records as changed after the given
+// positions, then advance them to the log's end. A NULL position skips that
+// table. Each row is re-read, so it is applied once however often it
+// changed, rows memory already matches are left alone, and replaying a
+// change twice is harmless. Gives SYNC_GAP, applying nothing, when a
+// position is -1 or the log has been trimmed past it. shard is the shard
+// the file holds, or -1 for the main file; a hotel gone from one shard is
+// only removed if memory places it there, since it may have moved to another.
+static SyncResult syncFromChangeLog(sqlite3* connection, StatementCache& cache, int shard, long long* hotelSeq,
+                                    long long* guestSeq, long& applied) {
+    ScopedTimer timer(MET_SQL_REPLAY_CHANGES);
+    const long long SKIP = numeric_limits<long long>::max();
+    applied = 0;
+    long long from = min(hotelSeq ? *hotelSeq : SKIP, guestSeq ? *guestSeq : SKIP);
+    if (from == SKIP) return SYNC_OK;
+    if (from < 0) return SYNC_GAP;
+
+    ReadTransaction snapshot(connection);
+    long long end = currentChangeSeq(connection);
+    long long first = selectNumber(connection, "SELECT COALESCE(MIN(seq), 0) FROM ChangeLog;");
+    if (end < 0 || first < 0) {
+        timer.fail();
+        return SYNC_FAILED;
+    }
+    if (first == 0) first = end + 1; // Empty log
+    if (first > from + 1) return SYNC_GAP;
+
+    sqlite3_stmt* changes;
+    if (sqlite3_prepare_v2(connection,
+                           "SELECT tableName, rowId FROM ChangeLog WHERE seq > ?1 AND "
+                           "((tableName = 'Hotels' AND seq > ?2) OR (tableName = 'Guests' AND seq > ?3)) "
+                           "GROUP BY tableName, rowId ORDER BY MAX(seq);",
+                           -1, &changes, NULL) != SQLITE_OK) {
+        cerr << "Error reading change log: " << sqlite3_errmsg(connection) << endl;
+        timer.fail();
+        return SYNC_FAILED;
+    }
+    sqlite3_bind_int64(changes, 1, from);
+    sqlite3_bind_int64(changes, 2, hotelSeq ? *hotelSeq : SKIP);
+    sqlite3_bind_int64(changes, 3, guestSeq ? *guestSeq : SKIP);
+    int rc;
+    while ((rc = sqlite3_step(changes)) == SQLITE_ROW) {
+        bool hotels = strcmp((const char*)sqlite3_column_text(changes, 0), "Hotels") == 0;
+        int id = sqlite3_column_int(changes, 1);
+        sqlite3_stmt* row = cache.acquire(hotels ? STMT_SELECT_HOTEL : STMT_SELECT_GUEST);
+        sqlite3_bind_int(row, 1, id);
+        bool exists = sqlite3_step(row) == SQLITE_ROW;
+        if (hotels) {
+            HotelNode* node = hotelList.findHotel(id);
+            if (exists) {
+                Hotel hotel;
+                readRecord(row, hotel);
+                if (!node) {
+                    hotelList.addHotel(std::move(hotel));
+                    applied++;
+                } else if (!sameHotel(hotelList.toHotel(node), hotel)) {
+                    hotelList.updateHotel(hotel);
+                    applied++;
+                }
+            } else if (node && (shard < 0 || shards.shardFor(hotelList.locationOf(node)) == shard)) {
+                hotelList.removeHotel(id);
+                applied++;
+            }
+        } else {
+            GuestNode* node = guestQueue.findGuest(id);
+            if (exists) {
+                string_view name = columnText(row, schemaColumnIndex(&Guest::name));
+                int queuePosition = sqlite3_column_int(row, schemaColumnIndex(&Guest::queuePosition));
+                if (!node || node->details->name != name || node->queuePosition != queuePosition) {
+                    guestQueue.removeGuest(id);
+                    guestQueue.emplaceGuest(id, string(name), queuePosition);
+                    applied++;
+                }
+            } else if (guestQueue.removeGuest(id)) {
+                applied++;
+            }
+        }
+        cache.release(row);
+    }
+    sqlite3_finalize(changes);
+    if (rc != SQLITE_DONE) {
+        timer.fail();
+        return SYNC_FAILED;
+    }
+    if (hotelSeq) *hotelSeq = end;
+    if (guestSeq) *guestSeq = end;
+    return SYNC_OK;
+}
+
+// Bring the in-memory lists up to date with rows changed after seq
+bool replayChangesSince(long long seq) {
+    ChangeCursor cursor = {seq, seq};
+    long applied;
+    if (syncFromChangeLog(db, statements, -1, &cursor.hotels, &cursor.guests, applied) != SYNC_OK) return false;
+    changeCursor = cursor;
+    return true;
+}
+
+// Drop change-log entries up to and including seq; returns how many went
+static long trimChangeLog(sqlite3* connection, long long seq) {
+    if (seq <= 0) return 0;
+    sqlite3_stmt* trim;
+    long trimmed = 0;
+    if (sqlite3_prepare_v2(connection, "DELETE FROM ChangeLog WHERE seq <= ?;", -1, &trim, NULL) == SQLITE_OK) {
+        sqlite3_bind_int64(trim, 1, seq);
+        if (sqlite3_step(trim) == SQLITE_DONE) trimmed = sqlite3_changes(connection);
+        sqlite3_finalize(trim);
+    }
+    return trimmed;
+}
+
+static bool writeSnapshotBytes(ofstream& out, uint64_t& checksum, const void* data, size_t length) {
+    snapshotChecksum(checksum, (const char*)data, length);
+    out.write((const char*)data, streamsize(length));
+    return bool(out);
+}
+
+// Write the current lists to a snapshot, replacing the old one atomically.
+// The change log up to the snapshot point is no longer needed and is trimmed.
+// That point is where memory stands in the log, not the log's end: changes
+// other processes made since the last refresh are not in memory yet.
+bool writeSnapshot(const char* path) {
+    if (shards.active()) return false;
+    sessionSnapshotPath = path;
+    // Our own changes are then in the log, and replaying them is harmless
+    if (!flushPendingWrites()) {
+        cerr << "Error writing snapshot: pending changes are not saved yet." << endl;
+        return false;
+    }
+    ScopedTimer timer(MET_SNAPSHOT_WRITE);
+    long long seq = min(changeCursor.hotels, changeCursor.guests);
+    if (seq < 0) return false;
+
+    string tempPath = string(path) + ".tmp";
+    ofstream out(tempPath.c_str(), ios::binary | ios::trunc);
+    if (!out) {
+        cerr << "Error writing snapshot: cannot create " << tempPath << endl;
+        timer.fail();
+        return false;
+    }
+    vector<char> buffer(1 << 20);
+    out.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "CMSSNAP", 8);
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.changeSeq = seq;
+    out.write((const char*)&header, sizeof(header)); // Rewritten once the payload is known
+
+    uint64_t checksum = SNAPSHOT_CHECKSUM_SEED;
+    uint64_t payloadBytes = 0;
+    bool ok = bool(out);
+    string record; // Reused, as are the records' strings, so steady state allocates nothing
+    Hotel hotel;
+    HotelLinkedList::ReadSnapshot hotels(hotelList);
+    for (const HotelNode* node = hotels.first(); ok && node; node = hotels.next(node)) {
+        const HotelDetails* details = hotels.recordOf(node);
+        hotel.id = node->id;
+        hotel.name = details->name;
+        hotel.services = hotelList.servicesOf(details);
+        hotel.location = hotelList.locationOf(details);
+        hotel.roomNumber = details->roomNumber;
+        hotel.latitude = details->latitude;
+        hotel.longitude = details->longitude;
+        record.clear();
+        encodeRecord(hotel, record);
+        ok = writeSnapshotBytes(out, checksum, record.data(), record.size());
+        payloadBytes += record.size();
+        header.hotelCount++;
+    }
+    Guest guest;
+    for (GuestNode* node = guestQueue.head; ok && node; node = node->next) {
+        guest.id = node->id;
+        guest.name = node->details->name;
+        guest.queuePosition = node->queuePosition;
+        record.clear();
+        encodeRecord(guest, record);
+        ok = writeSnapshotBytes(out, checksum, record.data(), record.size());
+        payloadBytes += record.size();
+        header.guestCount++;
+    }
+    header.payloadBytes = payloadBytes;
+    header.checksum = checksum;
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+    out.close();
+    ok = ok && !out.fail();
+
+#ifdef _WIN32
+    if (ok) remove(path); // rename() does not replace on Windows
+#endif
+    if (!ok || rename(tempPath.c_str(), path) != 0) {
+        cerr << "Error writing snapshot " << path << endl;
+        remove(tempPath.c_str());
+        timer.fail();
+        return false;
+    }
+
+    trimChangeLog(db, seq);
+    return true;
+}
+
+// The change-log position a snapshot file was written at, or -1 if there is
+// no usable snapshot
+static long long snapshotChangeSeq(const char* path) {
+    ifstream in(path, ios::binary);
+    SnapshotHeader header;
+    if (!in.read((char*)&header, sizeof(header)) || memcmp(header.magic, "CMSSNAP", 8) != 0 ||
+        header.version != SNAPSHOT_VERSION || header.byteOrder != SNAPSHOT_BYTE_ORDER) {
+        return -1;
+    }
+    return header.changeSeq;
+}
+
+// Make the hotel list match the tables without clearing it, for when the
+// change log no longer reaches back far enough to replay. Unchanged hotels
+// are left alone, and snapshot readers stay valid throughout. Any hotel not
+// read is taken as deleted, so nothing is applied, and -1 returned, unless
+// every table was read in full.
+static long reconcileHotels() {
+    vector<vector<Hotel> > loaded;
+    vector<long long> changeSeqs;
+    if (shards.active()) {
+        if (!readShardHotels(loaded, changeSeqs)) return -1;
+        for (int i = 0; i < shards.count(); i++) shards[i].changeSeq = changeSeqs[i];
+    } else {
+        loaded.resize(1);
+        changeSeqs.resize(1);
+        if (!readHotels(db, loaded[0], changeSeqs[0])) return -1;
+        changeCursor.hotels = changeSeqs[0];
+    }
+    long applied = 0;
+    unordered_set<int> present;
+    for (size_t i = 0; i < loaded.size(); i++) {
+        for (size_t j = 0; j < loaded[i].size(); j++) {
+            Hotel& hotel = loaded[i][j];
+            present.insert(hotel.id);
+            HotelNode* node = hotelList.findHotel(hotel.id);
+            if (!node) {
+                hotelList.addHotel(std::move(hotel));
+                applied++;
+            } else if (!sameHotel(hotelList.toHotel(node), hotel)) {
+                hotelList.updateHotel(hotel);
+                applied++;
+            }
+        }
+    }
+    vector<int> gone;
+    {
+        HotelLinkedList::ReadSnapshot hotels(hotelList);
+        for (const HotelNode* node = hotels.first(); node; node = hotels.next(node)) {
+            if (!present.count(node->id)) gone.push_back(node->id);
+        }
+    }
+    for (size_t i = 0; i < gone.size(); i++) hotelList.removeHotel(gone[i]);
+    return applied + long(gone.size());
+}
+
+// Trim what memory and the session's snapshot file have both applied, so the log
+// stays as long as recent activity rather than the tables' history.
+// Another process that was further behind loses nothing: its next refresh
+// finds the gap and reconciles in full.
+static long compactChangeLog() {
+    ScopedTimer timer(MET_SQL_COMPACT_CHANGES);
+    long long through = changeCursor.guests;
+    if (!shards.active()) {
+        through = min(through, changeCursor.hotels);
+        long long snapshotSeq = sessionSnapshotPath.empty() ? -1 : snapshotChangeSeq(sessionSnapshotPath.c_str());
+        if (snapshotSeq >= 0) through = min(through, snapshotSeq);
+    }
+    long trimmed = trimChangeLog(db, through);
+    for (int i = 0; i < shards.count(); i++) trimmed += trimChangeLog(shards[i].connection, shards[i].changeSeq);
+    return trimmed;
+}
+
+// Pick up rows other processes wrote (the partner feed, another desk's
+// instance) by replaying the change log since the last load or refresh, so
+// the cost follows the number of changed rows rather than the table sizes.
+// Where the log has been trimmed past that point, hotels are reconciled
+// against the tables and the guest queue is reloaded. Bookings are not
+// logged and are re-read whole. The log is then compacted.
+bool refreshFromDatabase(string& message) {
+    ScopedTimer timer(MET_OP_REFRESH);
+    if (!flushPendingWrites()) { // So our own pending changes are not undone by older rows
+        message = "Error: pending changes are not saved yet; try the refresh again.";
+        timer.fail();
+        return false;
+    }
+    long applied = 0, count = 0;
+    bool reconcile = false, reloadGuests = false;
+
+    SyncResult result =
+        syncFromChangeLog(db, statements, -1, shards.active() ? NULL : &changeCursor.hotels, &changeCursor.guests, count);
+    applied += count;
+    if (result == SYNC_GAP) {
+        reconcile = !shards.active();
+        reloadGuests = true;
+    }
+    for (int i = 0; i < shards.count() && result != SYNC_FAILED; i++) {
+        SyncResult shardResult =
+            syncFromChangeLog(shards[i].connection, shards[i].statements, i, &shards[i].changeSeq, NULL, count);
+        applied += count;
+        if (shardResult == SYNC_GAP) reconcile = true;
+        if (shardResult == SYNC_FAILED) result = SYNC_FAILED;
+    }
+    if (result == SYNC_FAILED) {
+        message = "Error: could not read the change log.";
+        timer.fail();
+        return false;
+    }
+    if (reconcile) {
+        long reconciled = reconcileHotels();
+        if (reconciled < 0) {
+            message = "Error: the hotel tables could not be read in full; nothing was reconciled.";
+            timer.fail();
+            return false;
+        }
+        applied += reconciled;
+    }
+    if (reloadGuests) {
+        loadGuestsFromDatabase();
+        applied += guestQueue.size();
+    }
+    loadBookingsFromDatabase(); // Not in the change log; re-read whole, as at start-up
+    long trimmed = compactChangeLog();
+    message = "Applied " + to_string(applied) + " change(s) from the database";
+    if (reconcile || reloadGuests) message += " (change log trimmed since the last refresh; re-read in full)";
+    message += "; " + to_string(trimmed) + " change-log entries trimmed.";
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------
+// Bulk import
+// Streams CSV or JSON-lines files into Hotels/Guests. Rows are inserted in
+// explicit transactions of batchSize rows and only reach hotelList/guestQueue
+// once their batch has committed.
+// ---------------------------------------------------------------------------
+
+enum ImportTable { IMPORT_HOTELS, IMPORT_GUESTS };
+
+struct ImportReport {
+    long rowsRead;
+    long imported;
+    long duplicates;
+    long malformed;
+    long failed;
+    double seconds;
+};
+
+static const char* hotelImportFields[] = {"id", "name", "services", "location", "roomNumber", "latitude", "longitude"};
+static const char* guestImportFields[] = {"id", "name", "queuePosition"};
+
+// Split one CSV line; fields may be quoted and use "" for a literal quote
+static void splitCsvLine(const string& line, vector<string>& fields) {
+    fields.clear();
+    string field;
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"') {
+                if (i + 1 < line.size() && line[i + 1] == '"') {
+                    field += '"';
+                    i++;
+                } else {
+                    quoted = false;
+                }
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else if (c != '\r') {
+            field += c;
+        }
+    }
+    fields.push_back(field);
+}
+
+// A CSV header names the columns in import order, at least up to name;
+// case and surrounding spaces are ignored. Anything else is a data row.
+static bool isCsvHeader(const vector<string>& fields, const char* const* names, int nameCount) {
+    if (fields.size() < 2 || int(fields.size()) > nameCount) return false;
+    for (size_t k = 0; k < fields.size(); k++) {
+        size_t start = fields[k].find_first_not_of(" \t");
+        size_t end = fields[k].find_last_not_of(" \t");
+        if (start == string::npos) return false;
+        string field = fields[k].substr(start, end - start + 1);
+        if (field.size() != strlen(names[k])) return false;
+        for (size_t c = 0; c < field.size(); c++) {
+            if (tolower((unsigned char)field[c]) != tolower((unsigned char)names[k][c])) return false;
+        }
+    }
+    return true;
+}
+
+// Read the four hex digits of a \u escape starting at line[i]
+static bool parseHex4(const string& line, size_t i, unsigned int& value) {
+    if (i + 4 > line.size()) return false;
+    value = 0;
+    for (size_t k = i; k < i + 4; k++) {
+        char c = line[k];
+        if (!isxdigit((unsigned char)c)) return false;
+        value = value * 16 + (isdigit((unsigned char)c) ? c - '0' : tolower((unsigned char)c) - 'a' + 10);
+    }
+    return true;
+}
+
+static void appendUtf8(string& out, unsigned int codePoint) {
+    if (codePoint < 0x80) {
+        out += char(codePoint);
+    } else if (codePoint < 0x800) {
+        out += char(0xC0 | (codePoint >> 6));
+        out += char(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += char(0xE0 | (codePoint >> 12));
+        out += char(0x80 | ((codePoint >> 6) & 0x3F));
+        out += char(0x80 | (codePoint & 0x3F));
+    } else {
+        out += char(0xF0 | (codePoint >> 18));
+        out += char(0x80 | ((codePoint >> 12) & 0x3F));
+        out += char(0x80 | ((codePoint >> 6) & 0x3F));
+        out += char(0x80 | (codePoint & 0x3F));
+    }
+}
+
+// Parse a flat JSON object ({"key": "text" or number, ...}) into fields laid
+// out in the order of `names`. Returns false on malformed input.
+static bool parseJsonLine(const string& line, const char* const* names, int nameCount, vector<string>& fields) {
+    fields.assign(nameCount, string());
+    size_t i = 0;
+    size_t n = line.size();
+    while (i < n && isspace((unsigned char)line[i])) i++;
+    if (i == n || line[i] != '{') return false;
+    i++;
+    while (true) {
+        while (i < n && isspace((unsigned char)line[i])) i++;
+        if (i < n && line[i] == '}') return true;
+        if (i == n || line[i] != '"') return false;
+
+        string parts[2]; // key, value
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                while (i < n && isspace((unsigned char)line[i])) i++;
+                if (i == n || line[i] != ':') return false;
+                i++;
+                while (i < n && isspace((unsigned char)line[i])) i++;
+                if (i < n && line[i] != '"') { // Bare number, true/false/null
+                    size_t start = i;
+                    while (i < n && line[i] != ',' && line[i] != '}' && !isspace((unsigned char)line[i])) i++;
+                    parts[1] = line.substr(start, i - start);
+                    if (parts[1] == "null") parts[1].clear();
+                    break;
+                }
+            }
+            if (i == n || line[i] != '"') return false;
+            i++;
+            while (i < n && line[i] != '"') {
+                char c = line[i++];
+                if (c != '\\') {
+                    parts[part] += c;
+                    continue;
+                }
+                if (i == n) return false;
+                char escaped = line[i++];
+                switch (escaped) {
+                    case 'n': parts[part] += '\n'; break;
+                    case 't': parts[part] += '\t'; break;
+                    case 'r': parts[part] += '\r'; break;
+                    case 'b': parts[part] += '\b'; break;
+                    case 'f': parts[part] += '\f'; break;
+                    case 'u': {
+                        unsigned int codePoint, low;
+                        if (!parseHex4(line, i, codePoint)) return false;
+                        i += 4;
+                        if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) return false; // Low half alone
+                        if (codePoint >= 0xD800 && codePoint <= 0xDBFF) { // Must pair with a low half
+                            if (i + 2 > n || line[i] != '\\' || line[i + 1] != 'u' || !parseHex4(line, i + 2, low) ||
+                                low < 0xDC00 || low > 0xDFFF) {
+                                return false;
+                            }
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                            i += 6;
+                        }
+                        appendUtf8(parts[part], codePoint);
+                        break;
+                    }
+                    default: parts[part] += escaped;
+                }
+            }
+            if (i == n) return false;
+            i++; // Closing quote
+        }
+
+        for (int k = 0; k < nameCount; k++) {
+            if (parts[0] == names[k]) {
+                fields[k] = parts[1];
+                break;
+            }
+        }
+        while (i < n && isspace((unsigned char)line[i])) i++;
+        if (i < n && line[i] == ',') {
+            i++;
+        } else if (i < n && line[i] == '}') {
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+static bool parseImportInt(const string& text, int& value) {
+    if (text.empty()) return false;
+    char* end;
+    long parsed = strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || parsed < numeric_limits<int>::min() || parsed > numeric_limits<int>::max()) return false;
+    value = int(parsed);
+    return true;
+}
+
+static bool isJsonLinesPath(const string& path) {
+    size_t dot = path.rfind('.');
+    if (dot == string::npos) return false;
+    string extension = path.substr(dot);
+    return extension == ".jsonl" || extension == ".ndjson" || extension == ".json";
+}
+
+// Insert one staged batch inside a transaction and, once it commits, apply the
+// rows to the in-memory structures. Returns false if the batch was rolled back.
+// With shards each shard commits its part of the batch on its own.
+static bool commitHotelBatch(vector<Hotel>& batch, ImportReport& report) {
+    ScopedTimer timer(MET_SQL_IMPORT_BATCH);
+    vector<char> inserted;
+    bool committed;
+    if (shards.active()) {
+        committed = writeHotelsToShards(batch, STMT_INSERT_HOTEL, inserted, report.failed);
+    } else {
+        vector<size_t> rows(batch.size());
+        for (size_t i = 0; i < rows.size(); i++) rows[i] = i;
+        inserted.assign(batch.size(), 0);
+        committed = writeHotelRows(db, statements, STMT_INSERT_HOTEL, batch, rows, inserted, report.failed);
+    }
+    report.imported += long(count(inserted.begin(), inserted.end(), 1));
+    hotelList.addHotels(batch, inserted);
+    batch.clear();
+    if (!committed) timer.fail();
+    return committed;
+}
+
+static bool commitGuestBatch(vector<Guest>& batch, ImportReport& report) {
+    ScopedTimer timer(MET_SQL_IMPORT_BATCH);
+    if (!execSql("BEGIN IMMEDIATE;")) return false;
+    vector<char> inserted(batch.size(), 0);
+    for (size_t i = 0; i < batch.size(); i++) {
+        sqlite3_stmt* stmt = statements.acquire(STMT_INSERT_GUEST);
+        const Guest& guest = batch[i];
+        bindRecord(stmt, guest);
+        if (sqlite3_step(stmt) == SQLITE_DONE) {
+            inserted[i] = 1;
+        } else {
+            if (report.failed++ < 5) {
+                cerr << "Error importing guest " << guest.id << ": " << sqlite3_errmsg(db) << endl;
+            }
+        }
+        statements.release(stmt);
+    }
+    if (!execSql("COMMIT;")) {
+        execSql("ROLLBACK;");
+        report.failed += long(batch.size());
+        batch.clear();
+        timer.fail();
+        return false;
+    }
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (inserted[i]) {
+            guestQueue.addGuest(batch[i]);
+            report.imported++;
+        }
+    }
+    batch.clear();
+    return true;
+}
+
+// A large hotel import drops the Hotels secondary indexes in every file and
+// builds them once at the end, one sort instead of a B-tree insert per row.
+// Large means about IMPORT_REBUILD_ROWS rows or more, judged from the file
+// size, and at least a quarter as many as are already held, since the
+// rebuild sorts those too.
+const long IMPORT_REBUILD_ROWS = 20000;
+const long IMPORT_BYTES_PER_ROW = 64; // A typical hotel line
+
+static bool setHotelIndexes(bool present) {
+    const char* sql = present ? CREATE_HOTEL_INDEXES_SQL : DROP_HOTEL_INDEXES_SQL;
+    bool ok = execSql(db, sql);
+    for (int i = 0; i < shards.count(); i++) ok = execSql(shards[i].connection, sql) && ok;
+    return ok;
+}
+
+// Import every row of a CSV (optionally with a header line) or JSON-lines file
+bool importFile(const string& path, ImportTable table, int batchSize, ImportReport& report) {
+    report.rowsRead = report.imported = report.duplicates = report.malformed = report.failed = 0;
+    report.seconds = 0;
+    if (!flushPendingWrites()) { // Import batches go straight to db, after earlier changes
+        cerr << "Error importing: pending changes are not saved yet." << endl;
+        return false;
+    }
+
+    ifstream input(path.c_str());
+    if (!input) {
+        cerr << "Error opening import file: " << path << endl;
+        return false;
+    }
+    vector<char> buffer(1 << 20);
+    input.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+    if (batchSize < 1) batchSize = DEFAULT_IMPORT_BATCH_SIZE;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    input.seekg(0, ios::end);
+    long estimatedRows = long(input.tellg()) / IMPORT_BYTES_PER_ROW;
+    input.seekg(0, ios::beg);
+    bool rebuildIndexes = table == IMPORT_HOTELS && estimatedRows >= IMPORT_REBUILD_ROWS &&
+                          estimatedRows * 4 >= long(hotelList.size()) && setHotelIndexes(false);
+    bool json = isJsonLinesPath(path);
+    const char* const* names = table == IMPORT_HOTELS ? hotelImportFields : guestImportFields;
+    int nameCount = table == IMPORT_HOTELS ? 7 : 3;
+
+    // Ids already in memory plus everything accepted from this file so far
+    unordered_set<int> seenIds;
+    if (table == IMPORT_GUESTS) {
+        for (GuestNode* node = guestQueue.head; node; node = node->next) seenIds.insert(node->id);
+    } else {
+        seenIds.reserve(hotelList.size() + batchSize);
+        HotelLinkedList::ReadSnapshot hotels(hotelList);
+        for (const HotelNode* node = hotels.first(); node; node = hotels.next(node)) seenIds.insert(node->id);
+    }
+
+    vector<Hotel> hotelBatch;
+    vector<Guest> guestBatch;
+    vector<string> fields;
+    string line;
+    bool ok = true;
+    bool firstLine = true;
+
+    while (ok && getline(input, line)) {
+        if (line.empty() || line == "\r") continue;
+        if (json) {
+            if (!parseJsonLine(line, names, nameCount, fields)) {
+                report.rowsRead++;
+                report.malformed++;
+                continue;
+            }
+        } else {
+            splitCsvLine(line, fields);
+            if (firstLine && isCsvHeader(fields, names, nameCount)) {
+                firstLine = false;
+                continue;
+            }
+        }
+        firstLine = false;
+        report.rowsRead++;
+
+        int id;
+        if (!parseImportInt(fields.size() > 0 ? fields[0] : string(), id) || id == 0) {
+            report.malformed++;
+            continue;
+        }
+        if (!seenIds.insert(id).second) {
+            report.duplicates++;
+            continue;
+        }
+
+        if (table == IMPORT_HOTELS) {
+            Hotel hotel;
+            if (int(fields.size()) < 5 || !parseImportInt(fields[4], hotel.roomNumber) || hotel.roomNumber < 0) {
+                seenIds.erase(id);
+                report.malformed++;
+                continue;
+            }
+            // latitude and longitude are optional trailing fields
+            string coordinates = int(fields.size()) >= 7 && !(fields[5].empty() && fields[6].empty())
+                                     ? fields[5] + "," + fields[6]
+                                     : string();
+            if (!parseCoordinates(coordinates, hotel.latitude, hotel.longitude)) {
+                seenIds.erase(id);
+                report.malformed++;
+                continue;
+            }
+            hotel.id = id;
+            hotel.name.swap(fields[1]);
+            hotel.services.swap(fields[2]);
+            hotel.location.swap(fields[3]);
+            hotelBatch.push_back(std::move(hotel));
+            if (int(hotelBatch.size()) >= batchSize) ok = commitHotelBatch(hotelBatch, report);
+        } else {
+            Guest guest;
+            if (int(fields.size()) < 2) {
+                seenIds.erase(id);
+                report.malformed++;
+                continue;
+            }
+            guest.id = id;
+            guest.name.swap(fields[1]);
+            if (int(fields.size()) < 3 || !parseImportInt(fields[2], guest.queuePosition)) {
+                guest.queuePosition = guestQueue.issueTicket();
+            } else {
+                guestQueue.noteTicket(guest.queuePosition);
+            }
+            guestBatch.push_back(std::move(guest));
+            if (int(guestBatch.size()) >= batchSize) ok = commitGuestBatch(guestBatch, report);
+        }
+    }
+    if (ok && !hotelBatch.empty()) ok = commitHotelBatch(hotelBatch, report);
+    if (ok && !guestBatch.empty()) ok = commitGuestBatch(guestBatch, report);
+    if (rebuildIndexes && !setHotelIndexes(true)) {
+        cerr << "Error rebuilding the Hotels indexes; they are rebuilt at the next start." << endl;
+    }
+
+    report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+static void printImportReport(const ImportReport& report) {
+    cout << "Rows read: " << report.rowsRead << "\n"
+         << "Imported: " << report.imported << "\n"
+         << "Duplicate ids skipped: " << report.duplicates << "\n"
+         << "Malformed rows skipped: " << report.malformed << "\n"
+         << "Database errors: " << report.failed << "\n"
+         << "Elapsed: " << fixed << setprecision(3) << report.seconds << " s ("
+         << setprecision(0) << (report.seconds > 0 ? report.imported / report.seconds : 0) << " rows/sec)\n";
+    cout.unsetf(ios::floatfield);
+}
+
+// Admin menu entry for bulk import
+void bulkImport() {
+    string tableName, path;
+    int batchSize;
+    cout << "Import into (hotels/guests): ";
+    getline(cin, tableName);
+    if (tableName != "hotels" && tableName != "guests") {
+        cout << "Unknown table!\n";
+        return;
+    }
+    cout << "File path (.csv or .jsonl): ";
+    getline(cin, path);
+    cout << "Batch size (0 for default " << DEFAULT_IMPORT_BATCH_SIZE << "): ";
+    cin >> batchSize;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+
+    ImportReport report;
+    bool ok = importFile(path, tableName == "hotels" ? IMPORT_HOTELS : IMPORT_GUESTS, batchSize, report);
+    printImportReport(report);
+    if (!ok) cout << "Import stopped early.\n";
+}
+
+// Non-interactive import: ContactMGMTSys --import hotels|guests <file> [batchSize]
+int runImportCommand(const string& table, const string& path, int batchSize) {
+    if (table != "hotels" && table != "guests") {
+        cerr << "Usage: --import hotels|guests <file> [batchSize]\n";
+        return 1;
+    }
+    initializeDatabase();
+    if (!loadSnapshot(SNAPSHOT_PATH)) {
+        loadHotelsFromDatabase();
+        loadGuestsFromDatabase();
+    }
+    ImportReport report;
+    bool ok = importFile(path, table == "hotels" ? IMPORT_HOTELS : IMPORT_GUESTS, batchSize, report);
+    printImportReport(report);
+    writeSnapshot(SNAPSHOT_PATH); // Next start-up need not replay the whole import
+    ok = closeDatabase() && ok;
+    return ok ? 0 : 1;
+}
+
+
+// ---------------------------------------------------------------------------
+// Management report
+// Hotels and rooms per location, how many hotels offer each amenity, and the
+// guest queue's length and waits. readReport() copies the running totals the
+// lists keep up to date on every change, so it costs one row per location and
+// amenity however many hotels there are. recountReport() walks the lists and
+// reportFromDatabase() runs GROUP BY over the tables; verifyReport() checks
+// the running totals against both.
+// ---------------------------------------------------------------------------
+
+struct ManagementReport {
+    struct LocationRow {
+        string location;
+        long hotels;
+        long long rooms;
+    };
+
+    struct AmenityRow {
+        string amenity;
+        long hotels;
+    };
+
+    long hotels;
+    long long rooms;
+    vector<LocationRow> locations; // By name
+    vector<AmenityRow> amenities;  // Most offered first
+    long waiting;
+    double frontWaitSeconds;       // How long the guest at the head has waited
+    long served;                   // Since start-up
+    double meanServedWaitSeconds;
+    double longestServedWaitSeconds;
+
+    ManagementReport()
+        : hotels(0), rooms(0), waiting(0), frontWaitSeconds(0), served(0), meanServedWaitSeconds(0),
+          longestServedWaitSeconds(0) {}
+
+    void sortRows() {
+        sort(locations.begin(), locations.end(),
+             [](const LocationRow& a, const LocationRow& b) { return a.location < b.location; });
+        sort(amenities.begin(), amenities.end(), [](const AmenityRow& a, const AmenityRow& b) {
+            return a.hotels != b.hotels ? a.hotels > b.hotels : a.amenity < b.amenity;
+        });
+    }
+};
+
+typedef map<string, HotelAggregates::Totals> LocationTotals; // By location
+typedef map<string, long> AmenityTotals;                     // By normalized amenity
+
+static void readQueueFigures(const GuestLinkedList& queue, ManagementReport& report) {
+    const QueueTotals& totals = queue.servedTotals();
+    report.waiting = queue.size();
+    report.frontWaitSeconds = queue.head ? GuestLinkedList::secondsWaiting(queue.head) : 0;
+    report.served = totals.served;
+    report.meanServedWaitSeconds = totals.served ? totals.servedWaitSeconds / totals.served : 0;
+    report.longestServedWaitSeconds = totals.longestWaitSeconds;
+}
+
+// The report as of the last change. In server mode, call it under the store
+// lock like any other read so hotel and queue figures agree.
+static void readReport(const HotelLinkedList& store, const GuestLinkedList& queue, ManagementReport& report) {
+    report = ManagementReport();
+    const HotelAggregates& totals = store.totals();
+    report.hotels = totals.total().hotels;
+    report.rooms = totals.total().rooms;
+    for (uint32_t id = 0; id < totals.locationIds(); id++) {
+        const HotelAggregates::Totals& row = totals.atLocation(id);
+        if (row.hotels) report.locations.push_back({store.locationName(id), row.hotels, row.rooms});
+    }
+    for (int id = 0; id < int(totals.amenityIds()); id++) {
+        if (totals.withAmenity(id)) report.amenities.push_back({store.amenities().amenityName(id), totals.withAmenity(id)});
+    }
+    readQueueFigures(queue, report);
+    report.sortRows();
+}
+
+// Hotel rows from counts gathered the slow way; amenities take the spelling
+// the store displays
+static void fillReport(const HotelLinkedList& store, const LocationTotals& byLocation, const AmenityTotals& byAmenity,
+                       ManagementReport& report) {
+    report = ManagementReport();
+    for (LocationTotals::const_iterator it = byLocation.begin(); it != byLocation.end(); ++it) {
+        report.hotels += it->second.hotels;
+        report.rooms += it->second.rooms;
+        report.locations.push_back({it->first, it->second.hotels, it->second.rooms});
+    }
+    for (AmenityTotals::const_iterator it = byAmenity.begin(); it != byAmenity.end(); ++it) {
+        int id = store.amenities().lookup(it->first);
+        report.amenities.push_back({id >= 0 ? store.amenities().amenityName(id) : it->first, it->second});
+    }
+    report.sortRows();
+}
+
+// The report recomputed by walking every hotel and guest. The served figures
+// are only ever kept as running totals and are copied as they are.
+static void recountReport(const HotelLinkedList& store, const GuestLinkedList& queue, ManagementReport& report) {
+    LocationTotals byLocation;
+    AmenityTotals byAmenity;
+    vector<string> keys;
+    {
+        HotelLinkedList::ReadSnapshot snapshot(store);
+        for (const HotelNode* node = snapshot.first(); node; node = snapshot.next(node)) {
+            Hotel hotel = snapshot.toHotel(node);
+            HotelAggregates::Totals& row = byLocation[hotel.location];
+            row.hotels++;
+            row.rooms += hotel.roomNumber;
+            AmenityIndex::tokenize(hotel.services, keys);
+            for (size_t i = 0; i < keys.size(); i++) byAmenity[keys[i]]++;
+        }
+    }
+    fillReport(store, byLocation, byAmenity, report);
+    readQueueFigures(queue, report);
+    long waiting = 0;
+    for (const GuestNode* node = queue.head; node; node = node->next) waiting++;
+    report.waiting = waiting;
+}
+
+// Add one file's hotels, grouped by location and by services text
+static bool groupHotels(sqlite3* connection, LocationTotals& byLocation, AmenityTotals& byAmenity) {
+    ReadTransaction snapshot(connection);
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(connection, "SELECT location, COUNT(*), SUM(roomNumber) FROM Hotels GROUP BY location;", -1,
+                           &stmt, NULL) != SQLITE_OK) {
+        cerr << "Error grouping hotels: " << sqlite3_errmsg(connection) << endl;
+        return false;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        HotelAggregates::Totals& row = byLocation[string(columnText(stmt, 0))];
+        row.hotels += sqlite3_column_int64(stmt, 1);
+        row.rooms += sqlite3_column_int64(stmt, 2);
+    }
+    sqlite3_finalize(stmt);
+
+    // Catalogues repeat a few services strings, so each is split once
+    if (sqlite3_prepare_v2(connection, "SELECT services, COUNT(*) FROM Hotels GROUP BY services;", -1, &stmt, NULL) !=
+        SQLITE_OK) {
+        cerr << "Error grouping hotels: " << sqlite3_errmsg(connection) << endl;
+        return false;
+    }
+    vector<string> keys;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        AmenityIndex::tokenize(string(columnText(stmt, 0)), keys);
+        for (size_t i = 0; i < keys.size(); i++) byAmenity[keys[i]] += sqlite3_column_int64(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+// The report as the database has it: GROUP BY over the Hotels table of the
+// main file or of every shard, and the length of the Guests table
+static bool reportFromDatabase(const HotelLinkedList& store, ManagementReport& report) {
+    if (!flushPendingWrites()) return false;
+    LocationTotals byLocation;
+    AmenityTotals byAmenity;
+    if (shards.active()) {
+        for (int i = 0; i < shards.count(); i++) {
+            if (!groupHotels(shards[i].connection, byLocation, byAmenity)) return false;
+        }
+    } else if (!groupHotels(db, byLocation, byAmenity)) {
+        return false;
+    }
+    fillReport(store, byLocation, byAmenity, report);
+    long long guests = selectNumber(db, "SELECT COUNT(*) FROM Guests;");
+    if (guests < 0) return false;
+    report.waiting = long(guests);
+    return true;
+}
+
+// One line for every figure the running totals get wrong
+static void diffReports(const ManagementReport& expected, const ManagementReport& live, const string& source,
+                        vector<string>& differences) {
+    if (expected.hotels != live.hotels || expected.rooms != live.rooms) {
+        differences.push_back(source + ": " + to_string(expected.hotels) + " hotels with " + to_string(expected.rooms) +
+                              " rooms, totals say " + to_string(live.hotels) + " with " + to_string(live.rooms));
+    }
+    if (expected.waiting != live.waiting) {
+        differences.push_back(source + ": " + to_string(expected.waiting) + " guests waiting, totals say " +
+                              to_string(live.waiting));
+    }
+    map<string, pair<long, long long> > locations;
+    for (size_t i = 0; i < live.locations.size(); i++) {
+        locations[live.locations[i].location] = make_pair(live.locations[i].hotels, live.locations[i].rooms);
+    }
+    for (size_t i = 0; i < expected.locations.size(); i++) {
+        const ManagementReport::LocationRow& row = expected.locations[i];
+        pair<long, long long> counted = make_pair(row.hotels, row.rooms);
+        map<string, pair<long, long long> >::iterator it = locations.find(row.location);
+        pair<long, long long> kept = it == locations.end() ? make_pair(0L, 0LL) : it->second;
+        if (it != locations.end()) locations.erase(it);
+        if (counted == kept) continue;
+        differences.push_back(source + ": " + row.location + " has " + to_string(row.hotels) + " hotels with " +
+                              to_string(row.rooms) + " rooms, totals say " + to_string(kept.first) + " with " +
+                              to_string(kept.second));
+    }
+    for (map<string, pair<long, long long> >::iterator it = locations.begin(); it != locations.end(); ++it) {
+        differences.push_back(source + ": no hotels at " + it->first + ", totals say " + to_string(it->second.first));
+    }
+    map<string, long> amenities;
+    for (size_t i = 0; i < live.amenities.size(); i++) amenities[live.amenities[i].amenity] = live.amenities[i].hotels;
+    for (size_t i = 0; i < expected.amenities.size(); i++) {
+        const ManagementReport::AmenityRow& row = expected.amenities[i];
+        map<string, long>::iterator it = amenities.find(row.amenity);
+        long kept = it == amenities.end() ? 0 : it->second;
+        if (it != amenities.end()) amenities.erase(it);
+        if (row.hotels != kept) {
+            differences.push_back(source + ": " + to_string(row.hotels) + " hotels offer " + row.amenity +
+                                  ", totals say " + to_string(kept));
+        }
+    }
+    for (map<string, long>::iterator it = amenities.begin(); it != amenities.end(); ++it) {
+        differences.push_back(source + ": no hotels offer " + it->first + ", totals say " + to_string(it->second));
+    }
+}
+
+// Recount from scratch and compare. The database can also differ because
+// another process changed it since the last refresh.
+bool verifyReport(string& message) {
+    const size_t shown = 20;
+    ManagementReport live, walked, stored;
+    readReport(hotelList, guestQueue, live);
+    recountReport(hotelList, guestQueue, walked);
+    vector<string> differences;
+    diffReports(walked, live, "list walk", differences);
+    if (!reportFromDatabase(hotelList, stored)) {
+        message = "Error: could not read the report from the database.";
+        return false;
+    }
+    diffReports(stored, live, "database", differences);
+    if (differences.empty()) {
+        message = "Report verified: the running totals match a walk of the lists and the database (" +
+                  to_string(live.hotels) + " hotels, " + to_string(live.locations.size()) + " locations, " +
+                  to_string(live.amenities.size()) + " amenities, " + to_string(live.waiting) + " guests waiting).";
+        return true;
+    }
+    ostringstream out;
+    out << "Report differs from a recount in " << differences.size() << " place(s):";
+    for (size_t i = 0; i < differences.size() && i < shown; i++) out << "\n  " << differences[i];
+    if (differences.size() > shown) out << "\n  ... and " << differences.size() - shown << " more";
+    message = out.str();
+    return false;
+}
+
+static void printReport(ostream& out, const ManagementReport& report) {
+    out << "\n--- Management report ---\n"
+        << "Hotels: " << report.hotels << ", rooms: " << report.rooms << "\n\n"
+        << left << setw(28) << "location" << right << setw(10) << "hotels" << setw(12) << "rooms" << "\n";
+    for (size_t i = 0; i < report.locations.size(); i++) {
+        const ManagementReport::LocationRow& row = report.locations[i];
+        out << left << setw(28) << row.location << right << setw(10) << row.hotels << setw(12) << row.rooms << "\n";
+    }
+    out << "\n" << left << setw(28) << "amenity" << right << setw(10) << "hotels" << "\n";
+    for (size_t i = 0; i < report.amenities.size(); i++) {
+        out << left << setw(28) << report.amenities[i].amenity << right << setw(10) << report.amenities[i].hotels
+            << "\n";
+    }
+    out << "\nQueue: " << report.waiting << " waiting" << fixed << setprecision(1);
+    if (report.waiting) out << ", the first for " << report.frontWaitSeconds << " s";
+    out << "; " << report.served << " served since start-up";
+    if (report.served) {
+        out << ", mean wait " << report.meanServedWaitSeconds << " s, longest " << report.longestServedWaitSeconds
+            << " s";
+    }
+    out << "\n";
+}
+
+// Live totals for management, with an optional recount to check them
+void managementReport() {
+    ManagementReport report;
+    {
+        ScopedTimer timer(MET_OP_REPORT);
+        readReport(hotelList, guestQueue, report);
+    }
+    ostringstream out;
+    printReport(out, report);
+    cout << out.str() << flush;
+
+    string answer;
+    cout << "Verify against a full recount? (y/N): ";
+    getline(cin, answer);
+    if (answer == "y" || answer == "Y") {
+        string message;
+        verifyReport(message);
+        cout << message << "\n";
+    }
+}
+
+// --verify-report: print the report, recount it and exit non-zero on a difference
+int runVerifyReport() {
+    openSession();
+    ManagementReport report;
+    readReport(hotelList, guestQueue, report);
+    printReport(cout, report);
+    string message;
+    bool ok = verifyReport(message);
+    cout << message << "\n";
+    ok = closeSession() && ok;
+    return ok ? 0 : 1;
+}
+
+
+// ---------------------------------------------------------------------------
+// Command engine
+// One command per line, fields separated by '|', no prompts:
+//   add-hotel|id|name|services|location|roomNumber
+//   update-hotel|id|name|services|location|roomNumber
+//   delete-hotel|id
+//   enqueue-guest|id|name
+//   serve-guest
+//   cancel-guest|id
+//   add-stop|text
+//   find-hotel|id
+//   list-hotels|afterId|limit    (afterId 0 starts at the first hotel)
+//   queue-position|id
+//   hotels-by-rooms|location|minRooms|maxRooms|limit|asc or desc   (blank location = any)
+//   place-hotel|id|latitude|longitude    (blank coordinates clear them)
+//   add-stop-at|latitude|longitude|text
+//   nearest-hotels|latitude|longitude|k
+//   hotels-within|latitude|longitude|km|limit
+//   refresh    (pick up rows other processes changed in the database)
+//   search-hotels|name|limit    (names need not be spelt exactly)
+//   search-guests|name|limit
+//   book|hotelId|checkIn|checkOut|rooms|guestName    (dates YYYY-MM-DD; checkOut is the day of departure)
+//   cancel-booking|bookingId
+//   free-rooms|hotelId|checkIn|checkOut
+//   available-hotels|location|checkIn|checkOut|rooms|limit    (blank location = any)
+//   report    (hotels and rooms per location, amenities, queue length and waits)
+// Blank lines and lines starting with '#' are ignored. The last field takes
+// the rest of the line, so only it may contain '|'.
+// Run with: ContactMGMTSys --batch <file|->  or  --replay <file> [commands/s]
+// ---------------------------------------------------------------------------
+
+enum CommandType {
+    CMD_ADD_HOTEL,
+    CMD_UPDATE_HOTEL,
+    CMD_DELETE_HOTEL,
+    CMD_ENQUEUE_GUEST,
+    CMD_SERVE_GUEST,
+    CMD_CANCEL_GUEST,
+    CMD_ADD_STOP,
+    CMD_FIND_HOTEL,
+    CMD_LIST_HOTELS,
+    CMD_QUEUE_POSITION,
+    CMD_HOTELS_BY_ROOMS,
+    CMD_PLACE_HOTEL,
+    CMD_ADD_STOP_AT,
+    CMD_NEAREST_HOTELS,
+    CMD_HOTELS_WITHIN,
+    CMD_REFRESH,
+    CMD_SEARCH_HOTELS,
+    CMD_SEARCH_GUESTS,
+    CMD_BOOK,
+    CMD_CANCEL_BOOKING,
+    CMD_FREE_ROOMS,
+    CMD_AVAILABLE_HOTELS,
+    CMD_REPORT,
+    CMD_COUNT
+};
+
+struct CommandSpec {
+    const char* name;
+    int fields;
+};
+
+static const CommandSpec commandSpecs[CMD_COUNT] = {
+    {"add-hotel", 5},
+    {"update-hotel", 5},
+    {"delete-hotel", 1},
+    {"enqueue-guest", 2},
+    {"serve-guest", 0},
+    {"cancel-guest", 1},
+    {"add-stop", 1},
+    {"find-hotel", 1},
+    {"list-hotels", 2},
+    {"queue-position", 1},
+    {"hotels-by-rooms", 5},
+    {"place-hotel", 3},
+    {"add-stop-at", 3},
+    {"nearest-hotels", 3},
+    {"hotels-within", 4},
+    {"refresh", 0},
+    {"search-hotels", 2},
+    {"search-guests", 2},
+    {"book", 5},
+    {"cancel-booking", 1},
+    {"free-rooms", 3},
+    {"available-hotels", 5},
+    {"report", 0},
+};
+
+const int MAX_LIST_LIMIT = 1000;
+
+// Commands that only read the in-memory store
+static bool isReadCommand(CommandType type) {
+    return type == CMD_FIND_HOTEL || type == CMD_LIST_HOTELS || type == CMD_QUEUE_POSITION ||
+           type == CMD_HOTELS_BY_ROOMS || type == CMD_NEAREST_HOTELS || type == CMD_HOTELS_WITHIN ||
+           type == CMD_SEARCH_HOTELS || type == CMD_SEARCH_GUESTS || type == CMD_FREE_ROOMS ||
+           type == CMD_AVAILABLE_HOTELS || type == CMD_REPORT;
+}
+
+struct Command {
+    CommandType type;
+    Hotel hotel; // add-hotel, update-hotel; hotel.id for delete-hotel
+    Guest guest; // enqueue-guest; guest.id for cancel-guest and queue-position
+    string text; // add-stop, add-stop-at; location for hotels-by-rooms; name for the searches
+    int limit;   // list-hotels, hotels-by-rooms, nearest-hotels (k), hotels-within, the searches
+    int minRooms, maxRooms;
+    bool largestFirst;
+    double latitude, longitude; // place-hotel, add-stop-at and the geographic reads
+    double radiusKm;            // hotels-within
+    Booking booking;            // book; id for cancel-booking; hotel, dates and rooms for the availability reads
+};
+
+// True for lines that carry no command
+static bool isCommandComment(const string& line) {
+    size_t start = line.find_first_not_of(" \t\r");
+    return start == string::npos || line[start] == '#';
+}
+
+bool parseCommand(const string& line, Command& command, string& error) {
+    string text = line;
+    if (!text.empty() && text[text.size() - 1] == '\r') text.erase(text.size() - 1);
+    size_t bar = text.find('|');
+    string name = text.substr(0, bar);
+    int type = 0;
+    while (type < CMD_COUNT && name != commandSpecs[type].name) type++;
+    if (type == CMD_COUNT) {
+        error = "unknown command '" + name + "'";
+        return false;
+    }
+    command.type = CommandType(type);
+
+    vector<string> fields;
+    while (bar != string::npos && int(fields.size()) < commandSpecs[type].fields) {
+        size_t next = int(fields.size()) + 1 == commandSpecs[type].fields ? string::npos : text.find('|', bar + 1);
+        fields.push_back(text.substr(bar + 1, next == string::npos ? string::npos : next - bar - 1));
+        bar = next;
+    }
+    if (int(fields.size()) != commandSpecs[type].fields) {
+        error = name + " expects " + to_string(commandSpecs[type].fields) + " field(s)";
+        return false;
+    }
+
+    switch (command.type) {
+        case CMD_ADD_HOTEL:
+        case CMD_UPDATE_HOTEL:
+            command.hotel.name = fields[1];
+            command.hotel.services = fields[2];
+            command.hotel.location = fields[3];
+            if (!parseImportInt(fields[0], command.hotel.id) || !parseImportInt(fields[4], command.hotel.roomNumber) ||
+                command.hotel.roomNumber < 0) {
+                error = "id and roomNumber must be integers, and roomNumber not negative";
+                return false;
+            }
+            break;
+        case CMD_LIST_HOTELS:
+            if (!parseImportInt(fields[1], command.limit) || command.limit < 1 || command.limit > MAX_LIST_LIMIT) {
+                error = "limit must be between 1 and " + to_string(MAX_LIST_LIMIT);
+                return false;
+            }
+            // afterId parses like an id
+            // Fall through
+        case CMD_DELETE_HOTEL:
+        case CMD_FIND_HOTEL:
+            if (!parseImportInt(fields[0], command.hotel.id)) {
+                error = "id must be an integer";
+                return false;
+            }
+            break;
+        case CMD_ENQUEUE_GUEST:
+        case CMD_CANCEL_GUEST:
+        case CMD_QUEUE_POSITION:
+            if (!parseImportInt(fields[0], command.guest.id)) {
+                error = "id must be an integer";
+                return false;
+            }
+            if (command.type == CMD_ENQUEUE_GUEST) command.guest.name = fields[1];
+            break;
+        case CMD_ADD_STOP:
+            command.text = fields[0];
+            break;
+        case CMD_SEARCH_HOTELS:
+        case CMD_SEARCH_GUESTS:
+            command.text = fields[0];
+            if (!parseImportInt(fields[1], command.limit) || command.limit < 1 || command.limit > MAX_LIST_LIMIT) {
+                error = "limit must be between 1 and " + to_string(MAX_LIST_LIMIT);
+                return false;
+            }
+            break;
+        case CMD_BOOK:
+        case CMD_FREE_ROOMS:
+        case CMD_AVAILABLE_HOTELS: {
+            // Dates follow the hotel id or location
+            if (command.type == CMD_AVAILABLE_HOTELS) command.text = fields[0];
+            else if (!parseImportInt(fields[0], command.booking.hotelId)) {
+                error = "hotelId must be an integer";
+                return false;
+            }
+            if (!parseDate(fields[1], command.booking.checkIn) || !parseDate(fields[2], command.booking.checkOut) ||
+                command.booking.checkOut <= command.booking.checkIn) {
+                error = "dates must be YYYY-MM-DD in " + to_string(FIRST_BOOKING_YEAR) + "-" +
+                        to_string(LAST_BOOKING_YEAR) + ", check-out after check-in";
+                return false;
+            }
+            if (command.type != CMD_FREE_ROOMS && !parseImportInt(fields[3], command.booking.rooms)) {
+                error = "rooms must be an integer";
+                return false;
+            }
+            if (command.type == CMD_BOOK) command.booking.guestName = fields[4];
+            if (command.type == CMD_AVAILABLE_HOTELS &&
+                (!parseImportInt(fields[4], command.limit) || command.limit < 1 || command.limit > MAX_LIST_LIMIT)) {
+                error = "limit must be between 1 and " + to_string(MAX_LIST_LIMIT);
+                return false;
+            }
+            break;
+        }
+        case CMD_CANCEL_BOOKING:
+            if (!parseImportInt(fields[0], command.booking.id)) {
+                error = "bookingId must be an integer";
+                return false;
+            }
+            break;
+        case CMD_HOTELS_BY_ROOMS:
+            command.text = fields[0];
+            if (!parseImportInt(fields[1], command.minRooms) || !parseImportInt(fields[2], command.maxRooms)) {
+                error = "minRooms and maxRooms must be integers";
+                return false;
+            }
+            if (!parseImportInt(fields[3], command.limit) || command.limit < 1 || command.limit > MAX_LIST_LIMIT) {
+                error = "limit must be between 1 and " + to_string(MAX_LIST_LIMIT);
+                return false;
+            }
+            if (fields[4] != "asc" && fields[4] != "desc") {
+                error = "order must be asc or desc";
+                return false;
+            }
+            command.largestFirst = fields[4] == "desc";
+            break;
+        case CMD_PLACE_HOTEL:
+        case CMD_ADD_STOP_AT:
+        case CMD_NEAREST_HOTELS:
+        case CMD_HOTELS_WITHIN: {
+            // Coordinates come first, after the id for place-hotel
+            size_t first = command.type == CMD_PLACE_HOTEL ? 1 : 0;
+            string coordinates = fields[first] + "," + fields[first + 1];
+            if (command.type == CMD_PLACE_HOTEL && fields[1].empty() && fields[2].empty()) coordinates.clear();
+            if (!parseCoordinates(coordinates, command.latitude, command.longitude) ||
+                (command.type != CMD_PLACE_HOTEL && std::isnan(command.latitude))) {
+                error = "latitude and longitude must be numbers within range";
+                return false;
+            }
+            if (command.type == CMD_PLACE_HOTEL && !parseImportInt(fields[0], command.hotel.id)) {
+                error = "id must be an integer";
+                return false;
+            }
+            if (command.type == CMD_ADD_STOP_AT) command.text = fields[2];
+            if (command.type == CMD_HOTELS_WITHIN) {
+                char* end;
+                command.radiusKm = strtod(fields[2].c_str(), &end);
+                if (fields[2].empty() || *end != '\0' || !(command.radiusKm >= 0)) {
+                    error = "km must be a non-negative number";
+                    return false;
+                }
+            }
+            if (command.type == CMD_NEAREST_HOTELS || command.type == CMD_HOTELS_WITHIN) {
+                const string& limit = fields[command.type == CMD_NEAREST_HOTELS ? 2 : 3];
+                if (!parseImportInt(limit, command.limit) || command.limit < 1 || command.limit > MAX_LIST_LIMIT) {
+                    error = "limit must be between 1 and " + to_string(MAX_LIST_LIMIT);
+                    return false;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return true;
+}
+
+// One hotel as a single reply line
+static void formatHotelRecord(ostream& out, int id, const HotelDetails* details) {
+    out << id << '|' << details->name << '|' << hotelList.servicesOf(details) << '|' << hotelList.locationOf(details)
+        << '|' << details->roomNumber;
+}
+
+static void formatHotelRecord(ostream& out, const HotelNode* node) {
+    formatHotelRecord(out, node->id, node->details());
+}
+
+// Guards the stores in server mode: reads share it and writes, which also
+// touch SQLite, take it exclusively. list-hotels reads a snapshot instead and
+// only takes it to look up where to resume.
+static shared_mutex storeLock;
+
+static MetricId readCommandMetric(CommandType type) {
+    switch (type) {
+        case CMD_FIND_HOTEL: return MET_OP_FIND_HOTEL;
+        case CMD_LIST_HOTELS: return MET_OP_LIST_HOTELS;
+        case CMD_QUEUE_POSITION: return MET_OP_QUEUE_POSITION;
+        case CMD_NEAREST_HOTELS: return MET_OP_NEAREST_HOTELS;
+        case CMD_HOTELS_WITHIN: return MET_OP_HOTELS_WITHIN;
+        case CMD_SEARCH_HOTELS:
+        case CMD_SEARCH_GUESTS: return MET_OP_SEARCH_NAMES;
+        case CMD_FREE_ROOMS:
+        case CMD_AVAILABLE_HOTELS: return MET_OP_FREE_ROOMS;
+        case CMD_REPORT: return MET_OP_REPORT;
+        default: return MET_OP_FIND_BY_ROOMS;
+    }
+}
+
+// Reads reply with the record(s); the listing reads reply "<count>" followed
+// by one line per hotel, and the geographic ones end each line in "|<km>".
+// The name searches end each line in "|<similarity>"; a guest line is
+// id|name|ticket. available-hotels ends each line in "|<free rooms>".
+// report replies hotels|rooms|waiting|front wait s|served|mean wait s|longest
+// wait s, then location|<name>|hotels|rooms and amenity|<name>|hotels lines.
+static bool executeReadCommand(const Command& command, string& reply) {
+    ScopedTimer timer(readCommandMetric(command.type));
+    ostringstream out;
+    switch (command.type) {
+        case CMD_FIND_HOTEL: {
+            HotelNode* node = hotelList.findHotel(command.hotel.id);
+            if (!node) {
+                reply = "Hotel not found!";
+                timer.fail();
+                return false;
+            }
+            formatHotelRecord(out, node);
+            break;
+        }
+        case CMD_LIST_HOTELS: {
+            // Pinned first, so the node looked up below outlives the lock
+            HotelLinkedList::ReadSnapshot snapshot(hotelList);
+            const HotelNode* node = snapshot.first();
+            if (command.hotel.id != 0) {
+                {
+                    shared_lock<shared_mutex> guard(storeLock);
+                    node = hotelList.findHotel(command.hotel.id);
+                }
+                if (!node || !snapshot.recordOf(node)) {
+                    reply = "Hotel not found!";
+                    timer.fail();
+                    return false;
+                }
+                node = snapshot.next(node);
+            }
+            ostringstream rows;
+            int count = 0;
+            for (; node && count < command.limit; node = snapshot.next(node), count++) {
+                rows << '\n';
+                formatHotelRecord(rows, node->id, snapshot.recordOf(node));
+            }
+            out << count << rows.str();
+            break;
+        }
+        case CMD_HOTELS_BY_ROOMS: {
+            vector<HotelNode*> matches;
+            hotelList.findByRooms(command.text, command.minRooms, command.maxRooms, command.largestFirst,
+                                  size_t(command.limit), matches);
+            out << matches.size();
+            for (size_t i = 0; i < matches.size(); i++) {
+                out << '\n';
+                formatHotelRecord(out, matches[i]);
+            }
+            break;
+        }
+        case CMD_NEAREST_HOTELS:
+        case CMD_HOTELS_WITHIN: {
+            vector<GeoIndex::Match> matches;
+            if (command.type == CMD_NEAREST_HOTELS) {
+                hotelList.nearestHotels(command.latitude, command.longitude, size_t(command.limit), matches);
+            } else {
+                hotelList.hotelsWithin(command.latitude, command.longitude, command.radiusKm, size_t(command.limit),
+                                       matches);
+            }
+            out << matches.size() << fixed << setprecision(3);
+            for (size_t i = 0; i < matches.size(); i++) {
+                out << '\n';
+                formatHotelRecord(out, matches[i].node);
+                out << '|' << matches[i].km;
+            }
+            break;
+        }
+        case CMD_SEARCH_HOTELS:
+        case CMD_SEARCH_GUESTS: {
+            vector<TrigramIndex::Match> matches;
+            if (command.type == CMD_SEARCH_HOTELS) hotelList.searchByName(command.text, size_t(command.limit), matches);
+            else guestQueue.searchByName(command.text, size_t(command.limit), matches);
+            out << matches.size() << fixed << setprecision(3);
+            for (size_t i = 0; i < matches.size(); i++) {
+                out << '\n';
+                if (command.type == CMD_SEARCH_HOTELS) {
+                    formatHotelRecord(out, hotelList.findHotel(matches[i].id));
+                } else {
+                    GuestNode* node = guestQueue.findGuest(matches[i].id);
+                    out << node->id << '|' << node->details->name << '|' << node->queuePosition;
+                }
+                out << '|' << matches[i].score;
+            }
+            break;
+        }
+        case CMD_FREE_ROOMS: {
+            HotelNode* node = hotelList.findHotel(command.booking.hotelId);
+            if (!node) {
+                reply = "Hotel not found!";
+                timer.fail();
+                return false;
+            }
+            out << "Free rooms: " << freeRoomsFor(bookings, node, command.booking.checkIn, command.booking.checkOut)
+                << " of " << node->roomNumber;
+            break;
+        }
+        case CMD_AVAILABLE_HOTELS: {
+            vector<FreeHotel> matches;
+            findFreeHotels(hotelList, bookings, command.text, command.booking.rooms, command.booking.checkIn,
+                           command.booking.checkOut, size_t(command.limit), matches);
+            out << matches.size();
+            for (size_t i = 0; i < matches.size(); i++) {
+                out << '\n';
+                formatHotelRecord(out, matches[i].node);
+                out << '|' << matches[i].freeRooms;
+            }
+            break;
+        }
+        case CMD_REPORT: {
+            ManagementReport report;
+            readReport(hotelList, guestQueue, report);
+            out << report.hotels << '|' << report.rooms << '|' << report.waiting << fixed << setprecision(1) << '|'
+                << report.frontWaitSeconds << '|' << report.served << '|' << report.meanServedWaitSeconds << '|'
+                << report.longestServedWaitSeconds;
+            for (size_t i = 0; i < report.locations.size(); i++) {
+                const ManagementReport::LocationRow& row = report.locations[i];
+                out << "\nlocation|" << row.location << '|' << row.hotels << '|' << row.rooms;
+            }
+            for (size_t i = 0; i < report.amenities.size(); i++) {
+                out << "\namenity|" << report.amenities[i].amenity << '|' << report.amenities[i].hotels;
+            }
+            break;
+        }
+        case CMD_QUEUE_POSITION: {
+            GuestNode* node = guestQueue.findGuest(command.guest.id);
+            if (!node) {
+                reply = "Guest not found in the queue.";
+                timer.fail();
+                return false;
+            }
+            out << "Position: " << guestQueue.rankOf(command.guest.id) << " (Ticket #" << node->queuePosition << ")";
+            break;
+        }
+        default:
+            break;
+    }
+    reply = out.str();
+    return true;
+}
+
+bool executeCommand(const Command& command, string& reply) {
+    if (isReadCommand(command.type)) return executeReadCommand(command, reply);
+    switch (command.type) {
+        case CMD_ADD_HOTEL: return addHotelRecord(Hotel(command.hotel), reply);
+        case CMD_UPDATE_HOTEL: {
+            // update-hotel carries no coordinates; keep the ones on record
+            Hotel hotel = command.hotel;
+            HotelNode* node = hotelList.findHotel(hotel.id);
+            if (node) {
+                hotel.latitude = node->details()->latitude;
+                hotel.longitude = node->details()->longitude;
+            }
+            return updateHotelRecord(hotel, reply);
+        }
+        case CMD_DELETE_HOTEL: return deleteHotelRecord(command.hotel.id, reply);
+        case CMD_ENQUEUE_GUEST: {
+            Guest guest = command.guest;
+            return enqueueGuest(guest, reply);
+        }
+        case CMD_SERVE_GUEST: {
+            Guest served;
+            return serveNextGuest(served, reply);
+        }
+        case CMD_CANCEL_GUEST: return cancelGuest(command.guest.id, reply);
+        case CMD_ADD_STOP: return addItineraryStop(ItineraryStop(command.text), reply);
+        case CMD_PLACE_HOTEL: return setHotelCoordinates(command.hotel.id, command.latitude, command.longitude, reply);
+        case CMD_ADD_STOP_AT:
+            return addItineraryStop(ItineraryStop(command.text, command.latitude, command.longitude), reply);
+        case CMD_REFRESH: return refreshFromDatabase(reply);
+        case CMD_BOOK: {
+            Booking booking = command.booking;
+            return bookHotelRooms(booking, reply);
+        }
+        case CMD_CANCEL_BOOKING: return cancelBookingRecord(command.booking.id, reply);
+        default:
+            reply = "Error: unknown command.";
+            return false;
+    }
+}
+
+// Execute commands from a file (or stdin for "-"), one reply line each:
+// "OK <message>" or "ERR <message>"
+int runBatch(const string& path) {
+    ifstream file;
+    if (path != "-") {
+        file.open(path.c_str());
+        if (!file) {
+            cerr << "Error opening command file: " << path << endl;
+            return 1;
+        }
+    }
+    istream& in = path == "-" ? cin : file;
+
+    openSession();
+    int failed = 0;
+    int lineNumber = 0;
+    string line, reply, error;
+    Command command;
+    while (getline(in, line)) {
+        lineNumber++;
+        if (isCommandComment(line)) continue;
+        if (!parseCommand(line, command, error)) {
+            cout << "ERR line " << lineNumber << ": " << error << "\n";
+            failed++;
+        } else if (executeCommand(command, reply)) {
+            cout << "OK " << reply << "\n";
+        } else {
+            cout << "ERR " << reply << "\n";
+            failed++;
+        }
+    }
+    cout << flush;
+    if (!closeSession()) failed++;
+    return failed ? 1 : 0;
+}
+
+static double percentileOf(const vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    size_t rank = size_t(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[rank];
+}
+
+// Re-run a recorded workload, flat out (rate 0) or paced at `rate` commands
+// per second. Latencies are per command; when paced they are measured from
+// the scheduled start, so falling behind shows up as latency rather than
+// silently stretching the run.
+int runReplay(const string& path, double rate) {
+    ifstream file(path.c_str());
+    if (!file) {
+        cerr << "Error opening workload file: " << path << endl;
+        return 1;
+    }
+    vector<Command> commands;
+    int lineNumber = 0;
+    int rejected = 0;
+    string line, error;
+    while (getline(file, line)) {
+        lineNumber++;
+        if (isCommandComment(line)) continue;
+        Command command;
+        if (parseCommand(line, command, error)) {
+            commands.push_back(command);
+        } else {
+            cerr << "Skipping line " << lineNumber << ": " << error << endl;
+            rejected++;
+        }
+    }
+
+    openSession();
+    vector<double> latencies[CMD_COUNT];
+    int errors[CMD_COUNT] = {0};
+    double busy[CMD_COUNT] = {0};
+    string reply;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < commands.size(); i++) {
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        chrono::steady_clock::time_point scheduled = begin;
+        if (rate > 0) {
+            scheduled = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(i / rate));
+            if (scheduled > begin) this_thread::sleep_until(scheduled);
+            begin = chrono::steady_clock::now();
+        }
+        bool ok = executeCommand(commands[i], reply);
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+        CommandType type = commands[i].type;
+        latencies[type].push_back(chrono::duration<double, micro>(end - scheduled).count());
+        busy[type] += chrono::duration<double>(end - begin).count();
+        if (!ok) errors[type]++;
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    bool closed = closeSession();
+
+    cout << "\nReplayed " << commands.size() << " command(s) in " << fixed << setprecision(3) << elapsed << " s ("
+         << setprecision(0) << (elapsed > 0 ? commands.size() / elapsed : 0) << " commands/s"
+         << (rate > 0 ? ", target " + to_string(int(rate)) + "/s" : string(", unthrottled")) << ")\n";
+    if (rejected) cout << rejected << " line(s) could not be parsed\n";
+    cout << left << setw(15) << "command" << right << setw(9) << "count" << setw(8) << "errors" << setw(12) << "ops/s"
+         << setw(11) << "p50 us" << setw(11) << "p99 us" << "\n";
+    for (int type = 0; type < CMD_COUNT; type++) {
+        vector<double>& samples = latencies[type];
+        if (samples.empty()) continue;
+        sort(samples.begin(), samples.end());
+        cout << left << setw(15) << commandSpecs[type].name << right << setw(9) << samples.size() << setw(8) << errors[type]
+             << setw(12) << setprecision(0) << (busy[type] > 0 ? samples.size() / busy[type] : 0)
+             << setw(11) << setprecision(1) << percentileOf(samples, 0.50)
+             << setw(11) << percentileOf(samples, 0.99) << "\n";
+    }
+    return closed ? 0 : 1;
+}
+
+
+// ---------------------------------------------------------------------------
+// Server mode
+// The command language over TCP on localhost: one request per line, one reply
+// per request ("OK ..." or "ERR ..."; list-hotels adds its rows). A single
+// epoll thread accepts and reads; complete lines go to a worker pool. A
+// connection is owned by at most one worker at a time, so its replies come
+// back in request order, while different connections run in parallel. Reads
+// share storeLock and writes take it exclusively, except list-hotels, which
+// pages through a snapshot and so never waits behind a write.
+// Run with: ContactMGMTSys --serve <port> [workers]
+//           ContactMGMTSys --loadgen <port> [connections] [seconds] [writePercent]
+// ---------------------------------------------------------------------------
+
+static volatile sig_atomic_t serverStopping = 0;
+
+static void stopServer(int) {
+    serverStopping = 1;
+}
+
+// Parse, lock and execute one request line; returns the reply to send
+static string handleRequest(const string& line) {
+    if (isCommandComment(line)) return string();
+    Command command;
+    string reply;
+    if (!parseCommand(line, command, reply)) return "ERR " + reply + "\n";
+    bool ok;
+    if (command.type == CMD_LIST_HOTELS) {
+        ok = executeCommand(command, reply);
+    } else if (isReadCommand(command.type)) {
+        shared_lock<shared_mutex> guard(storeLock);
+        ok = executeCommand(command, reply);
+    } else {
+        unique_lock<shared_mutex> guard(storeLock);
+        ok = executeCommand(command, reply);
+    }
+    return (ok ? "OK " : "ERR ") + reply + "\n";
+}
+
+#ifndef _WIN32
+const size_t MAX_REQUEST_BYTES = 1 << 20;
+
+struct ServerConnection {
+    int fd;
+    string input;          // Bytes not yet split into lines (event loop only)
+    mutex lock;            // Guards the fields below
+    deque<string> pending; // Request lines waiting for a worker
+    string output;         // Replies not yet written to the socket
+    bool busy;             // A worker is draining `pending`
+    bool watchingWrites;   // EPOLLOUT is registered
+
+    explicit ServerConnection(int fd) : fd(fd), busy(false), watchingWrites(false) {}
+    ~ServerConnection() { ::close(fd); } // Last owner closes, so a worker never writes to a reused fd
+};
+
+class CommandServer {
+public:
+    explicit CommandServer(int workerCount)
+        : workerCount(workerCount), epollFd(-1), listenFd(-1), stopping(false), accepted(0), requests(0) {}
+
+    int run(int port) {
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int enable = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(uint16_t(port));
+        if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, SOMAXCONN) != 0) {
+            cerr << "Error listening on port " << port << ": " << strerror(errno) << endl;
+            if (listenFd >= 0) ::close(listenFd);
+            return 1;
+        }
+        epollFd = epoll_create1(0);
+        watch(listenFd, EPOLLIN, EPOLL_CTL_ADD);
+
+        for (int i = 0; i < workerCount; i++) workers.push_back(thread(&CommandServer::workerLoop, this));
+        cout << "Serving on 127.0.0.1:" << port << " with " << workerCount << " worker(s). Ctrl+C to stop." << endl;
+
+        epoll_event events[64];
+        while (!serverStopping) {
+            int ready = epoll_wait(epollFd, events, 64, 500);
+            for (int i = 0; i < ready; i++) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptAll();
+                    continue;
+                }
+                unordered_map<int, shared_ptr<ServerConnection> >::iterator it = connections.find(fd);
+                if (it == connections.end()) continue;
+                shared_ptr<ServerConnection> connection = it->second;
+                if (events[i].events & EPOLLOUT) {
+                    lock_guard<mutex> guard(connection->lock);
+                    flush(*connection);
+                }
+                if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !readRequests(connection)) {
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+                    connections.erase(fd);
+                }
+            }
+        }
+
+        {
+            lock_guard<mutex> guard(queueLock);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+        connections.clear();
+        ::close(epollFd);
+        ::close(listenFd);
+        cout << "\nServer stopped after " << accepted << " connection(s) and " << requests << " request(s).\n";
+        return 0;
+    }
+
+private:
+    int workerCount;
+    int epollFd;
+    int listenFd;
+    unordered_map<int, shared_ptr<ServerConnection> > connections; // Event loop only
+    vector<thread> workers;
+    mutex queueLock;
+    condition_variable queueReady;
+    deque<shared_ptr<ServerConnection> > readyConnections; // Connections with pending lines
+    bool stopping;
+    long accepted;
+    atomic<long> requests;
+
+    void watch(int fd, uint32_t events, int operation) {
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, operation, fd, &event);
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK);
+            if (fd < 0) return; // EAGAIN once the backlog is drained
+            int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            connections[fd] = make_shared<ServerConnection>(fd);
+            watch(fd, EPOLLIN, EPOLL_CTL_ADD);
+            accepted++;
+        }
+    }
+
+    // Read what the socket has and queue complete lines; false to close
+    bool readRequests(const shared_ptr<ServerConnection>& connection) {
+        char buffer[16384];
+        bool open = true;
+        while (true) {
+            ssize_t received = recv(connection->fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                connection->input.append(buffer, size_t(received));
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) open = false;
+            if (received < 0 && errno == EINTR) continue;
+            break;
+        }
+
+        vector<string> lines;
+        size_t start = 0, end;
+        while ((end = connection->input.find('\n', start)) != string::npos) {
+            lines.push_back(connection->input.substr(start, end - start));
+            start = end + 1;
+        }
+        connection->input.erase(0, start);
+        if (connection->input.size() > MAX_REQUEST_BYTES) open = false;
+
+        if (!lines.empty()) {
+            bool schedule = false;
+            {
+                lock_guard<mutex> guard(connection->lock);
+                for (size_t i = 0; i < lines.size(); i++) connection->pending.push_back(lines[i]);
+                if (!connection->busy) {
+                    connection->busy = true;
+                    schedule = true;
+                }
+            }
+            if (schedule) {
+                {
+                    lock_guard<mutex> guard(queueLock);
+                    readyConnections.push_back(connection);
+                }
+                queueReady.notify_one();
+            }
+        }
+        return open;
+    }
+
+    // Write buffered replies; called with connection.lock held
+    void flush(ServerConnection& connection) {
+        while (!connection.output.empty()) {
+            ssize_t sent = send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+            if (sent > 0) {
+                connection.output.erase(0, size_t(sent));
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (!connection.watchingWrites) {
+                    watch(connection.fd, EPOLLIN | EPOLLOUT, EPOLL_CTL_MOD);
+                    connection.watchingWrites = true;
+                }
+                return;
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else {
+                connection.output.clear(); // Peer is gone
+            }
+        }
+        if (connection.watchingWrites) {
+            watch(connection.fd, EPOLLIN, EPOLL_CTL_MOD);
+            connection.watchingWrites = false;
+        }
+    }
+
+    void workerLoop() {
+        while (true) {
+            shared_ptr<ServerConnection> connection;
+            {
+                unique_lock<mutex> guard(queueLock);
+                queueReady.wait(guard, [this] { return stopping || !readyConnections.empty(); });
+                if (readyConnections.empty()) return;
+                connection = readyConnections.front();
+                readyConnections.pop_front();
+            }
+            // Drain this connection's lines in order, replying once the pipeline is empty
+            while (true) {
+                string line;
+                {
+                    lock_guard<mutex> guard(connection->lock);
+                    if (connection->pending.empty()) {
+                        connection->busy = false;
+                        break;
+                    }
+                    line.swap(connection->pending.front());
+                    connection->pending.pop_front();
+                }
+                string reply = handleRequest(line);
+                requests++;
+                lock_guard<mutex> guard(connection->lock);
+                connection->output += reply;
+                if (connection->pending.empty()) flush(*connection);
+            }
+        }
+    }
+};
+#endif
+
+int runServer(int port, int workers) {
+#ifdef _WIN32
+    (void)port;
+    (void)workers;
+    cerr << "Server mode needs epoll and is only available on Linux.\n";
+    return 1;
+#else
+    if (port <= 0 || port > 65535) {
+        cerr << "Usage: --serve <port> [workers]\n";
+        return 1;
+    }
+    if (workers <= 0) workers = max(2, int(thread::hardware_concurrency()));
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    signal(SIGPIPE, SIG_IGN);
+    openSession();
+    CommandServer server(workers);
+    int status = server.run(port);
+    if (!closeSession() && status == 0) status = 1;
+    return status;
+#endif
+}
+
+#ifndef _WIN32
+// Blocking line reader for the load generator's client sockets
+class LineClient {
+public:
+    explicit LineClient(int fd) : fd(fd), start(0) {}
+    ~LineClient() { if (fd >= 0) ::close(fd); }
+
+    bool sendLine(const string& line) {
+        string data = line + "\n";
+        size_t offset = 0;
+        while (offset < data.size()) {
+            ssize_t sent = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+            if (sent <= 0) return false;
+            offset += size_t(sent);
+        }
+        return true;
+    }
+
+    bool readLine(string& line) {
+        size_t end;
+        while ((end = buffer.find('\n', start)) == string::npos) {
+            buffer.erase(0, start);
+            start = 0;
+            char chunk[16384];
+            ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+            if (received <= 0) return false;
+            buffer.append(chunk, size_t(received));
+        }
+        line.assign(buffer, start, end - start);
+        start = end + 1;
+        return true;
+    }
+
+    // One request and its full reply; false if the connection broke
+    bool request(const string& line, bool& ok) {
+        string reply;
+        if (!sendLine(line) || !readLine(reply)) return false;
+        ok = reply.compare(0, 3, "OK ") == 0;
+        if (ok && line.compare(0, 12, "list-hotels|") == 0) {
+            int rows = atoi(reply.c_str() + 3);
+            for (int i = 0; i < rows; i++) {
+                if (!readLine(reply)) return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    int fd;
+    string buffer;
+    size_t start;
+};
+
+static int connectLocal(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(uint16_t(port));
+    if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    return fd;
+}
+
+struct LoadgenResult {
+    vector<double> reads;  // Latencies in microseconds
+    vector<double> writes;
+    long errors;
+    bool broken;
+    LoadgenResult() : errors(0), broken(false) {}
+};
+
+static void printLoadgenRow(const string& what, vector<double>& samples, double seconds) {
+    sort(samples.begin(), samples.end());
+    cout << left << setw(8) << what << right << setw(10) << samples.size() << setw(12) << fixed << setprecision(0)
+         << samples.size() / seconds << setw(10) << setprecision(1) << percentileOf(samples, 0.50)
+         << setw(10) << percentileOf(samples, 0.99) << setw(10) << percentileOf(samples, 0.999)
+         << setw(10) << (samples.empty() ? 0 : samples.back()) << "\n";
+}
+#endif
+
+// Closed-loop load against a running server: each connection sends one
+// request, waits for the reply, and repeats. Reads are find-hotel and
+// list-hotels pages; writes are a guest joining then leaving the queue, so
+// the store is left as it was found.
+int runLoadgen(int port, int connectionCount, double seconds, int writePercent) {
+#ifdef _WIN32
+    (void)port;
+    (void)connectionCount;
+    (void)seconds;
+    (void)writePercent;
+    cerr << "The load generator is only available on Linux.\n";
+    return 1;
+#else
+    connectionCount = max(1, min(connectionCount, 100));
+    vector<int> hotelIds;
+    {
+        LineClient probe(connectLocal(port));
+        string reply;
+        if (!probe.sendLine("list-hotels|0|" + to_string(MAX_LIST_LIMIT)) || !probe.readLine(reply) ||
+            reply.compare(0, 3, "OK ") != 0) {
+            cerr << "No server answering on 127.0.0.1:" << port << endl;
+            return 1;
+        }
+        int rows = atoi(reply.c_str() + 3);
+        for (int i = 0; i < rows && probe.readLine(reply); i++) hotelIds.push_back(atoi(reply.c_str()));
+    }
+    if (hotelIds.empty()) hotelIds.push_back(1);
+
+    vector<LoadgenResult> results(connectionCount);
+    vector<thread> clients;
+    chrono::steady_clock::time_point deadline =
+        chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+    for (int c = 0; c < connectionCount; c++) {
+        clients.push_back(thread([&, c] {
+            LoadgenResult& result = results[c];
+            LineClient client(connectLocal(port));
+            minstd_rand rng(c + 1);
+            int nextGuest = 1000000000 + c * 10000000; // Clear of real guest ids
+            bool ok;
+            while (chrono::steady_clock::now() < deadline) {
+                bool write = int(rng() % 100) < writePercent;
+                int hotelId = hotelIds[rng() % hotelIds.size()];
+                string first = write ? "enqueue-guest|" + to_string(nextGuest) + "|Load Guest"
+                               : rng() % 5 ? "find-hotel|" + to_string(hotelId)
+                                                            : "list-hotels|" + to_string(hotelId) + "|10";
+                chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+                if (!client.request(first, ok)) {
+                    result.broken = true;
+                    return;
+                }
+                chrono::steady_clock::time_point end = chrono::steady_clock::now();
+                (write ? result.writes : result.reads).push_back(chrono::duration<double, micro>(end - begin).count());
+                if (!ok) result.errors++;
+                if (write) {
+                    begin = end;
+                    if (!client.request("cancel-guest|" + to_string(nextGuest++), ok)) {
+                        result.broken = true;
+                        return;
+                    }
+                    result.writes.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count());
+                    if (!ok) result.errors++;
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < clients.size(); i++) clients[i].join();
+
+    LoadgenResult total;
+    int broken = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        total.reads.insert(total.reads.end(), results[i].reads.begin(), results[i].reads.end());
+        total.writes.insert(total.writes.end(), results[i].writes.begin(), results[i].writes.end());
+        total.errors += results[i].errors;
+        if (results[i].broken) broken++;
+    }
+    vector<double> all(total.reads);
+    all.insert(all.end(), total.writes.begin(), total.writes.end());
+
+    cout << "Load: " << connectionCount << " connection(s), " << seconds << " s, " << writePercent << "% writes\n";
+    cout << left << setw(8) << "type" << right << setw(10) << "requests" << setw(12) << "req/s" << setw(10) << "p50 us"
+         << setw(10) << "p99 us" << setw(10) << "p99.9 us" << setw(10) << "max us" << "\n";
+    printLoadgenRow("read", total.reads, seconds);
+    printLoadgenRow("write", total.writes, seconds);
+    printLoadgenRow("all", all, seconds);
+    if (total.errors) cout << total.errors << " request(s) answered ERR\n";
+    if (broken) cout << broken << " connection(s) dropped\n";
+    return broken ? 1 : 0;
+#endif
+}
+
+
+// ---------------------------------------------------------------------------
+// Benchmarks
+// Compiled only into the ContactMGMTSysBench target (CMS_BENCHMARKS), which
+// also replaces the global allocator to count heap traffic.
+// Run with: ContactMGMTSysBench --bench <name|all> [--json <path>] [--quick]
+// ---------------------------------------------------------------------------
+
+#ifdef CMS_BENCHMARKS
+
+// The hotel list as it was before the id index: every lookup, delete, size()
+// and append walks the chain. Kept only as the baseline for benchmarks.
+class LegacyHotelList {
+public:
+    struct Node {
+        Hotel data;
+        Node* next;
+        Node(Hotel hotel) : data(hotel), next(NULL) {}
+    };
+    Node* head;
+    LegacyHotelList() : head(NULL) {}
+    ~LegacyHotelList() { clearList(); }
+
+    void addHotel(Hotel hotel) {
+        Node* newNode = new Node(hotel);
+        if (!head) {
+            head = newNode;
+        } else {
+            Node* current = head;
+            while (current->next) {
+                current = current->next;
+            }
+            current->next = newNode;
+        }
+    }
+
+    bool removeHotel(int id) {
+        if (!head) return false;
+        if (head->data.id == id) {
+            Node* temp = head;
+            head = head->next;
+            delete temp;
+            return true;
+        }
+        Node* current = head;
+        while (current->next && current->next->data.id != id) {
+            current = current->next;
+        }
+        if (!current->next) return false;
+        Node* temp = current->next;
+        current->next = current->next->next;
+        delete temp;
+        return true;
+    }
+
+    Node* findHotel(int id) {
+        Node* current = head;
+        while (current) {
+            if (current->data.id == id) return current;
+            current = current->next;
+        }
+        return NULL;
+    }
+
+    int size() {
+        int count = 0;
+        for (Node* current = head; current; current = current->next) count++;
+        return count;
+    }
+
+    // Build helper for large baselines; appending through addHotel() is O(n^2)
+    void buildFrom(int n, Hotel (*make)(int)) {
+        Node* last = NULL;
+        for (int i = 1; i <= n; i++) {
+            Node* node = new Node(make(i));
+            if (last) last->next = node;
+            else head = node;
+            last = node;
+        }
+    }
+
+    void clearList() {
+        while (head) {
+            Node* next = head->next;
+            delete head;
+            head = next;
+        }
+    }
+};
+
+// Heap allocation counters for the benchmarks. Per-thread so counting adds no
+// contention; the replaced operators forward straight to malloc/free. Kept out
+// of line so GCC does not pair the inlined malloc with a sized delete.
+static thread_local unsigned long long benchAllocations = 0;
+static thread_local unsigned long long benchFrees = 0;
+static thread_local unsigned long long benchAllocatedBytes = 0;
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    benchAllocations++;
+    benchAllocatedBytes += size;
+    void* memory = malloc(size ? size : 1);
+    if (!memory) throw bad_alloc();
+    return memory;
+}
+
+__attribute__((noinline)) void operator delete(void* memory) noexcept {
+    if (memory) benchFrees++;
+    free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, size_t) noexcept {
+    if (memory) benchFrees++;
+    free(memory);
+}
+
+// Node-per-record guest queue, as before the slab pools. Benchmark baseline.
+class LegacyGuestList {
+public:
+    struct Node {
+        Guest data;
+        Node* next;
+        Node(Guest guest) : data(guest), next(NULL) {}
+    };
+    Node* head;
+    Node* tail;
+    LegacyGuestList() : head(NULL), tail(NULL) {}
+    ~LegacyGuestList() { clearList(); }
+
+    void addGuest(Guest guest) {
+        Node* newNode = new Node(guest);
+        if (!head) head = newNode;
+        else tail->next = newNode;
+        tail = newNode;
+    }
+
+    void clearList() {
+        while (head) {
+            Node* next = head->next;
+            delete head;
+            head = next;
+        }
+        tail = NULL;
+    }
+};
+
+static double benchNow() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Small deterministic PRNG so runs are comparable
+static unsigned int benchRandom(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Set by a benchmark whose built-in correctness checks fail
+static bool benchFailed = false;
+
+// --quick divides the workload sizes of the benchmarks that check their own
+// results, so the checks run in seconds (ctest runs them this way)
+static int benchDivisor = 1;
+
+static int benchSize(int n) {
+    return max(n / benchDivisor, 1);
+}
+
+static Hotel makeBenchHotel(int id) {
+    Hotel hotel;
+    hotel.id = id;
+    hotel.name = "Benchmark Hotel " + to_string(id);
+    hotel.services = "Free Wi-Fi, Restaurant, Pool";
+    hotel.location = "Lalibela";
+    hotel.roomNumber = 10 + id % 40;
+    return hotel;
+}
+
+static Guest makeBenchGuest(int id) {
+    Guest guest;
+    guest.id = id;
+    guest.name = "Guest " + to_string(id);
+    guest.queuePosition = id;
+    return guest;
+}
+
+static void printBenchRow(int n, const string& op, double legacyNs, double indexedNs) {
+    cout << setw(9) << n << "  " << left << setw(10) << op << right
+         << setw(16) << fixed << setprecision(1) << legacyNs
+         << setw(16) << indexedNs
+         << setw(12) << setprecision(1) << (indexedNs > 0 ? legacyNs / indexedNs : 0) << "x\n";
+}
+
+// Per-operation cost of the indexed hotel store against the legacy O(n) list.
+// The legacy list is sampled with fewer operations because each one is O(n).
+static void benchHotelStore() {
+    const int sizes[] = {10000, 100000, 1000000};
+    const int indexedOps = 100000;
+
+    cout << "Hotel store: legacy linked list vs id-indexed list (ns/op)\n";
+    cout << setw(9) << "hotels" << "  " << left << setw(10) << "op" << right
+         << setw(16) << "legacy" << setw(16) << "indexed" << setw(13) << "speedup\n";
+
+    for (int s = 0; s < 3; s++) {
+        int n = sizes[s];
+        int legacyOps = n >= 1000000 ? 20 : 200;
+        double legacy[5], indexed[5];
+        unsigned int rng;
+        double start;
+        volatile long sink = 0;
+
+        // Legacy list
+        {
+            LegacyHotelList store;
+            store.buildFrom(n, makeBenchHotel);
+
+            start = benchNow();
+            for (int i = 1; i <= legacyOps; i++) store.addHotel(makeBenchHotel(n + i));
+            legacy[0] = (benchNow() - start) * 1e9 / legacyOps;
+
+            rng = 12345;
+            start = benchNow();
+            for (int i = 0; i < legacyOps; i++) {
+                if (store.findHotel(1 + benchRandom(rng) % n)) sink = sink + 1;
+            }
+            legacy[1] = (benchNow() - start) * 1e9 / legacyOps;
+
+            rng = 54321;
+            double removeTime = 0;
+            for (int i = 0; i < legacyOps; i++) {
+                int id = 1 + benchRandom(rng) % n;
+                start = benchNow();
+                bool removed = store.removeHotel(id);
+                removeTime += benchNow() - start;
+                if (removed) store.addHotel(makeBenchHotel(id));
+            }
+            legacy[2] = removeTime * 1e9 / legacyOps;
+
+            start = benchNow();
+            for (int i = 0; i < legacyOps; i++) sink = sink + store.size();
+            legacy[3] = (benchNow() - start) * 1e9 / legacyOps;
+
+            start = benchNow();
+            for (int i = 0; i < legacyOps; i++) {
+                if (!store.findHotel(n + legacyOps + 1 + i)) sink = sink + 1; // isHotelIdUnique miss
+            }
+            legacy[4] = (benchNow() - start) * 1e9 / legacyOps;
+        }
+
+        // Indexed list
+        {
+            HotelLinkedList store;
+            start = benchNow();
+            for (int i = 1; i <= n; i++) store.addHotel(makeBenchHotel(i));
+            indexed[0] = (benchNow() - start) * 1e9 / n;
+
+            rng = 12345;
+            start = benchNow();
+            for (int i = 0; i < indexedOps; i++) {
+                if (store.findHotel(1 + benchRandom(rng) % n)) sink = sink + 1;
+            }
+            indexed[1] = (benchNow() - start) * 1e9 / indexedOps;
+
+            rng = 54321;
+            double removeTime = 0;
+            for (int i = 0; i < indexedOps; i++) {
+                int id = 1 + benchRandom(rng) % n;
+                start = benchNow();
+                bool removed = store.removeHotel(id);
+                removeTime += benchNow() - start;
+                if (removed) store.addHotel(makeBenchHotel(id));
+            }
+            indexed[2] = removeTime * 1e9 / indexedOps;
+
+            start = benchNow();
+            for (int i = 0; i < indexedOps; i++) sink = sink + store.size();
+            indexed[3] = (benchNow() - start) * 1e9 / indexedOps;
+
+            start = benchNow();
+            for (int i = 0; i < indexedOps; i++) {
+                if (store.isHotelIdUnique(n + 1 + i)) sink = sink + 1;
+            }
+            indexed[4] = (benchNow() - start) * 1e9 / indexedOps;
+        }
+
+        const char* ops[] = {"insert", "find", "remove", "size", "unique"};
+        for (int op = 0; op < 5; op++) printBenchRow(n, ops[op], legacy[op], indexed[op]);
+    }
+}
+
+static void printLayoutRow(const string& what, int n, const string& metric, double legacy, double pooled) {
+    cout << left << setw(8) << what << right << setw(9) << n << "  " << left << setw(20) << metric << right
+         << setw(14) << fixed << setprecision(2) << legacy << setw(14) << pooled << "\n";
+}
+
+// Allocation counts and traversal throughput of the slab-pooled lists against
+// the node-per-record layout. Record construction allocates the same strings
+// in both layouts, so the difference per record is the node bookkeeping.
+static void benchStorageLayout() {
+    const int sizes[] = {100000, 1000000};
+    const int passes = 5;
+    volatile long sink = 0;
+
+    cout << "Storage layout: node-per-record vs slab pools\n";
+    cout << left << setw(8) << "list" << right << setw(9) << "records" << "  " << left << setw(20) << "metric" << right
+         << setw(14) << "per-record" << setw(14) << "slab" << "\n";
+
+    for (int s = 0; s < 2; s++) {
+        int n = sizes[s];
+        double legacy[6], pooled[6];
+        double start;
+        unsigned long long allocs, frees;
+
+        // Hotels, node per record
+        {
+            LegacyHotelList store;
+            allocs = benchAllocations;
+            start = benchNow();
+            store.buildFrom(n, makeBenchHotel);
+            legacy[0] = (benchNow() - start) * 1e9 / n;
+            legacy[1] = double(benchAllocations - allocs) / n;
+
+            start = benchNow();
+            for (int pass = 0; pass < passes; pass++) {
+                for (LegacyHotelList::Node* node = store.head; node; node = node->next) sink = sink + node->data.roomNumber;
+            }
+            legacy[2] = n * passes / (benchNow() - start) / 1e6;
+
+            start = benchNow();
+            for (int pass = 0; pass < passes; pass++) {
+                for (LegacyHotelList::Node* node = store.head; node; node = node->next) {
+                    sink = sink + node->data.roomNumber + node->data.name.size() + node->data.location.size();
+                }
+            }
+            legacy[3] = n * passes / (benchNow() - start) / 1e6;
+
+            frees = benchFrees;
+            start = benchNow();
+            store.clearList();
+            legacy[4] = (benchNow() - start) * 1e9 / n;
+            legacy[5] = double(benchFrees - frees) / n;
+        }
+
+        // Hotels, slab pools
+        {
+            HotelLinkedList store;
+            store.reserve(n);
+            allocs = benchAllocations;
+            start = benchNow();
+            for (int i = 1; i <= n; i++) store.addHotel(makeBenchHotel(i));
+            pooled[0] = (benchNow() - start) * 1e9 / n;
+            pooled[1] = double(benchAllocations - allocs) / n;
+
+            start = benchNow();
+            for (int pass = 0; pass < passes; pass++) {
+                for (HotelNode* node = store.head; node; node = node->next) sink = sink + node->roomNumber;
+            }
+            pooled[2] = n * passes / (benchNow() - start) / 1e6;
+
+            start = benchNow();
+            for (int pass = 0; pass < passes; pass++) {
+                for (HotelNode* node = store.head; node; node = node->next) {
+                    sink = sink + node->roomNumber + node->details()->name.size() + store.locationOf(node).size();
+                }
+            }
+            pooled[3] = n * passes / (benchNow() - start) / 1e6;
+
+            frees = benchFrees;
+            start = benchNow();
+            store.clearList();
+            pooled[4] = (benchNow() - start) * 1e9 / n;
+            pooled[5] = double(benchFrees - frees) / n;
+        }
+
+        const char* hotelMetrics[] = {"build ns/record", "allocs/record", "hot walk Mrec/s",
+                                      "full walk Mrec/s", "clear ns/record", "frees/record"};
+        for (int m = 0; m < 6; m++) printLayoutRow("hotels", n, hotelMetrics[m], legacy[m], pooled[m]);
+
+        // Guests, node per record
+        {
+            LegacyGuestList queue;
+            allocs = benchAllocations;
+            start = benchNow();
+            for (int i = 1; i <= n; i++) queue.addGuest(makeBenchGuest(i));
+            legacy[0] = (benchNow() - start) * 1e9 / n;
+            legacy[1] = double(benchAllocations - allocs) / n;
+
+            start = benchNow();
+            for (int pass = 0; pass < passes; pass++) {
+                for (LegacyGuestList::Node* node = queue.head; node; node = node->next) sink = sink + node->data.queuePosition;
+            }
+            legacy[2] = n * passes / (benchNow() - start) / 1e6;
+
+            frees = benchFrees;
+            start = benchNow();
+            queue.clearList();
+            legacy[4] = (benchNow() - start) * 1e9 / n;
+            legacy[5] = double(benchFrees - frees) / n;
+        }
+
+        // Guests, slab pools
+        {
+            GuestLinkedList queue;
+            allocs = benchAllocations;
+            start = benchNow();
+            for (int i = 1; i <= n; i++) queue.addGuest(makeBenchGuest(i));
+            pooled[0] = (benchNow() - start) * 1e9 / n;
+            pooled[1] = double(benchAllocations - allocs) / n;
+
+            start = benchNow();
+            for (int pass = 0; pass < passes; pass++) {
+                for (GuestNode* node = queue.head; node; node = node->next) sink = sink + node->queuePosition;
+            }
+            pooled[2] = n * passes / (benchNow() - start) / 1e6;
+
+            frees = benchFrees;
+            start = benchNow();
+            queue.clearList();
+            pooled[4] = (benchNow() - start) * 1e9 / n;
+            pooled[5] = double(benchFrees - frees) / n;
+        }
+
+        const char* guestMetrics[] = {"build ns/record", "allocs/record", "hot walk Mrec/s", "", "clear ns/record", "frees/record"};
+        for (int m = 0; m < 6; m++) {
+            if (m != 3) printLayoutRow("guests", n, guestMetrics[m], legacy[m], pooled[m]);
+        }
+    }
+}
+
+// Inserts a hotel the way the write paths did before the statement cache:
+// parse, plan and finalize the SQL for every row.
+static void insertHotelUncached(const Hotel& hotel) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "INSERT INTO Hotels (id, name, services, location, roomNumber) VALUES (?, ?, ?, ?, ?);",
+                           -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, hotel.id);
+        sqlite3_bind_text(stmt, 2, hotel.name.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, hotel.services.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, hotel.location.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 5, hotel.roomNumber);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+}
+
+static void updateHotelUncached(const Hotel& hotel) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "UPDATE Hotels SET name=?, services=?, location=?, roomNumber=? WHERE id=?;",
+                           -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, hotel.name.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, hotel.services.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, hotel.location.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 4, hotel.roomNumber);
+        sqlite3_bind_int(stmt, 5, hotel.id);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+}
+
+static void deleteHotelUncached(int id) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "DELETE FROM Hotels WHERE id=?;", -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, id);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+}
+
+// Sustained insert/update/delete load against an in-memory database, so the
+// numbers show statement parse cost rather than disk syncs.
+static void benchStatementCache() {
+    const int n = 100000;
+    vector<Hotel> hotels;
+    hotels.reserve(n);
+    for (int i = 1; i <= n; i++) hotels.push_back(makeBenchHotel(i));
+
+    double uncached[3], cached[3];
+    double start;
+
+    initializeDatabase(":memory:");
+    start = benchNow();
+    for (int i = 0; i < n; i++) insertHotelUncached(hotels[i]);
+    uncached[0] = n / (benchNow() - start);
+    start = benchNow();
+    for (int i = 0; i < n; i++) updateHotelUncached(hotels[i]);
+    uncached[1] = n / (benchNow() - start);
+    start = benchNow();
+    for (int i = 0; i < n; i++) deleteHotelUncached(hotels[i].id);
+    uncached[2] = n / (benchNow() - start);
+    closeDatabase();
+
+    initializeDatabase(":memory:");
+    start = benchNow();
+    for (int i = 0; i < n; i++) saveHotelToDatabase(hotels[i]);
+    cached[0] = n / (benchNow() - start);
+    start = benchNow();
+    for (int i = 0; i < n; i++) updateHotelInDatabase(hotels[i]);
+    cached[1] = n / (benchNow() - start);
+    start = benchNow();
+    for (int i = 0; i < n; i++) deleteHotelFromDatabase(hotels[i].id);
+    cached[2] = n / (benchNow() - start);
+
+    cout << "Statement cache: prepare per call vs prepared once (" << n << " rows, ops/s)\n";
+    const char* ops[] = {"insert", "update", "delete"};
+    for (int op = 0; op < 3; op++) {
+        cout << left << setw(8) << ops[op] << right << setw(14) << fixed << setprecision(0) << uncached[op]
+             << setw(14) << cached[op] << setw(10) << setprecision(2) << cached[op] / uncached[op] << "x\n";
+    }
+    statements.printStats();
+    closeDatabase();
+}
+
+// Bulk import throughput into a fresh on-disk database
+static void benchBulkImport() {
+    const int n = 500000;
+    const char* csvPath = "bench_import.csv";
+    const char* dbPath = "bench_import.db";
+    {
+        ofstream out(csvPath);
+        out << "id,name,services,location,roomNumber\n";
+        for (int i = 1; i <= n; i++) {
+            Hotel hotel = makeBenchHotel(i);
+            out << hotel.id << "," << hotel.name << ",\"" << hotel.services << "\"," << hotel.location << ","
+                << hotel.roomNumber << "\n";
+        }
+    }
+    remove(dbPath);
+
+    const int batchSizes[] = {1000, 50000};
+    cout << "Bulk import: " << n << " hotels from CSV\n";
+    for (int b = 0; b < 2; b++) {
+        initializeDatabase(dbPath);
+        hotelList.clearList();
+        ImportReport report;
+        importFile(csvPath, IMPORT_HOTELS, batchSizes[b], report);
+        cout << "batch " << setw(6) << batchSizes[b] << ": ";
+        printImportReport(report);
+        closeDatabase();
+        remove(dbPath);
+    }
+    hotelList.clearList();
+    remove(csvPath);
+}
+
+// Time to render one page with keyset queries against rendering the whole
+// table, which is what a full listing costs before the first row appears.
+static void benchPagination() {
+    const int sizes[] = {10000, 100000, 1000000};
+    const int probes = 200;
+    const char* dbPath = "bench_pages.db";
+    int loaded = 0;
+    remove(dbPath);
+    initializeDatabase(dbPath);
+
+    cout << "Paged listing: time to first page (us)\n";
+    cout << setw(9) << "hotels" << setw(14) << "first page" << setw(14) << "middle page"
+         << setw(14) << "last page" << setw(16) << "full listing\n";
+    for (int s = 0; s < 3; s++) {
+        int n = sizes[s];
+        execSql("BEGIN;");
+        for (int i = loaded + 1; i <= n; i++) saveHotelToDatabase(makeBenchHotel(i));
+        execSql("COMMIT;");
+        loaded = n;
+
+        const int starts[] = {numeric_limits<int>::min(), n / 2, n - DEFAULT_PAGE_SIZE};
+        double pageUs[3];
+        for (int k = 0; k < 3; k++) {
+            double start = benchNow();
+            for (int i = 0; i < probes; i++) {
+                ostringstream page;
+                PageCursor cursor;
+                bool hasMore;
+                fetchPage(PAGE_HOTELS, 0, starts[k], false, DEFAULT_PAGE_SIZE, page, cursor, hasMore);
+            }
+            pageUs[k] = (benchNow() - start) * 1e6 / probes;
+        }
+
+        double start = benchNow();
+        {
+            ostringstream all;
+            sqlite3_stmt* stmt;
+            sqlite3_prepare_v2(db, "SELECT * FROM Hotels;", -1, &stmt, NULL);
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                formatHotel(all, sqlite3_column_int(stmt, 0), (const char*)sqlite3_column_text(stmt, 1),
+                            (const char*)sqlite3_column_text(stmt, 2), (const char*)sqlite3_column_text(stmt, 3),
+                            sqlite3_column_int(stmt, 4));
+            }
+            sqlite3_finalize(stmt);
+        }
+        double fullUs = (benchNow() - start) * 1e6;
+
+        cout << setw(9) << n << fixed << setprecision(1) << setw(14) << pageUs[0] << setw(14) << pageUs[1]
+             << setw(14) << pageUs[2] << setw(15) << fullUs << "\n";
+    }
+    closeDatabase();
+    remove(dbPath);
+}
+
+// Location and room-capacity queries over 1M hotels: the ordered RoomIndex
+// against a full scan (with partial_sort for top-k), plus the same queries
+// cold against the SQLite composite index.
+static void benchRoomIndex() {
+    const int n = benchSize(1000000);
+    const int locations = 20;
+    const int repeats = 200;
+    const char* dbPath = "bench_rooms.db";
+
+    HotelLinkedList store;
+    store.reserve(n);
+    vector<Hotel> hotels;
+    hotels.reserve(n);
+    unsigned int rng = 15;
+    for (int i = 1; i <= n; i++) {
+        Hotel hotel = makeBenchHotel(i);
+        hotel.location = "City " + to_string(benchRandom(rng) % locations);
+        hotel.roomNumber = 1 + int(benchRandom(rng) % 200);
+        hotels.push_back(hotel);
+    }
+
+    double start = benchNow();
+    for (int i = 0; i < n; i++) store.addHotel(Hotel(hotels[i]));
+    double insertSeconds = benchNow() - start;
+
+    // The share of addHotel() spent keeping the room index up to date
+    double indexSeconds;
+    {
+        RoomIndex rebuilt;
+        start = benchNow();
+        for (HotelNode* node = store.head; node; node = node->next) rebuilt.add(node, store.locationOf(node));
+        indexSeconds = benchNow() - start;
+    }
+    cout << "Room index: " << n << " hotels over " << locations << " locations, insert " << fixed << setprecision(2)
+         << insertSeconds << " s, of which room index " << indexSeconds << " s\n";
+
+    struct Query {
+        const char* text;
+        const char* location;
+        int minRooms, maxRooms;
+        bool largestFirst;
+        size_t limit;
+    };
+    const Query queries[] = {
+        {"City 3, 150-160 rooms, smallest first, 100", "City 3", 150, 160, false, 100},
+        {"City 7, largest 10", "city 7 ", 0, 1000, true, 10},
+        {"any location, 195-200 rooms, 1000", "", 195, 200, false, 1000},
+        {"any location, largest 20", "", 0, 1000, true, 20},
+        {"City 11, at least 50 rooms, largest 1000", "City 11", 50, 1000, true, 1000},
+    };
+
+    remove(dbPath);
+    initializeDatabase(dbPath);
+    execSql("BEGIN;");
+    for (int i = 0; i < n; i++) saveHotelToDatabase(hotels[i]);
+    execSql("COMMIT;");
+    cout << left << setw(44) << "query" << right << setw(9) << "matches" << setw(12) << "scan ms" << setw(12)
+         << "index us" << setw(12) << "sqlite us" << setw(11) << "speedup\n";
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        const Query& query = queries[q];
+        vector<HotelNode*> matches;
+        start = benchNow();
+        for (int r = 0; r < repeats; r++) {
+            store.findByRooms(query.location, query.minRooms, query.maxRooms, query.largestFirst, query.limit, matches);
+        }
+        double indexUs = (benchNow() - start) * 1e6 / repeats;
+
+        string key = RoomIndex::locationKey(query.location);
+        vector<HotelNode*> scanned;
+        start = benchNow();
+        for (HotelNode* node = store.head; node; node = node->next) {
+            if (node->roomNumber < query.minRooms || node->roomNumber > query.maxRooms) continue;
+            if (!key.empty() && RoomIndex::locationKey(store.locationOf(node)) != key) continue;
+            scanned.push_back(node);
+        }
+        size_t keep = min(query.limit, scanned.size());
+        bool largestFirst = query.largestFirst;
+        partial_sort(scanned.begin(), scanned.begin() + keep, scanned.end(),
+                     [largestFirst](const HotelNode* a, const HotelNode* b) {
+                         if (a->roomNumber != b->roomNumber) {
+                             return largestFirst ? a->roomNumber > b->roomNumber : a->roomNumber < b->roomNumber;
+                         }
+                         return largestFirst ? a->id > b->id : a->id < b->id;
+                     });
+        scanned.resize(keep);
+        double scanMs = (benchNow() - start) * 1e3;
+        if (scanned != matches) {
+            cout << "MISMATCH: scan and index disagree for " << query.text << "\n";
+            benchFailed = true;
+        }
+
+        // Cold: a fresh prepare each time, as an ad-hoc report would
+        string sql = "SELECT id FROM Hotels WHERE roomNumber BETWEEN ? AND ?";
+        if (!key.empty()) sql += " AND location = ? COLLATE NOCASE";
+        sql += query.largestFirst ? " ORDER BY roomNumber DESC, id DESC LIMIT ?;" : " ORDER BY roomNumber, id LIMIT ?;";
+        size_t sqliteRows = 0;
+        start = benchNow();
+        for (int r = 0; r < repeats; r++) {
+            sqlite3_stmt* stmt;
+            sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, NULL);
+            int param = 1;
+            sqlite3_bind_int(stmt, param++, query.minRooms);
+            sqlite3_bind_int(stmt, param++, query.maxRooms);
+            if (!key.empty()) sqlite3_bind_text(stmt, param++, key.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, param++, int(query.limit));
+            sqliteRows = 0;
+            while (sqlite3_step(stmt) == SQLITE_ROW) sqliteRows++;
+            sqlite3_finalize(stmt);
+        }
+        double sqliteUs = (benchNow() - start) * 1e6 / repeats;
+        if (sqliteRows != matches.size()) {
+            cout << "MISMATCH: SQLite returned " << sqliteRows << " rows for " << query.text << "\n";
+            benchFailed = true;
+        }
+
+        cout << left << setw(44) << query.text << right << setw(9) << matches.size() << setw(12) << setprecision(2)
+             << scanMs << setw(12) << setprecision(1) << indexUs << setw(12) << sqliteUs << setw(10) << setprecision(0)
+             << scanMs * 1e3 / indexUs << "x\n";
+    }
+    closeDatabase();
+    remove(dbPath);
+
+    // Reindexing cost through updateHotel() when the room count changes
+    const int updates = benchSize(100000);
+    start = benchNow();
+    for (int i = 1; i <= updates; i++) {
+        Hotel hotel = store.toHotel(store.findHotel(i));
+        hotel.roomNumber = 1 + (hotel.roomNumber + 37) % 200;
+        store.updateHotel(hotel);
+    }
+    cout << "updateHotel with reindex: " << setprecision(2) << (benchNow() - start) * 1e9 / updates << " ns/op\n";
+}
+
+// Nearest-hotel queries over 1M hotels spread across Ethiopia, most of them
+// clustered around towns: the grid index against a linear haversine scan, plus
+// the cost of keeping the index current as hotels move.
+static void benchGeoIndex() {
+    const int n = benchSize(1000000);
+    const int towns = 25;
+    const int queries = benchSize(20000);
+    const int scanQueries = 20;
+
+    mt19937 rng(16);
+    uniform_real_distribution<double> latitudes(3.5, 14.8), longitudes(33.0, 47.9), unit(0, 1);
+    normal_distribution<double> spread(0, 0.15);
+    vector<pair<double, double> > townCentres;
+    for (int t = 0; t < towns; t++) townCentres.push_back(make_pair(latitudes(rng), longitudes(rng)));
+
+    HotelLinkedList store;
+    store.reserve(n);
+    double start = benchNow();
+    for (int i = 1; i <= n; i++) {
+        Hotel hotel = makeBenchHotel(i);
+        if (unit(rng) < 0.8) {
+            const pair<double, double>& town = townCentres[i % towns];
+            hotel.latitude = town.first + spread(rng);
+            hotel.longitude = town.second + spread(rng);
+        } else {
+            hotel.latitude = latitudes(rng);
+            hotel.longitude = longitudes(rng);
+        }
+        store.addHotel(std::move(hotel));
+    }
+    cout << "Geo index: " << n << " hotels, built in " << fixed << setprecision(2) << benchNow() - start << " s\n";
+
+    // Query points near towns, as itinerary stops would be
+    vector<pair<double, double> > points;
+    for (int q = 0; q < queries; q++) {
+        const pair<double, double>& town = townCentres[q % towns];
+        points.push_back(make_pair(town.first + spread(rng) * 2, town.second + spread(rng) * 2));
+    }
+
+    const size_t ks[] = {1, 10, 100};
+    cout << setw(16) << "query" << setw(16) << "scan q/s" << setw(16) << "index q/s" << setw(11) << "speedup\n";
+    for (int t = 0; t < 4; t++) {
+        bool radius = t == 3;
+        size_t k = radius ? 1000 : ks[t];
+        const double radiusKm = 5;
+        vector<GeoIndex::Match> matches;
+        size_t found = 0;
+        start = benchNow();
+        for (int q = 0; q < queries; q++) {
+            if (radius) store.hotelsWithin(points[q].first, points[q].second, radiusKm, k, matches);
+            else store.nearestHotels(points[q].first, points[q].second, k, matches);
+            found += matches.size();
+        }
+        double indexRate = queries / (benchNow() - start);
+
+        // Linear scan keeping the best k by (distance, id), checked against the index
+        vector<pair<double, int> > best;
+        double scanSeconds = 0;
+        for (int q = 0; q < scanQueries; q++) {
+            best.clear();
+            start = benchNow();
+            for (HotelNode* node = store.head; node; node = node->next) {
+                double km = GeoIndex::distanceKm(points[q].first, points[q].second, node->details()->latitude,
+                                                 node->details()->longitude);
+                if (radius && km > radiusKm) continue;
+                pair<double, int> candidate(km, node->id);
+                if (best.size() < k) {
+                    best.push_back(candidate);
+                    push_heap(best.begin(), best.end());
+                } else if (candidate < best.front()) {
+                    pop_heap(best.begin(), best.end());
+                    best.back() = candidate;
+                    push_heap(best.begin(), best.end());
+                }
+            }
+            sort_heap(best.begin(), best.end());
+            scanSeconds += benchNow() - start;
+
+            if (radius) store.hotelsWithin(points[q].first, points[q].second, radiusKm, k, matches);
+            else store.nearestHotels(points[q].first, points[q].second, k, matches);
+            bool same = matches.size() == best.size();
+            for (size_t i = 0; same && i < best.size(); i++) same = matches[i].node->id == best[i].second;
+            if (!same) {
+                cout << "MISMATCH: scan and index disagree for query " << q << "\n";
+                benchFailed = true;
+            }
+        }
+        double scanRate = scanQueries / scanSeconds;
+        string label = radius ? "within 5 km" : "k = " + to_string(k);
+        cout << setw(16) << label << setw(16) << setprecision(1) << scanRate << setw(16) << setprecision(0)
+             << indexRate << setw(10) << indexRate / scanRate << "x";
+        if (radius) cout << "   (" << setprecision(1) << double(found) / queries << " hotels per query)";
+        cout << "\n";
+    }
+
+    // Incremental maintenance: move hotels and delete/re-add them
+    const int moves = benchSize(100000);
+    start = benchNow();
+    for (int i = 1; i <= moves; i++) {
+        Hotel hotel = store.toHotel(store.findHotel(i));
+        hotel.latitude = latitudes(rng);
+        hotel.longitude = longitudes(rng);
+        store.updateHotel(hotel);
+    }
+    double moveNs = (benchNow() - start) * 1e9 / moves;
+    start = benchNow();
+    for (int i = 1; i <= moves; i++) {
+        Hotel hotel = store.toHotel(store.findHotel(i));
+        store.removeHotel(i);
+        store.addHotel(std::move(hotel));
+    }
+    double churnNs = (benchNow() - start) * 1e9 / moves;
+    cout << "move via updateHotel: " << setprecision(0) << moveNs << " ns/op, remove + add: " << churnNs << " ns/op\n";
+}
+
+// Bytes on the heap behind a string; 0 while it fits the small-string buffer
+static size_t stringHeapBytes(const string& text) {
+    const char* data = text.data();
+    if (data >= (const char*)&text && data < (const char*)(&text + 1)) return 0;
+#ifdef __GLIBC__
+    return malloc_usable_size((void*)data);
+#else
+    return text.capacity() + 1;
+#endif
+}
+
+// Bytes currently allocated from the heap, or 0 where the C library cannot say
+static size_t liveHeapBytes() {
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// The record layout before locations were interned and services encoded
+struct LegacyHotelDetails {
+    string name;
+    string services;
+    string location;
+    double latitude;
+    double longitude;
+
+    LegacyHotelDetails(const Hotel& hotel)
+        : name(hotel.name), services(hotel.services), location(hotel.location), latitude(hotel.latitude),
+          longitude(hotel.longitude) {}
+};
+
+// Bytes per hotel at 1M records: full string copies per record against the
+// interned location and amenity-bit encoding, with a decode check
+static void benchHotelMemory() {
+    const int n = benchSize(1000000);
+    const char* towns[] = {"Lalibela", "Gondar", "Bahir Dar", "Axum", "Addis Ababa", "Hawassa", "Harar", "Mekelle",
+                           "Dire Dawa", "Jimma", "Arba Minch", "Debre Markos", "Dessie", "Adama", "Bishoftu",
+                           "Debre Birhan", "Gambela", "Jinka", "Semera", "Asosa"};
+    const int townCount = 20;
+    const char* amenityNames[] = {"Free Wi-Fi", "Restaurant", "Pool", "Spa", "Bar", "Room Service", "Gym",
+                                  "Free Parking", "Garden", "Free Breakfast", "Conference Room", "Airport Shuttle",
+                                  "Laundry", "Rooftop Terrace", "Tour Desk", "Sauna"};
+    const int amenityCount = 16;
+
+    vector<Hotel> hotels(n);
+    unsigned int rng = 17;
+    for (int i = 0; i < n; i++) {
+        Hotel& hotel = hotels[i];
+        hotel.id = i + 1;
+        hotel.location = towns[benchRandom(rng) % townCount];
+        hotel.name = "Hotel " + hotel.location + " " + to_string(i + 1);
+        for (int a = 0; a < amenityCount; a++) {
+            if (int(benchRandom(rng) % 100) < 45 - a * 2) {
+                if (!hotel.services.empty()) hotel.services += ", ";
+                hotel.services += amenityNames[a];
+            }
+        }
+        hotel.roomNumber = 1 + int(benchRandom(rng) % 200);
+    }
+
+    size_t beforeFixed = 0, beforeHeap = 0;
+    {
+        SlabPool<LegacyHotelDetails> pool;
+        vector<LegacyHotelDetails*> records(n);
+        for (int i = 0; i < n; i++) {
+            records[i] = pool.create(hotels[i]);
+            beforeFixed += sizeof(LegacyHotelDetails);
+            beforeHeap += stringHeapBytes(records[i]->name) + stringHeapBytes(records[i]->services) +
+                          stringHeapBytes(records[i]->location);
+        }
+        for (int i = 0; i < n; i++) pool.destroy(records[i]);
+    }
+
+    size_t heapAtStart = liveHeapBytes();
+    HotelLinkedList store;
+    store.reserve(n);
+    double start = benchNow();
+    for (int i = 0; i < n; i++) store.addHotel(Hotel(hotels[i]));
+    double insertSeconds = benchNow() - start;
+    size_t storeBytes = liveHeapBytes() - heapAtStart;
+
+    size_t afterFixed = 0, afterHeap = 0, verbatim = 0;
+    for (HotelNode* node = store.head; node; node = node->next) {
+        afterFixed += sizeof(HotelDetails);
+        afterHeap += stringHeapBytes(node->details()->name);
+        if (node->details()->servicesText != HotelDetails::NO_TEXT) verbatim++;
+    }
+    for (int i = 0; i < n; i += 97) {
+        Hotel decoded = store.toHotel(store.findHotel(hotels[i].id));
+        if (decoded.name != hotels[i].name || decoded.services != hotels[i].services ||
+            decoded.location != hotels[i].location || decoded.roomNumber != hotels[i].roomNumber) {
+            cout << "MISMATCH: hotel " << hotels[i].id << " does not decode to its original fields\n";
+            benchFailed = true;
+            break;
+        }
+    }
+
+    cout << "Hotel memory: " << n << " hotels, " << store.locationCount() << " locations, "
+         << store.amenities().amenityCount() << " amenities, inserted in " << fixed << setprecision(2)
+         << insertSeconds << " s\n";
+    cout << left << setw(34) << "record bytes per hotel" << right << setw(10) << "before" << setw(10) << "after\n";
+    cout << left << setw(34) << "  fixed fields" << right << setw(10) << setprecision(1) << double(beforeFixed) / n
+         << setw(10) << double(afterFixed) / n << "\n";
+    cout << left << setw(34) << "  string heap" << right << setw(10) << double(beforeHeap) / n << setw(10)
+         << double(afterHeap) / n << "\n";
+    cout << left << setw(34) << "  total" << right << setw(10) << double(beforeFixed + beforeHeap) / n << setw(10)
+         << double(afterFixed + afterHeap) / n << "\n";
+    cout << "services kept verbatim: " << verbatim << " hotels sharing " << store.servicesTextCount()
+         << " interned texts; the rest decode from their amenity bits\n";
+    if (storeBytes) {
+        cout << "whole store incl. id, amenity, name, room and geo indexes: " << setprecision(1) << double(storeBytes) / n
+             << " bytes per hotel live heap\n";
+    }
+}
+
+// Multi-term amenity queries over 1M hotels: bitmap index against scanning
+// and tokenizing every services string.
+static void benchAmenityIndex() {
+    const int n = 1000000;
+    const int repeats = 20;
+    const char* amenityNames[] = {"Free Wi-Fi", "Restaurant", "Pool", "Spa", "Bar", "Room Service", "Gym",
+                                  "Free Parking", "Garden", "Free Breakfast", "Conference Room", "Airport Shuttle",
+                                  "Laundry", "Rooftop Terrace", "Tour Desk", "Sauna"};
+    const int amenityCount = 16;
+
+    HotelLinkedList store;
+    store.reserve(n);
+    unsigned int rng = 2024;
+    double start = benchNow();
+    for (int i = 1; i <= n; i++) {
+        Hotel hotel = makeBenchHotel(i);
+        hotel.services.clear();
+        for (int a = 0; a < amenityCount; a++) {
+            // Earlier amenities are common, later ones rare
+            if (int(benchRandom(rng) % 100) < 60 - a * 3) {
+                if (!hotel.services.empty()) hotel.services += ", ";
+                hotel.services += amenityNames[a];
+            }
+        }
+        store.addHotel(std::move(hotel));
+    }
+    double buildSeconds = benchNow() - start;
+
+    struct Query {
+        const char* text;
+        const char* include[4];
+        const char* exclude[2];
+    };
+    const Query queries[] = {
+        {"Pool AND Spa AND NOT Bar", {"Pool", "Spa"}, {"Bar"}},
+        {"Free Wi-Fi AND Restaurant AND Gym AND NOT Free Parking", {"Free Wi-Fi", "Restaurant", "Gym"}, {"Free Parking"}},
+        {"Sauna AND Tour Desk AND Laundry", {"Sauna", "Tour Desk", "Laundry"}, {NULL}},
+        {"Pool AND Spa AND Gym AND Sauna", {"Pool", "Spa", "Gym", "Sauna"}, {NULL}},
+    };
+
+    cout << "Amenity index: " << n << " hotels, built in " << fixed << setprecision(2) << buildSeconds << " s\n";
+    cout << left << setw(58) << "query" << right << setw(9) << "matches" << setw(13) << "scan ms"
+         << setw(13) << "index ms" << setw(11) << "speedup\n";
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        const Query& query = queries[q];
+        vector<HotelNode*> matches;
+        string error;
+        start = benchNow();
+        for (int r = 0; r < repeats; r++) store.searchByServices(query.text, matches, error);
+        double indexMs = (benchNow() - start) * 1e3 / repeats;
+
+        vector<string> include, exclude, keys;
+        for (int k = 0; k < 4 && query.include[k]; k++) include.push_back(AmenityIndex::normalize(query.include[k]));
+        for (int k = 0; k < 2 && query.exclude[k]; k++) exclude.push_back(AmenityIndex::normalize(query.exclude[k]));
+        size_t scanMatches = 0;
+        start = benchNow();
+        for (HotelNode* node = store.head; node; node = node->next) {
+            AmenityIndex::tokenize(store.servicesOf(node), keys);
+            bool match = true;
+            for (size_t k = 0; k < include.size() && match; k++) match = find(keys.begin(), keys.end(), include[k]) != keys.end();
+            for (size_t k = 0; k < exclude.size() && match; k++) match = find(keys.begin(), keys.end(), exclude[k]) == keys.end();
+            if (match) scanMatches++;
+        }
+        double scanMs = (benchNow() - start) * 1e3;
+        if (scanMatches != matches.size()) cout << "MISMATCH: scan found " << scanMatches << "\n";
+
+        cout << left << setw(58) << query.text << right << setw(9) << matches.size() << setw(13) << setprecision(2)
+             << scanMs << setw(13) << setprecision(3) << indexMs << setw(10) << setprecision(0) << scanMs / indexMs << "x\n";
+    }
+
+    size_t postingBytes = 0;
+    for (size_t a = 0; a < store.amenities().amenityCount(); a++) postingBytes += store.amenities().posting(int(a)).memoryBytes();
+    cout << "posting lists: " << setprecision(1) << postingBytes / 1048576.0 << " MiB for "
+         << store.amenities().amenityCount() << " amenities\n";
+
+    // Incremental maintenance cost through updateHotel()
+    const int updates = 100000;
+    start = benchNow();
+    for (int i = 1; i <= updates; i++) {
+        Hotel hotel = store.toHotel(store.findHotel(i));
+        hotel.services = amenityNames[i % amenityCount];
+        hotel.services += ", ";
+        hotel.services += amenityNames[(i * 7) % amenityCount];
+        store.updateHotel(hotel);
+    }
+    cout << "updateHotel with index maintenance: " << setprecision(0) << updates / (benchNow() - start) << " updates/s\n";
+}
+
+// Cold start: full SQLite load against mapping a snapshot, with and without
+// changes to replay
+// Made-up but varied hotel names, "<word> <word> <kind>", each word two or
+// three consonant-vowel syllables, some closed by a consonant
+static string makeBenchHotelName(unsigned int& rng) {
+    const char* consonants = "bdfghjklmnprstvwyzcq";
+    const char* vowels = "aeiou";
+    const char* codas = "nrlsmt";
+    const char* kinds[] = {"Hotel", "Lodge", "Inn", "Resort", "Guesthouse", "Suites", "Palace", "Camp", "Retreat",
+                           "Hostel"};
+    string name;
+    for (int w = 0; w < 2; w++) {
+        string word;
+        int length = 2 + benchRandom(rng) % 2;
+        for (int k = 0; k < length; k++) {
+            word += consonants[benchRandom(rng) % 20];
+            word += vowels[benchRandom(rng) % 5];
+            if (benchRandom(rng) % 4 == 0) word += codas[benchRandom(rng) % 6];
+        }
+        word[0] = char(toupper((unsigned char)word[0]));
+        name += word + ' ';
+    }
+    return name + kinds[benchRandom(rng) % 10];
+}
+
+// One typing slip: a letter swapped for another, dropped, or transposed
+static string benchTypo(const string& name, unsigned int& rng) {
+    string typo = name;
+    size_t at = benchRandom(rng) % (typo.size() - 1);
+    while (!isalpha((unsigned char)typo[at]) || !isalpha((unsigned char)typo[at + 1])) at = (at + 1) % (typo.size() - 1);
+    switch (benchRandom(rng) % 3) {
+        case 0: typo[at] = char('a' + benchRandom(rng) % 26); break;
+        case 1: typo.erase(at, 1); break;
+        default: swap(typo[at], typo[at + 1]); break;
+    }
+    return typo;
+}
+
+// Top-10 fuzzy name lookups over 1M hotels: trigram index against scoring
+// every name. Recall is how often the name a misspelt query came from is in
+// the top 10; the scan shows how often the index's bounded candidate set
+// still gives the exact best match and the exact top 10. Every score the
+// index returns must equal the name's true similarity.
+static void benchNameSearch() {
+    const int n = benchSize(1000000);
+    const int queries = benchSize(2000);
+    const int scanQueries = 20;
+    const size_t k = 10;
+
+    HotelLinkedList store;
+    store.reserve(n);
+    unsigned int rng = 7;
+    vector<string> names;
+    names.reserve(n);
+    for (int i = 1; i <= n; i++) {
+        Hotel hotel = makeBenchHotel(i);
+        hotel.name = makeBenchHotelName(rng);
+        names.push_back(hotel.name);
+    }
+    double start = benchNow();
+    for (int i = 1; i <= n; i++) {
+        Hotel hotel = makeBenchHotel(i);
+        hotel.name = names[i - 1];
+        store.addHotel(std::move(hotel));
+    }
+    double buildSeconds = benchNow() - start;
+
+    vector<double> latencies;
+    vector<TrigramIndex::Match> matches;
+    int found = 0;
+    for (int q = 0; q < queries; q++) {
+        int id = 1 + benchRandom(rng) % n;
+        string query = benchTypo(names[id - 1], rng);
+        start = benchNow();
+        store.searchByName(query, k, matches);
+        latencies.push_back((benchNow() - start) * 1e3);
+        for (size_t i = 0; i < matches.size(); i++) {
+            if (matches[i].id == id || names[matches[i].id - 1] == names[id - 1]) {
+                found++;
+                break;
+            }
+        }
+    }
+    sort(latencies.begin(), latencies.end());
+    double total = 0;
+    for (size_t i = 0; i < latencies.size(); i++) total += latencies[i];
+
+    double scanMs = 0;
+    int sameBest = 0, sameTop = 0;
+    vector<uint32_t> queryGrams, nameGrams;
+    for (int q = 0; q < scanQueries; q++) {
+        string query = benchTypo(names[benchRandom(rng) % n], rng);
+        store.searchByName(query, k, matches);
+        start = benchNow();
+        TrigramIndex::trigramsOf(query, queryGrams);
+        vector<TrigramIndex::Match> scanned;
+        for (HotelNode* node = store.head; node; node = node->next) {
+            TrigramIndex::trigramsOf(node->details()->name, nameGrams);
+            size_t common = 0;
+            for (size_t a = 0, b = 0; a < queryGrams.size() && b < nameGrams.size();) {
+                if (queryGrams[a] < nameGrams[b]) a++;
+                else if (nameGrams[b] < queryGrams[a]) b++;
+                else common++, a++, b++;
+            }
+            TrigramIndex::Match match = {node->id, double(common) / (queryGrams.size() + nameGrams.size() - common)};
+            if (match.score >= TrigramIndex::MIN_SIMILARITY) scanned.push_back(match);
+        }
+        size_t top = min(k, scanned.size());
+        partial_sort(scanned.begin(), scanned.begin() + top, scanned.end(),
+                     [](const TrigramIndex::Match& a, const TrigramIndex::Match& b) {
+                         return a.score != b.score ? a.score > b.score : a.id < b.id;
+                     });
+        scanMs += (benchNow() - start) * 1e3;
+        bool same = matches.size() == top;
+        for (size_t i = 0; same && i < top; i++) same = matches[i].id == scanned[i].id;
+        sameTop += same;
+        sameBest += !matches.empty() && top > 0 && matches[0].score == scanned[0].score;
+        for (size_t i = 0; i < matches.size(); i++) {
+            bool scored = false;
+            for (size_t j = 0; j < scanned.size() && !scored; j++) {
+                scored = scanned[j].id == matches[i].id && scanned[j].score == matches[i].score;
+            }
+            if (!scored) {
+                cout << "MISMATCH: wrong score for hotel " << matches[i].id << " on \"" << query << "\"\n";
+                benchFailed = true;
+            }
+        }
+    }
+
+    const int updates = benchSize(100000);
+    start = benchNow();
+    for (int i = 1; i <= updates; i++) {
+        Hotel hotel = store.toHotel(store.findHotel(i));
+        hotel.name = makeBenchHotelName(rng);
+        store.updateHotel(hotel);
+    }
+    double updateSeconds = benchNow() - start;
+
+    cout << "Name search: " << n << " hotels, built in " << fixed << setprecision(2) << buildSeconds << " s\n"
+         << "top-" << k << " over " << queries << " misspelt names: mean " << setprecision(3)
+         << total / latencies.size() << " ms, p50 " << latencies[latencies.size() / 2] << " ms, p99 "
+         << latencies[latencies.size() * 99 / 100] << " ms, max " << latencies.back() << " ms\n"
+         << "recall@" << k << ": " << setprecision(1) << 100.0 * found / queries << "%\n"
+         << "scan of every name: " << setprecision(1) << scanMs / scanQueries << " ms per query; index gave its best match "
+         << sameBest << "/" << scanQueries << " times and its whole top " << k << " " << sameTop << "/" << scanQueries
+         << " times\n"
+         << "updateHotel with a new name: " << setprecision(0) << updates / updateSeconds << " updates/s\n";
+}
+
+static void benchSnapshotBoot() {
+    const int hotels = 1000000;
+    const int guests = 100000;
+    const int changes = 1000;
+    const char* dbPath = "bench_boot.db";
+    const char* snapshotPath = "bench_boot.snapshot";
+    remove(dbPath);
+    initializeDatabase(dbPath);
+    execSql("BEGIN;");
+    for (int i = 1; i <= hotels; i++) saveHotelToDatabase(makeBenchHotel(i));
+    for (int i = 1; i <= guests; i++) saveGuestToDatabase(makeBenchGuest(i));
+    execSql("COMMIT;");
+
+    double start = benchNow();
+    loadHotelsFromDatabase();
+    loadGuestsFromDatabase();
+    double sqliteSeconds = benchNow() - start;
+
+    start = benchNow();
+    writeSnapshot(snapshotPath);
+    double writeSeconds = benchNow() - start;
+
+    hotelList.clearList();
+    guestQueue.clearList();
+    start = benchNow();
+    bool loaded = loadSnapshot(snapshotPath);
+    double snapshotSeconds = benchNow() - start;
+
+    execSql("BEGIN;");
+    for (int i = 1; i <= changes; i++) {
+        Hotel hotel = makeBenchHotel(i * 97);
+        hotel.name += " (renovated)";
+        updateHotelInDatabase(hotel);
+    }
+    execSql("COMMIT;");
+    hotelList.clearList();
+    guestQueue.clearList();
+    start = benchNow();
+    loaded = loadSnapshot(snapshotPath) && loaded;
+    double replaySeconds = benchNow() - start;
+
+    cout << "Cold start with " << hotels << " hotels and " << guests << " guests"
+         << (loaded ? "" : " (SNAPSHOT LOAD FAILED)") << "\n" << fixed << setprecision(3)
+         << "full SQLite load:                 " << sqliteSeconds << " s\n"
+         << "snapshot write:                   " << writeSeconds << " s\n"
+         << "snapshot load:                    " << snapshotSeconds << " s\n"
+         << "snapshot load + " << changes << " replayed:     " << replaySeconds << " s\n";
+    hotelList.clearList();
+    guestQueue.clearList();
+    closeDatabase();
+    remove(dbPath);
+    remove(snapshotPath);
+}
+
+// Whole-list reads against a steady stream of edits, with readers walking a
+// snapshot lock-free and, as the baseline, holding a shared_mutex for the walk
+// while each edit takes it exclusively. The writer runs until the readers have
+// done their walks. Every edit renames a hotel after its new room count, so a
+// reader can spot a half-applied one, and one edit in 16 replaces a hotel
+// outright, so a walk sees n or n - 1 hotels.
+static void benchMvccRead() {
+    const int n = benchSize(100000);
+    const int walksPerReader = 200;
+    unsigned int cores = thread::hardware_concurrency();
+    if (cores == 0) cores = 1;
+
+    cout << "Full-list reads under a concurrent update stream, " << n << " hotels, " << cores
+         << " hardware thread(s)\n";
+    cout << setw(10) << "mode" << setw(9) << "readers" << setw(14) << "walks/s" << setw(12) << "Mrows/s"
+         << setw(12) << "updates/s" << setw(17) << "worst update us\n";
+    for (int readers = 1; readers <= 2; readers++) {
+        for (int mode = 0; mode < 2; mode++) {
+            bool locked = mode == 1;
+            HotelLinkedList store;
+            for (int i = 1; i <= n; i++) {
+                Hotel hotel = makeBenchHotel(i);
+                hotel.name = "Hotel " + to_string(hotel.roomNumber);
+                store.addHotel(std::move(hotel));
+            }
+            shared_mutex lock;
+            atomic<int> running(readers);
+            atomic<long> rows(0), torn(0), miscounted(0);
+
+            vector<thread> threads;
+            for (int r = 0; r < readers; r++) {
+                threads.push_back(thread([&]() {
+                    long myRows = 0;
+                    for (int w = 0; w < walksPerReader; w++) {
+                        shared_lock<shared_mutex> guard(lock, defer_lock);
+                        if (locked) guard.lock();
+                        HotelLinkedList::ReadSnapshot snapshot(store);
+                        long seen = 0;
+                        for (const HotelNode* node = snapshot.first(); node; node = snapshot.next(node)) {
+                            const HotelDetails* details = snapshot.recordOf(node);
+                            if (atoi(details->name.c_str() + 6) != details->roomNumber) torn++;
+                            seen++;
+                        }
+                        if (seen != n && seen != n - 1) miscounted++;
+                        myRows += seen;
+                        this_thread::yield(); // Lets the writer in on a single core
+                    }
+                    rows += myRows;
+                    running--;
+                }));
+            }
+
+            unsigned int rng = 29;
+            int nextId = n + 1;
+            long updates = 0;
+            double worst = 0;
+            double start = benchNow();
+            double now = start;
+            while (running.load() > 0) {
+                int id = 1 + benchRandom(rng) % (nextId - 1);
+                int rooms = 10 + benchRandom(rng) % 500;
+                {
+                    unique_lock<shared_mutex> guard(lock, defer_lock);
+                    if (locked) guard.lock();
+                    if (updates % 16 == 15) {
+                        if (store.removeHotel(id)) {
+                            Hotel hotel = makeBenchHotel(nextId++);
+                            hotel.name = "Hotel " + to_string(hotel.roomNumber);
+                            store.addHotel(std::move(hotel));
+                        }
+                    } else {
+                        Hotel hotel = makeBenchHotel(id);
+                        hotel.name = "Hotel " + to_string(rooms);
+                        hotel.roomNumber = rooms;
+                        store.updateHotel(hotel);
+                    }
+                }
+                updates++;
+                double finished = benchNow();
+                worst = max(worst, finished - now);
+                now = finished;
+            }
+            double elapsed = now - start;
+            for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+
+            // With the readers gone, the next edits reclaim everything retired
+            store.addHotel(makeBenchHotel(nextId));
+            store.removeHotel(nextId);
+            if (torn || miscounted || store.size() != n || store.retiredCount() != 0) {
+                cout << "MVCC read check FAILED: " << torn << " torn, " << miscounted << " miscounted, "
+                     << store.retiredCount() << " still retired\n";
+                benchFailed = true;
+            }
+            cout << setw(10) << (locked ? "mutex" : "snapshot") << setw(9) << readers << fixed << setprecision(1)
+                 << setw(14) << readers * walksPerReader / elapsed << setprecision(2) << setw(12)
+                 << rows / elapsed / 1e6 << setprecision(0) << setw(12) << updates / elapsed << setw(16)
+                 << worst * 1e6 << "\n";
+        }
+    }
+}
+
+// Start-up load and fan-out queries over location-sharded files, with 1 to
+// shardCount threads reading the shards. The in-memory indexes are still
+// built on one thread, so the read phase is timed on its own as well.
+static void benchShardLoad() {
+    const int n = benchSize(500000);
+    const int shardCount = 8;
+    const int towns = 64;
+    const int pageQueries = benchSize(1000);
+    const char* dbPath = "bench_shards.db";
+    remove(dbPath);
+    for (int i = 0; i < shardCount; i++) remove(("bench_shards.shard" + to_string(i) + ".db").c_str());
+
+    int savedShards = durability.shards;
+    durability.shards = shardCount;
+    initializeDatabase(dbPath);
+    vector<Hotel> hotels;
+    hotels.reserve(n);
+    for (int i = 1; i <= n; i++) {
+        hotels.push_back(makeBenchHotel(i));
+        hotels.back().location = "Town " + to_string(i % towns);
+    }
+    vector<char> written;
+    long failed = 0;
+    double start = benchNow();
+    writeHotelsToShards(hotels, STMT_INSERT_HOTEL, written, failed);
+    double writeSeconds = benchNow() - start;
+    hotels.clear();
+
+    cout << "Sharded load: " << n << " hotels in " << towns << " towns across " << shardCount << " shards ("
+         << thread::hardware_concurrency() << " hardware threads), written in " << fixed << setprecision(2)
+         << writeSeconds << " s\n";
+    cout << setw(8) << "threads" << setw(14) << "read s" << setw(14) << "rows/s" << setw(14) << "full load s"
+         << setw(14) << "page us" << setw(14) << "speedup" << "\n";
+    double baseline = 0;
+    for (int threads = 1; threads <= shardCount; threads *= 2) {
+        shards.setThreads(threads);
+        vector<vector<Hotel> > loaded;
+        vector<long long> changeSeqs;
+        start = benchNow();
+        if (!readShardHotels(loaded, changeSeqs)) benchFailed = true;
+        double readSeconds = benchNow() - start;
+        size_t rows = 0;
+        for (size_t i = 0; i < loaded.size(); i++) rows += loaded[i].size();
+        loaded.clear();
+
+        start = benchNow();
+        loadHotelsFromDatabase();
+        double loadSeconds = benchNow() - start;
+        if (rows != size_t(n) || hotelList.size() != n) {
+            cout << "MISMATCH: read " << rows << ", loaded " << hotelList.size() << " hotels\n";
+            benchFailed = true;
+        }
+
+        unsigned int rng = 5;
+        start = benchNow();
+        for (int i = 0; i < pageQueries; i++) {
+            ostringstream page;
+            PageCursor cursor;
+            bool hasMore;
+            fetchPage(PAGE_HOTELS, 0, int(benchRandom(rng) % n), false, DEFAULT_PAGE_SIZE, page, cursor, hasMore);
+        }
+        double pageMicros = (benchNow() - start) * 1e6 / pageQueries;
+
+        if (threads == 1) baseline = readSeconds;
+        cout << setw(8) << threads << setw(14) << setprecision(3) << readSeconds << setw(14) << setprecision(0)
+             << n / readSeconds << setw(14) << setprecision(3) << loadSeconds << setw(14) << setprecision(1)
+             << pageMicros << setw(13) << setprecision(2) << baseline / readSeconds << "x\n";
+    }
+    hotelList.clearList();
+    closeDatabase();
+    durability.shards = savedShards;
+    remove(dbPath);
+    for (int i = 0; i < shardCount; i++) remove(("bench_shards.shard" + to_string(i) + ".db").c_str());
+}
+
+// Bounded lock-free multi-producer/multi-consumer ring (Vyukov's design).
+// Each cell carries a sequence number that tells producers and consumers
+// whether it is free or filled for their lap, so claiming a position is one
+// CAS and no thread ever waits on a lock. The claimed enqueue position is
+// unique and increasing, which makes it usable as a ticket.
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity) : cells(roundUp(capacity)), mask(cells.size() - 1) {
+        for (size_t i = 0; i < cells.size(); i++) cells[i].sequence.store(i, memory_order_relaxed);
+        enqueuePos.store(0, memory_order_relaxed);
+        dequeuePos.store(0, memory_order_relaxed);
+    }
+
+    // Claim the next position, let stamp(value, position) fill it in, then
+    // publish. Returns false when the ring is full.
+    template <typename Stamp>
+    bool tryEnqueue(T& value, Stamp stamp) {
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(memory_order_acquire);
+            intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+        stamp(value, pos);
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, memory_order_release);
+        return true;
+    }
+
+    // Returns false when the ring is empty
+    bool tryDequeue(T& value) {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(memory_order_acquire);
+            intptr_t diff = intptr_t(sequence) - intptr_t(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->value);
+        cell->sequence.store(pos + mask + 1, memory_order_release);
+        return true;
+    }
+
+    // Approximate while other threads are running
+    size_t sizeApprox() const {
+        size_t enqueued = enqueuePos.load(memory_order_relaxed);
+        size_t dequeued = dequeuePos.load(memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    size_t capacity() const { return cells.size(); }
+
+private:
+    struct Cell {
+        atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t roundUp(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+
+    vector<Cell> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueuePos; // Producers and consumers on separate cache lines
+    alignas(64) atomic<size_t> dequeuePos;
+
+    MpmcRing(const MpmcRing&);
+    MpmcRing& operator=(const MpmcRing&);
+};
+
+// Lock-free guest queue: producers enqueue and consumers serve from any
+// thread. A guest's ticket is the ring position claimed at enqueue, offset
+// by firstTicket, so tickets are assigned atomically and come out of serve()
+// in ticket order. Only the stress test and bench below use it; the app's
+// queue is GuestLinkedList, which the server guards with storeLock.
+class ConcurrentGuestQueue {
+public:
+    explicit ConcurrentGuestQueue(size_t capacity, int firstTicket = 1) : ring(capacity), firstTicket(firstTicket) {}
+
+    // Enqueue and return the guest's ticket, spinning politely while full
+    int enqueue(Guest guest) {
+        int ticket = 0;
+        int base = firstTicket;
+        while (!ring.tryEnqueue(guest, [&ticket, base](Guest& g, size_t position) {
+            ticket = base + int(position);
+            g.queuePosition = ticket;
+        })) {
+            this_thread::yield();
+        }
+        return ticket;
+    }
+
+    // Serve the guest with the lowest outstanding ticket; false if empty
+    bool serve(Guest& guest) {
+        return ring.tryDequeue(guest);
+    }
+
+    size_t sizeApprox() const { return ring.sizeApprox(); }
+
+private:
+    MpmcRing<Guest> ring;
+    int firstTicket;
+};
+
+// Mutex-guarded queue with the same interface, as a throughput baseline
+class LockedGuestQueue {
+public:
+    LockedGuestQueue() : nextTicket(1) {}
+
+    int enqueue(Guest guest) {
+        lock_guard<mutex> lock(guard);
+        guest.queuePosition = nextTicket++;
+        guests.push_back(std::move(guest));
+        return guests.back().queuePosition;
+    }
+
+    bool serve(Guest& guest) {
+        lock_guard<mutex> lock(guard);
+        if (guests.empty()) return false;
+        guest = std::move(guests.front());
+        guests.pop_front();
+        return true;
+    }
+
+private:
+    mutex guard;
+    deque<Guest> guests;
+    int nextTicket;
+};
+
+// Run producers and consumers against a queue until every guest is served.
+// Returns elapsed seconds.
+template <typename Queue>
+static double runGuestQueueWorkload(Queue& queue, int producers, int consumers, int perProducer) {
+    atomic<long> served(0);
+    long total = long(producers) * perProducer;
+    vector<thread> threads;
+    double start = benchNow();
+    for (int p = 0; p < producers; p++) {
+        threads.push_back(thread([&queue, p, perProducer]() {
+            Guest guest;
+            guest.name = "Guest";
+            for (int i = 0; i < perProducer; i++) {
+                guest.id = p * perProducer + i + 1;
+                queue.enqueue(guest);
+            }
+        }));
+    }
+    for (int c = 0; c < consumers; c++) {
+        threads.push_back(thread([&queue, &served, total]() {
+            Guest guest;
+            while (served.load(memory_order_relaxed) < total) {
+                if (queue.serve(guest)) served.fetch_add(1, memory_order_relaxed);
+                else this_thread::yield();
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    return benchNow() - start;
+}
+
+// Many producers and consumers hammer a small ring; afterwards every guest
+// must have been served exactly once, tickets must be unique and gap-free,
+// and each desk must see tickets, and each terminal's guests, in order.
+static bool stressConcurrentGuestQueue(int producers, int consumers, int perProducer, size_t capacity) {
+    ConcurrentGuestQueue queue(capacity);
+    long total = long(producers) * perProducer;
+    atomic<long> served(0);
+    atomic<bool> ordered(true);
+    vector<vector<int> > issued(producers);
+    vector<vector<pair<int, int> > > seen(consumers); // (guest id, ticket) per desk
+    vector<thread> threads;
+
+    for (int p = 0; p < producers; p++) {
+        threads.push_back(thread([&, p]() {
+            Guest guest;
+            guest.name = "Stress";
+            issued[p].reserve(perProducer);
+            for (int i = 0; i < perProducer; i++) {
+                guest.id = p * perProducer + i + 1;
+                issued[p].push_back(queue.enqueue(guest));
+            }
+        }));
+    }
+    for (int c = 0; c < consumers; c++) {
+        threads.push_back(thread([&, c]() {
+            Guest guest;
+            vector<int> lastFromProducer(producers, -1);
+            int lastTicket = 0;
+            while (served.load(memory_order_relaxed) < total) {
+                if (!queue.serve(guest)) {
+                    this_thread::yield();
+                    continue;
+                }
+                served.fetch_add(1, memory_order_relaxed);
+                int producer = (guest.id - 1) / perProducer;
+                int index = (guest.id - 1) % perProducer;
+                if (guest.queuePosition <= lastTicket || index <= lastFromProducer[producer]) ordered = false;
+                lastTicket = guest.queuePosition;
+                lastFromProducer[producer] = index;
+                seen[c].push_back(make_pair(guest.id, guest.queuePosition));
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+
+    bool ok = ordered.load();
+    vector<char> guestSeen(total + 1, 0), ticketSeen(total + 1, 0);
+    for (int c = 0; c < consumers; c++) {
+        for (size_t i = 0; i < seen[c].size(); i++) {
+            int id = seen[c][i].first, ticket = seen[c][i].second;
+            if (id < 1 || id > total || guestSeen[id]++ || ticket < 1 || ticket > total || ticketSeen[ticket]++) ok = false;
+        }
+    }
+    for (long i = 1; i <= total; i++) {
+        if (!guestSeen[i] || !ticketSeen[i]) ok = false;
+    }
+    for (int p = 0; p < producers; p++) {
+        for (int i = 1; i < perProducer; i++) {
+            if (issued[p][i] <= issued[p][i - 1]) ok = false;
+        }
+    }
+    return ok;
+}
+
+static void benchGuestQueueConcurrency() {
+    const int perThread = benchSize(250000);
+    unsigned int cores = thread::hardware_concurrency();
+    if (cores == 0) cores = 1;
+
+    bool ok = stressConcurrentGuestQueue(4, 4, perThread, 1024) && stressConcurrentGuestQueue(8, 2, perThread / 4, 64) &&
+              stressConcurrentGuestQueue(1, 8, perThread, 16);
+    cout << "Concurrent guest queue stress test: " << (ok ? "passed" : "FAILED") << "\n";
+    if (!ok) benchFailed = true;
+
+    cout << "Guest queue throughput, " << cores << " hardware thread(s) (million guests/s)\n";
+    cout << setw(10) << "producers" << setw(10) << "desks" << setw(12) << "lock-free" << setw(12) << "mutex\n";
+    for (unsigned int threads = 1; threads <= max(4u, cores); threads *= 2) {
+        ConcurrentGuestQueue lockFree(4096);
+        LockedGuestQueue locked;
+        int perProducer = perThread * 4 / int(threads);
+        long total = long(perProducer) * threads;
+        double lockFreeSeconds = runGuestQueueWorkload(lockFree, int(threads), int(threads), perProducer);
+        double lockedSeconds = runGuestQueueWorkload(locked, int(threads), int(threads), perProducer);
+        cout << setw(10) << threads << setw(10) << threads << fixed << setprecision(2)
+             << setw(12) << total / lockFreeSeconds / 1e6 << setw(11) << total / lockedSeconds / 1e6 << "\n";
+    }
+}
+
+// Live queue position, mid-queue cancellation and serving through the rank
+// tree against walking the list from the head, as the queue used to.
+static void benchGuestRank() {
+    const int sizes[] = {benchSize(10000), benchSize(100000), benchSize(1000000)};
+    const int indexedOps = benchSize(100000);
+
+    cout << "Guest queue: linear walk vs ticket rank tree (ns/op)\n";
+    cout << setw(9) << "guests" << "  " << left << setw(10) << "op" << right
+         << setw(16) << "walk" << setw(16) << "rank tree" << setw(13) << "speedup\n";
+
+    for (int s = 0; s < 3; s++) {
+        int n = sizes[s];
+        int walkOps = n >= 1000000 ? 20 : 200;
+        double walk[3], indexed[3];
+        unsigned int rng;
+        double start;
+        volatile long sink = 0;
+
+        // Walk baseline: rank is the distance from the head, cancel unlinks
+        // from a singly-linked list
+        {
+            LegacyGuestList queue;
+            for (int i = 1; i <= n; i++) queue.addGuest(makeBenchGuest(i));
+
+            rng = 7;
+            start = benchNow();
+            for (int i = 0; i < walkOps; i++) {
+                int id = 1 + benchRandom(rng) % n;
+                int rank = 1;
+                for (LegacyGuestList::Node* node = queue.head; node && node->data.id != id; node = node->next) rank++;
+                sink = sink + rank;
+            }
+            walk[0] = (benchNow() - start) * 1e9 / walkOps;
+
+            rng = 11;
+            start = benchNow();
+            for (int i = 0; i < walkOps; i++) {
+                int id = 1 + benchRandom(rng) % n;
+                LegacyGuestList::Node* prev = NULL;
+                LegacyGuestList::Node* node = queue.head;
+                while (node && node->data.id != id) {
+                    prev = node;
+                    node = node->next;
+                }
+                if (!node) continue;
+                if (prev) prev->next = node->next;
+                else queue.head = node->next;
+                if (queue.tail == node) queue.tail = prev;
+                delete node;
+            }
+            walk[1] = (benchNow() - start) * 1e9 / walkOps;
+
+            // Serving the head was already O(1)
+            start = benchNow();
+            for (int i = 0; i < walkOps && queue.head; i++) {
+                LegacyGuestList::Node* node = queue.head;
+                queue.head = node->next;
+                if (!queue.head) queue.tail = NULL;
+                delete node;
+            }
+            walk[2] = (benchNow() - start) * 1e9 / walkOps;
+        }
+
+        // Rank tree, checked against a walk after the cancellations
+        {
+            GuestLinkedList queue;
+            for (int i = 1; i <= n; i++) queue.addGuest(makeBenchGuest(i));
+
+            rng = 7;
+            start = benchNow();
+            for (int i = 0; i < indexedOps; i++) sink = sink + queue.rankOf(1 + benchRandom(rng) % n);
+            indexed[0] = (benchNow() - start) * 1e9 / indexedOps;
+
+            rng = 11;
+            int cancels = min(indexedOps, n / 2);
+            start = benchNow();
+            for (int i = 0; i < cancels; i++) queue.removeGuest(1 + benchRandom(rng) % n);
+            indexed[1] = (benchNow() - start) * 1e9 / cancels;
+
+            int expected = 1;
+            for (GuestNode* node = queue.head; node; node = node->next) {
+                if (queue.rankOf(node->id) != expected++) {
+                    cout << "MISMATCH: guest " << node->id << " ranked " << queue.rankOf(node->id) << "\n";
+                    benchFailed = true;
+                    break;
+                }
+            }
+
+            int serves = min(indexedOps, queue.size());
+            start = benchNow();
+            for (int i = 0; i < serves; i++) sink = sink + queue.serveGuest().id;
+            indexed[2] = (benchNow() - start) * 1e9 / serves;
+            if (queue.head && queue.rankOf(queue.head->id) != 1) {
+                cout << "MISMATCH: head is not ranked first after serving\n";
+                benchFailed = true;
+            }
+        }
+
+        const char* ops[] = {"rank", "cancel", "serve"};
+        for (int op = 0; op < 3; op++) printBenchRow(n, ops[op], walk[op], indexed[op]);
+    }
+}
+
+// Cost of leaving the instrumentation on: raw histogram recording, and the
+// cheapest instrumented paths (in-memory reads and a cached insert) with
+// metrics switched on and off
+static void benchMetricsOverhead() {
+    const int n = 1000000;
+    const int ops = 2000000;
+    const int inserts = 100000;
+
+    LatencyHistogram histogram;
+    unsigned int rng = 5;
+    double start = benchNow();
+    for (int i = 0; i < ops; i++) histogram.record(benchRandom(rng) % 1000000);
+    double recordNs = (benchNow() - start) * 1e9 / ops;
+    cout << "Metrics overhead\nhistogram record: " << fixed << setprecision(1) << recordNs << " ns\n";
+
+    hotelList.clearList();
+    hotelList.reserve(n);
+    for (int i = 1; i <= n; i++) hotelList.addHotel(makeBenchHotel(i));
+    Command find;
+    find.type = CMD_FIND_HOTEL;
+    Command page;
+    page.type = CMD_LIST_HOTELS;
+    page.limit = 10;
+    const char* dbPath = "bench_metrics.db";
+    remove(dbPath);
+    initializeDatabase(dbPath);
+
+    cout << left << setw(16) << "path" << right << setw(14) << "off ns/op" << setw(14) << "on ns/op" << setw(12) << "overhead\n";
+    for (int path = 0; path < 3; path++) {
+        double nsPerOp[2];
+        for (int on = 0; on < 2; on++) {
+            metrics.setEnabled(on == 1);
+            string reply;
+            volatile long sink = 0;
+            rng = 17;
+            if (path < 2) {
+                Command& command = path == 0 ? find : page;
+                start = benchNow();
+                for (int i = 0; i < ops; i++) {
+                    command.hotel.id = 1 + benchRandom(rng) % (n - 20);
+                    sink = sink + executeCommand(command, reply);
+                }
+                nsPerOp[on] = (benchNow() - start) * 1e9 / ops;
+            } else {
+                // Cached INSERT into a fresh table inside one transaction: the
+                // cheapest SQLite call site
+                closeDatabase();
+                remove(dbPath);
+                initializeDatabase(dbPath);
+                execSql("BEGIN;");
+                start = benchNow();
+                for (int i = 1; i <= inserts; i++) saveGuestToDatabase(makeBenchGuest(i));
+                nsPerOp[on] = (benchNow() - start) * 1e9 / inserts;
+                execSql("COMMIT;");
+            }
+        }
+        const char* names[] = {"find-hotel", "list-hotels 10", "sqlite insert"};
+        cout << left << setw(16) << names[path] << right << setw(14) << setprecision(1) << nsPerOp[0] << setw(14)
+             << nsPerOp[1] << setw(11) << (nsPerOp[1] - nsPerOp[0]) * 100 / nsPerOp[0] << "%\n";
+    }
+    metrics.setEnabled(true);
+    hotelList.clearList();
+    closeDatabase();
+    remove(dbPath);
+}
+
+// Check-in bursts against the database file: synchronous autocommit as
+// shipped, the same with WAL and synchronous=NORMAL, and write-behind
+// group commit. The total includes the final flush, so every mode ends with
+// the same rows on disk.
+static void benchWriteBehind() {
+    const int guests = benchSize(3000);
+    const char* dbPath = "bench_write_behind.db";
+    struct Mode {
+        const char* name;
+        bool writeBehind;
+        const char* journal;
+        const char* synchronous;
+    };
+    const Mode modes[] = {
+        {"autocommit", false, "DELETE", "FULL"},
+        {"autocommit WAL", false, "WAL", "NORMAL"},
+        {"write-behind WAL", true, "WAL", "NORMAL"},
+    };
+
+    cout << "Write path: " << guests << " check-ins then " << guests << " serves\n";
+    cout << left << setw(18) << "mode" << right << setw(12) << "ops/s" << setw(10) << "p50 us" << setw(10) << "p99 us"
+         << setw(11) << "commits" << "\n";
+    DurabilityOptions saved = durability;
+    for (int m = 0; m < 3; m++) {
+        remove(dbPath);
+        remove((string(dbPath) + "-wal").c_str());
+        remove((string(dbPath) + "-shm").c_str());
+        durability.writeBehind = modes[m].writeBehind;
+        durability.journalMode = modes[m].journal;
+        durability.synchronous = modes[m].synchronous;
+        initializeDatabase(dbPath);
+        guestQueue.clearList();
+
+        vector<double> latencies;
+        string message;
+        double start = benchNow();
+        for (int i = 1; i <= guests * 2; i++) {
+            double begin = benchNow();
+            if (i <= guests) {
+                Guest guest = makeBenchGuest(i);
+                enqueueGuest(guest, message);
+            } else {
+                Guest served;
+                serveNextGuest(served, message);
+            }
+            latencies.push_back((benchNow() - begin) * 1e6);
+        }
+        flushPendingWrites();
+        double seconds = benchNow() - start;
+        unsigned long long commits = modes[m].writeBehind ? writeBehind.commitCount() : guests * 2;
+
+        sort(latencies.begin(), latencies.end());
+        cout << left << setw(18) << modes[m].name << right << fixed << setprecision(0) << setw(12)
+             << guests * 2 / seconds << setprecision(1) << setw(10) << latencies[latencies.size() / 2]
+             << setw(10) << latencies[latencies.size() * 99 / 100] << setw(11) << commits << "\n";
+
+        sqlite3_stmt* stmt;
+        int remaining = -1;
+        if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM Guests;", -1, &stmt, NULL) == SQLITE_OK) {
+            if (sqlite3_step(stmt) == SQLITE_ROW) remaining = sqlite3_column_int(stmt, 0);
+            sqlite3_finalize(stmt);
+        }
+        if (remaining != 0) {
+            cout << "MISMATCH: " << remaining << " guest row(s) left after serving everyone\n";
+            benchFailed = true;
+        }
+        closeDatabase();
+    }
+    durability = saved;
+    guestQueue.clearList();
+    remove(dbPath);
+    remove((string(dbPath) + "-wal").c_str());
+    remove((string(dbPath) + "-shm").c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Scaling suite
+// Every core store and persistence path at 1k to 1M records, with wall time,
+// thread CPU time and heap traffic per operation. Results are also collected
+// as records for the JSON report (--json <path>) so runs can be compared
+// between releases.
+// ---------------------------------------------------------------------------
+
+struct BenchSample {
+    double wall;
+    double cpu;
+    unsigned long long allocations;
+    unsigned long long frees;
+    unsigned long long bytes;
+};
+
+struct BenchRecord {
+    string benchmark;
+    string op;
+    int n;
+    long iterations;
+    double wallNs; // All per operation
+    double cpuNs;
+    double allocations;
+    double frees;
+    double bytes;
+};
+
+static vector<BenchRecord> benchRecords;
+
+static double benchCpuNow() {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user);
+    return ((unsigned long long)(user.dwHighDateTime) << 32 | user.dwLowDateTime) * 1e-7 +
+           ((unsigned long long)(kernel.dwHighDateTime) << 32 | kernel.dwLowDateTime) * 1e-7;
+#else
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
 }
 
+static BenchSample benchSample() {
+    BenchSample sample;
+    sample.wall = benchNow();
+    sample.cpu = benchCpuNow();
+    sample.allocations = benchAllocations;
+    sample.frees = benchFrees;
+    sample.bytes = benchAllocatedBytes;
+    return sample;
+}
 
-// Check if hotel ID is unique
-bool isHotelIdUnique(int id) {
-    return hotelList.isHotelIdUnique(id);
+// Close a measurement started with benchSample(), print it and keep it for JSON
+static void recordBench(const string& benchmark, const string& op, int n, long iterations, const BenchSample& begin) {
+    BenchSample end = benchSample();
+    BenchRecord record;
+    record.benchmark = benchmark;
+    record.op = op;
+    record.n = n;
+    record.iterations = max(1L, iterations);
+    record.wallNs = (end.wall - begin.wall) * 1e9 / record.iterations;
+    record.cpuNs = (end.cpu - begin.cpu) * 1e9 / record.iterations;
+    record.allocations = double(end.allocations - begin.allocations) / record.iterations;
+    record.frees = double(end.frees - begin.frees) / record.iterations;
+    record.bytes = double(end.bytes - begin.bytes) / record.iterations;
+    benchRecords.push_back(record);
+
+    cout << setw(9) << n << "  " << left << setw(12) << op << right << fixed << setprecision(1)
+         << setw(12) << record.wallNs << setw(12) << record.cpuNs << setprecision(2)
+         << setw(10) << record.allocations << setw(10) << record.frees << setprecision(1) << setw(11) << record.bytes << "\n";
 }
 
-// Check if guest ID is unique
-bool isGuestIdUnique(int id) {
-    return guestQueue.isGuestIdUnique(id);
+static void writeJsonString(ostream& out, const string& text) {
+    out << '"';
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '"' || text[i] == '\\') out << '\\';
+        out << text[i];
+    }
+    out << '"';
 }
 
-// Admin authentication
-bool authenticateAdmin() {
-    string password;
-    cout << "Enter admin password: ";
-    getline(cin, password);
-    return (password == "admin123"); // Simple password check
+static bool writeBenchJson(const string& path) {
+    ofstream out(path.c_str());
+    if (!out) {
+        cerr << "Error writing benchmark results to " << path << endl;
+        return false;
+    }
+    out << "{\n  \"schema\": 1,\n  \"compiler\": ";
+#ifdef __VERSION__
+    writeJsonString(out, __VERSION__);
+#else
+    writeJsonString(out, "unknown");
+#endif
+    out << ",\n  \"sqlite\": ";
+    writeJsonString(out, sqlite3_libversion());
+    out << ",\n  \"unix_time\": " << chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count()
+        << ",\n  \"results\": [";
+    out << setprecision(3) << fixed;
+    for (size_t i = 0; i < benchRecords.size(); i++) {
+        const BenchRecord& record = benchRecords[i];
+        out << (i ? ",\n" : "\n") << "    {\"benchmark\": ";
+        writeJsonString(out, record.benchmark);
+        out << ", \"op\": ";
+        writeJsonString(out, record.op);
+        out << ", \"n\": " << record.n << ", \"iterations\": " << record.iterations
+            << ", \"wall_ns_per_op\": " << record.wallNs << ", \"cpu_ns_per_op\": " << record.cpuNs
+            << ", \"allocs_per_op\": " << record.allocations << ", \"frees_per_op\": " << record.frees
+            << ", \"alloc_bytes_per_op\": " << record.bytes << "}";
+    }
+    out << "\n  ]\n}\n";
+    return bool(out);
 }
 
-// Admin menu
-void adminMenu() {
-    int choice;
-    do {
-        cout << "\nAdmin Menu\n"
-             << "1. Add Hotel\n"
-             << "2. Update Hotel\n"
-             << "3. View Hotels\n"
-             << "4. Delete Hotel\n"
-             << "5. Back\nChoice: ";
-        cin >> choice;
-        cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+static void benchScaling() {
+    const int sizes[] = {benchSize(1000), benchSize(10000), benchSize(100000), benchSize(1000000)};
+    const int maxFinds = benchSize(100000);
+    const char* dbPath = "bench_scaling.db";
 
-        switch(choice) {
-            case 1: addHotel(); break;
-            case 2: updateHotel(); break;
-            case 3: viewHotels(); break;
-            case 4: deleteHotel(); break;
+    cout << "Scaling: per-operation cost by store size\n";
+    cout << setw(9) << "n" << "  " << left << setw(12) << "op" << right << setw(12) << "wall ns" << setw(12) << "cpu ns"
+         << setw(10) << "allocs" << setw(10) << "frees" << setw(11) << "bytes" << "\n";
+
+    for (int s = 0; s < 4; s++) {
+        int n = sizes[s];
+        vector<Hotel> hotels;
+        vector<Guest> guests;
+        hotels.reserve(n);
+        guests.reserve(n);
+        for (int i = 1; i <= n; i++) {
+            hotels.push_back(makeBenchHotel(i));
+            guests.push_back(makeBenchGuest(i));
         }
-    } while(choice != 5);
-}
+        vector<int> order(n);
+        for (int i = 0; i < n; i++) order[i] = i + 1;
+        unsigned int rng = 99;
+        for (int i = n - 1; i > 0; i--) swap(order[i], order[benchRandom(rng) % (i + 1)]);
+        volatile long sink = 0;
 
-// Add a new hotel
-void addHotel() {
-    Hotel hotel;
-    cout << "Enter Hotel ID: ";
-    cin >> hotel.id;
-    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+        {
+            HotelLinkedList store;
+            BenchSample begin = benchSample();
+            for (int i = 0; i < n; i++) store.addHotel(Hotel(hotels[i]));
+            recordBench("scaling", "insert", n, n, begin);
 
-    if (!isHotelIdUnique(hotel.id)) {
-        cout << "Error: Hotel ID already exists. Please enter a unique ID.\n";
-        return;
-    }
+            int finds = min(n, maxFinds);
+            begin = benchSample();
+            for (int i = 0; i < finds; i++) sink = sink + store.findHotel(order[i])->roomNumber;
+            recordBench("scaling", "find", n, finds, begin);
 
-    cout << "Enter Hotel Name: ";
-    getline(cin, hotel.name);
-    cout << "Enter Services: ";
-    getline(cin, hotel.services);
-    cout << "Enter Location: ";
-    getline(cin, hotel.location);
-    cout << "Enter Room Number: ";
-    cin >> hotel.roomNumber;
-    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+            begin = benchSample();
+            for (HotelNode* node = store.head; node; node = node->next) sink = sink + node->roomNumber;
+            recordBench("scaling", "iterate", n, n, begin);
 
-    hotelList.addHotel(hotel);
-    saveHotelToDatabase(hotel);
-    cout << "Hotel added successfully!\n";
-}
+            begin = benchSample();
+            {
+                list<Hotel> copy = store.toList();
+                sink = sink + long(copy.size());
+            }
+            recordBench("scaling", "toList", n, n, begin);
 
-// Save hotel to database
-void saveHotelToDatabase(Hotel hotel) {
-    char* sql = (char*) "INSERT INTO Hotels (id, name, services, location, roomNumber) VALUES (?, ?, ?, ?, ?);";
-    sqlite3_stmt* stmt;
+            begin = benchSample();
+            for (int i = 0; i < n; i++) store.removeHotel(order[i]);
+            recordBench("scaling", "remove", n, n, begin);
+        }
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
-        sqlite3_bind_int(stmt, 1, hotel.id);
-        sqlite3_bind_text(stmt, 2, hotel.name.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, hotel.services.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 4, hotel.location.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 5, hotel.roomNumber);
+        {
+            GuestLinkedList queue;
+            BenchSample begin = benchSample();
+            for (int i = 0; i < n; i++) queue.addGuest(guests[i]);
+            recordBench("scaling", "enqueue", n, n, begin);
 
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            cerr << "Error inserting hotel into database: " << sqlite3_errmsg(db) << endl;
+            begin = benchSample();
+            for (int i = 0; i < n; i++) sink = sink + queue.serveGuest().id;
+            recordBench("scaling", "serve", n, n, begin);
         }
-        sqlite3_finalize(stmt);
-    } else {
-        cerr << "Error preparing insert statement: " << sqlite3_errmsg(db) << endl;
+
+        // Persistence through the cached statements, one transaction per run
+        remove(dbPath);
+        initializeDatabase(dbPath);
+        BenchSample begin = benchSample();
+        execSql("BEGIN;");
+        for (int i = 0; i < n; i++) saveHotelToDatabase(hotels[i]);
+        execSql("COMMIT;");
+        recordBench("scaling", "save-hotels", n, n, begin);
+
+        begin = benchSample();
+        execSql("BEGIN;");
+        for (int i = 0; i < n; i++) saveGuestToDatabase(guests[i]);
+        execSql("COMMIT;");
+        recordBench("scaling", "save-guests", n, n, begin);
+
+        begin = benchSample();
+        loadHotelsFromDatabase();
+        recordBench("scaling", "load-hotels", n, n, begin);
+        if (hotelList.size() != n) {
+            cout << "MISMATCH: loaded " << hotelList.size() << " hotels\n";
+            benchFailed = true;
+        }
+
+        begin = benchSample();
+        loadGuestsFromDatabase();
+        recordBench("scaling", "load-guests", n, n, begin);
+        if (guestQueue.size() != n) {
+            cout << "MISMATCH: loaded " << guestQueue.size() << " guests\n";
+            benchFailed = true;
+        }
+
+        hotelList.clearList();
+        guestQueue.clearList();
+        closeDatabase();
+        remove(dbPath);
     }
 }
 
-// Load hotels from database
-void loadHotelsFromDatabase() {
-    hotelList.clearList();
-    char* sql = (char*) "SELECT * FROM Hotels;";
-    sqlite3_stmt* stmt;
+// Picking up K rows another process changed: replaying the change log
+// against clearing the lists and reloading both tables. The other process
+// is a second connection that updates, deletes and inserts hotels and renames
+// guests; afterwards memory is checked row by row against the tables.
+static bool hotelsMatchDatabase() {
+    vector<Hotel> stored;
+    long long seq;
+    if (!readHotels(db, stored, seq) || stored.size() != size_t(hotelList.size())) return false;
+    for (size_t i = 0; i < stored.size(); i++) {
+        HotelNode* node = hotelList.findHotel(stored[i].id);
+        if (!node || !sameHotel(hotelList.toHotel(node), stored[i])) return false;
+    }
+    return true;
+}
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            Hotel hotel;
-            hotel.id = sqlite3_column_int(stmt, 0);
-            hotel.name = (char*)sqlite3_column_text(stmt, 1);
-            hotel.services = (char*)sqlite3_column_text(stmt, 2);
-            hotel.location = (char*)sqlite3_column_text(stmt, 3);
-            hotel.roomNumber = sqlite3_column_int(stmt, 4);
-            hotelList.addHotel(hotel);
+static void benchChangeSync() {
+    const int sizes[] = {benchSize(10000), benchSize(100000), benchSize(500000)};
+    const int changeCounts[] = {10, 1000};
+    const char* dbPath = "bench_sync.db";
+    cout << "Refresh after K external changes: change-log replay vs full reload\n"
+         << setw(9) << "hotels" << setw(8) << "K" << setw(16) << "replay ms" << setw(16) << "reload ms"
+         << setw(12) << "speedup\n";
+    for (int n : sizes) {
+        remove(dbPath);
+        initializeDatabase(dbPath);
+        execSql("BEGIN;");
+        for (int i = 1; i <= n; i++) saveHotelToDatabase(makeBenchHotel(i));
+        for (int i = 1; i <= n / 10; i++) saveGuestToDatabase(makeBenchGuest(i));
+        execSql("COMMIT;");
+        loadHotelsFromDatabase();
+        loadGuestsFromDatabase();
+        string message;
+        refreshFromDatabase(message); // Trims the n inserts above from the log, outside the timing
+
+        sqlite3* other;
+        sqlite3_open(dbPath, &other);
+        int nextId = n + 1;
+        unsigned int rng = 2463534242u;
+        for (int k : changeCounts) {
+            execSql(other, "BEGIN;");
+            for (int i = 0; i < k; i++) {
+                int id = 1 + benchRandom(rng) % n;
+                string sql;
+                switch (i % 4) {
+                    case 0:
+                    case 1:
+                        sql = "UPDATE Hotels SET name = 'Renamed " + to_string(i) + "', roomNumber = roomNumber + 1 "
+                              "WHERE id = " + to_string(id) + ";";
+                        break;
+                    case 2:
+                        sql = "DELETE FROM Hotels WHERE id = " + to_string(id) + "; "
+                              "INSERT INTO Hotels (id, name, services, location, roomNumber) VALUES (" +
+                              to_string(nextId++) + ", 'Partner Hotel', 'Pool', 'Gondar', 12);";
+                        break;
+                    default:
+                        sql = "UPDATE Guests SET name = 'Guest renamed " + to_string(i) + "' WHERE id = " +
+                              to_string(1 + id % (n / 10)) + ";";
+                        break;
+                }
+                execSql(other, sql.c_str());
+            }
+            execSql(other, "COMMIT;");
+
+            double start = benchNow();
+            bool refreshed = refreshFromDatabase(message);
+            double replaySeconds = benchNow() - start;
+            if (!refreshed || !hotelsMatchDatabase() || guestQueue.size() != n / 10) {
+                cout << "MISMATCH after replaying " << k << " changes: " << message << "\n";
+                benchFailed = true;
+            }
+
+            start = benchNow();
+            hotelList.clearList();
+            guestQueue.clearList();
+            loadHotelsFromDatabase();
+            loadGuestsFromDatabase();
+            double reloadSeconds = benchNow() - start;
+
+            cout << setw(9) << n << setw(8) << k << setw(16) << fixed << setprecision(2) << replaySeconds * 1e3
+                 << setw(16) << reloadSeconds * 1e3 << setw(11) << setprecision(1)
+                 << (replaySeconds > 0 ? reloadSeconds / replaySeconds : 0) << "x\n";
         }
-        sqlite3_finalize(stmt);
-    } else {
-        cerr << "Error loading hotels from database: " << sqlite3_errmsg(db) << endl;
+        sqlite3_close(other);
+        hotelList.clearList();
+        guestQueue.clearList();
+        closeDatabase();
+        remove(dbPath);
     }
 }
 
-// Update hotel details
-void updateHotel() {
-    int id;
-    cout << "Enter Hotel ID to update: ";
-    cin >> id;
-    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+// Room availability over a year of nights at thousands of hotels, filled by
+// random bookings: the per-hotel segment trees against a per-night array
+// scan, for single-hotel checks and for cross-hotel searches. Every tree
+// answer is checked against the scan.
+static void benchAvailability() {
+    const int n = benchSize(5000);
+    const int locations = 20;
+    const int year = 365;
+    const int attempts = benchSize(1000000);
+    const int queries = benchSize(20000);
+    int firstNight;
+    parseDate("2026-01-01", firstNight);
 
-    HotelNode* hotelNode = hotelList.findHotel(id);
-    if (hotelNode) {
-        Hotel& hotel = hotelNode->data;
-        cout << "New name (" << hotel.name << "): ";
-        getline(cin, hotel.name);
-        cout << "New services (" << hotel.services << "): ";
-        getline(cin, hotel.services);
-        cout << "New location (" << hotel.location << "): ";
-        getline(cin, hotel.location);
-        cout << "New room number (" << hotel.roomNumber << "): ";
-        cin >> hotel.roomNumber;
-        cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+    HotelLinkedList store;
+    store.reserve(n);
+    BookingLedger ledger;
+    vector<vector<int> > booked(n + 1, vector<int>(year, 0)); // The scan's own per-night counts
+    unsigned int rng = 23;
+    for (int i = 1; i <= n; i++) {
+        Hotel hotel = makeBenchHotel(i);
+        hotel.location = "City " + to_string(benchRandom(rng) % locations);
+        hotel.roomNumber = 5 + int(benchRandom(rng) % 56);
+        store.addHotel(std::move(hotel));
+    }
 
-        char* sql = (char*) "UPDATE Hotels SET name=?, services=?, location=?, roomNumber=? WHERE id=?;";
-        sqlite3_stmt* stmt;
+    // Book as guests would: a check, then the booking if it fits
+    int accepted = 0;
+    double start = benchNow();
+    for (int i = 0; i < attempts; i++) {
+        Booking booking;
+        booking.id = ledger.nextBookingId();
+        booking.hotelId = 1 + int(benchRandom(rng) % n);
+        booking.checkIn = firstNight + int(benchRandom(rng) % year);
+        booking.checkOut = min(firstNight + year, booking.checkIn + 1 + int(benchRandom(rng) % 14));
+        booking.rooms = 1 + int(benchRandom(rng) % 8);
+        HotelNode* node = store.findHotel(booking.hotelId);
+        if (freeRoomsFor(ledger, node, booking.checkIn, booking.checkOut) < booking.rooms) continue;
+        ledger.add(booking);
+        for (int night = booking.checkIn; night < booking.checkOut; night++) {
+            booked[booking.hotelId][night - firstNight] += booking.rooms;
+        }
+        accepted++;
+    }
+    double bookNs = (benchNow() - start) * 1e9 / attempts;
+    long roomNights = 0, capacity = 0;
+    for (HotelNode* node = store.head; node; node = node->next) {
+        capacity += long(node->roomNumber) * year;
+        for (int night = 0; night < year; night++) roomNights += booked[node->id][night];
+    }
+    cout << "Availability: " << n << " hotels, " << year << " nights, " << accepted << " of " << attempts
+         << " bookings accepted (" << fixed << setprecision(1) << 100.0 * roomNights / capacity
+         << "% of room-nights), check + book " << bookNs << " ns\n";
+
+    auto scanFree = [&booked, firstNight](const HotelNode* node, int checkIn, int checkOut) {
+        int busiest = 0;
+        for (int night = checkIn; night < checkOut; night++) {
+            busiest = max(busiest, booked[node->id][night - firstNight]);
+        }
+        return max(0, node->roomNumber - busiest);
+    };
+
+    cout << left << setw(40) << "query" << right << setw(14) << "scan us" << setw(14) << "tree us" << setw(11)
+         << "speedup\n";
+    const int stays[] = {3, 30, 365};
+    for (int nights : stays) {
+        vector<int> hotelIds(queries), checkIns(queries);
+        for (int q = 0; q < queries; q++) {
+            hotelIds[q] = 1 + int(benchRandom(rng) % n);
+            checkIns[q] = firstNight + int(benchRandom(rng) % (year - nights + 1));
+        }
+        vector<int> fromTree(queries), fromScan(queries);
+        start = benchNow();
+        for (int q = 0; q < queries; q++) {
+            fromTree[q] = freeRoomsFor(ledger, store.findHotel(hotelIds[q]), checkIns[q], checkIns[q] + nights);
+        }
+        double treeUs = (benchNow() - start) * 1e6 / queries;
+        start = benchNow();
+        for (int q = 0; q < queries; q++) {
+            fromScan[q] = scanFree(store.findHotel(hotelIds[q]), checkIns[q], checkIns[q] + nights);
+        }
+        double scanUs = (benchNow() - start) * 1e6 / queries;
+        if (fromTree != fromScan) {
+            cout << "MISMATCH: tree and scan disagree on free rooms for " << nights << "-night stays\n";
+            benchFailed = true;
+        }
+        cout << left << setw(40) << ("one hotel, " + to_string(nights) + "-night stay") << right << setw(14)
+             << setprecision(3) << scanUs << setw(14) << treeUs << setw(10) << setprecision(1) << scanUs / treeUs
+             << "x\n";
+    }
 
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, hotel.name.c_str(), -1, SQLITE_STATIC);
-            sqlite3_bind_text(stmt, 2, hotel.services.c_str(), -1, SQLITE_STATIC);
-            sqlite3_bind_text(stmt, 3, hotel.location.c_str(), -1, SQLITE_STATIC);
-            sqlite3_bind_int(stmt, 4, hotel.roomNumber);
-            sqlite3_bind_int(stmt, 5, hotel.id);
+    // "Which hotels have 3 free rooms from the 12th to the 15th", at one town or anywhere
+    struct Search {
+        const char* text;
+        bool anyLocation;
+        int rooms;
+        int nights;
+        size_t limit;
+    };
+    const Search searches[] = {
+        {"one town, 3 rooms, 3 nights, first 20", false, 3, 3, 20},
+        {"one town, 30 rooms, 7 nights, all", false, 30, 7, size_t(n)},
+        {"anywhere, 3 rooms, 3 nights, first 20", true, 3, 3, 20},
+        {"anywhere, 50 rooms, 14 nights, all", true, 50, 14, size_t(n)},
+    };
+    const int searchRepeats = 200;
+    for (size_t s = 0; s < sizeof(searches) / sizeof(searches[0]); s++) {
+        const Search& search = searches[s];
+        vector<string> towns(searchRepeats);
+        vector<int> checkIns(searchRepeats);
+        for (int r = 0; r < searchRepeats; r++) {
+            towns[r] = search.anyLocation ? string() : "City " + to_string(benchRandom(rng) % locations);
+            checkIns[r] = firstNight + int(benchRandom(rng) % (year - search.nights + 1));
+        }
+        vector<FreeHotel> matches;
+        vector<vector<int> > fromTree(searchRepeats), fromScan(searchRepeats);
+        start = benchNow();
+        for (int r = 0; r < searchRepeats; r++) {
+            findFreeHotels(store, ledger, towns[r], search.rooms, checkIns[r], checkIns[r] + search.nights,
+                           search.limit, matches);
+            for (size_t i = 0; i < matches.size(); i++) fromTree[r].push_back(matches[i].node->id);
+        }
+        double treeUs = (benchNow() - start) * 1e6 / searchRepeats;
 
-            if (sqlite3_step(stmt) != SQLITE_DONE) {
-                cerr << "Error updating hotel: " << sqlite3_errmsg(db) << endl;
+        // The scan visits every hotel, then orders the fits as the index does
+        start = benchNow();
+        for (int r = 0; r < searchRepeats; r++) {
+            vector<HotelNode*> fits;
+            for (HotelNode* node = store.head; node; node = node->next) {
+                if (!towns[r].empty() && store.locationOf(node) != towns[r]) continue;
+                if (scanFree(node, checkIns[r], checkIns[r] + search.nights) >= search.rooms) fits.push_back(node);
             }
-            sqlite3_finalize(stmt);
-        } else {
-            cerr << "Error preparing update statement: " << sqlite3_errmsg(db) << endl;
+            size_t keep = min(search.limit, fits.size());
+            partial_sort(fits.begin(), fits.begin() + keep, fits.end(), [](const HotelNode* a, const HotelNode* b) {
+                return a->roomNumber != b->roomNumber ? a->roomNumber > b->roomNumber : a->id > b->id;
+            });
+            for (size_t i = 0; i < keep; i++) fromScan[r].push_back(fits[i]->id);
+        }
+        double scanUs = (benchNow() - start) * 1e6 / searchRepeats;
+        if (fromTree != fromScan) {
+            cout << "MISMATCH: tree and scan disagree for " << search.text << "\n";
+            benchFailed = true;
         }
+        cout << left << setw(40) << search.text << right << setw(14) << setprecision(1) << scanUs << setw(14)
+             << treeUs << setw(10) << scanUs / treeUs << "x\n";
+    }
 
-        cout << "Hotel updated successfully!\n";
-        return;
+    // Cancelling half the bookings and rebooking them keeps the trees exact
+    start = benchNow();
+    int cycled = 0;
+    for (int id = 1; id < ledger.nextBookingId(); id += 2) {
+        const Booking* found = ledger.findBooking(id);
+        if (!found) continue;
+        Booking booking = *found;
+        ledger.remove(id);
+        ledger.add(booking);
+        cycled++;
     }
-    cout << "Hotel not found!\n";
-}
+    cout << "cancel + rebook: " << setprecision(0) << (benchNow() - start) * 1e9 / max(1, cycled) << " ns, "
+         << ledger.calendarCount() << " hotel calendars\n";
 
-// View all hotels
-void viewHotels() {
-    hotelList.displayHotels();
+    // Shrinking a hotel: its busiest night as room count is accepted, one
+    // room fewer is refused, naming the nights the scan finds over it
+    int refused = 0;
+    string message;
+    vector<int> fromTree, fromScan;
+    for (HotelNode* node = store.head; node; node = node->next) {
+        int busiest = *max_element(booked[node->id].begin(), booked[node->id].end());
+        if (!roomsCoverBookings(ledger, node->id, busiest, message)) {
+            cout << "MISMATCH: hotel " << node->id << " refused at its busiest night of " << busiest << "\n";
+            benchFailed = true;
+        }
+        if (busiest == 0) continue;
+        if (roomsCoverBookings(ledger, node->id, busiest - 1, message)) {
+            cout << "MISMATCH: hotel " << node->id << " accepted " << busiest - 1 << " rooms\n";
+            benchFailed = true;
+        }
+        ledger.overbookedNights(node->id, busiest - 1, fromTree);
+        fromScan.clear();
+        for (int night = 0; night < year; night++) {
+            if (booked[node->id][night] > busiest - 1) fromScan.push_back(firstNight + night);
+        }
+        if (fromTree != fromScan) {
+            cout << "MISMATCH: tree and scan disagree on overbooked nights at hotel " << node->id << "\n";
+            benchFailed = true;
+        }
+        // Below zero rooms only the nights with something booked count
+        ledger.overbookedNights(node->id, -1, fromTree);
+        fromScan.clear();
+        for (int night = 0; night < year; night++) {
+            if (booked[node->id][night] > 0) fromScan.push_back(firstNight + night);
+        }
+        if (fromTree != fromScan) {
+            cout << "MISMATCH: hotel " << node->id << " counts empty nights as overbooked\n";
+            benchFailed = true;
+        }
+        refused++;
+    }
+    cout << "room count below the busiest night: " << refused << " of " << n << " hotels refused\n";
 }
 
-// Delete a hotel
-void deleteHotel() {
-    int id;
-    cout << "Enter Hotel ID to delete: ";
-    cin >> id;
-    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+// Management report at scale: reading the running totals against walking
+// every hotel and guest and against GROUP BY over the tables, plus what the
+// totals add to each hotel change. After a mix of updates, removals and
+// serves the totals are checked against both recounts.
+static void benchReportAggregates() {
+    const int sizes[] = {benchSize(10000), benchSize(100000), benchSize(1000000)};
+    const int towns = 200;
+    const int changes = benchSize(100000);
+    const char* servicesMix[] = {"Free Wi-Fi, Restaurant, Pool", "Spa, Free Breakfast", "Bar, Room Service",
+                                 "Free Parking, Conference Room", "Free Wi-Fi, Garden", "Pool, Spa, Gym",
+                                 "Free Breakfast, Bar", "free wifi, Airport Shuttle, Laundry"};
+    const int mixCount = sizeof(servicesMix) / sizeof(servicesMix[0]);
+    const char* dbPath = "bench_report.db";
+    cout << "Management report: running totals vs recounting\n"
+         << setw(9) << "hotels" << setw(14) << "totals us" << setw(14) << "walk ms" << setw(14) << "SQL ms"
+         << setw(12) << "walk/tot" << setw(16) << "upkeep ns/chg\n";
+    for (int n : sizes) {
+        remove(dbPath);
+        initializeDatabase(dbPath);
+        HotelLinkedList store;
+        GuestLinkedList queue;
+        store.reserve(n);
+        unsigned int rng = 88172645u;
+        execSql("BEGIN;");
+        for (int i = 1; i <= n; i++) {
+            Hotel hotel = makeBenchHotel(i);
+            hotel.location = "City " + to_string(benchRandom(rng) % towns);
+            hotel.services = servicesMix[benchRandom(rng) % mixCount];
+            saveHotelToDatabase(hotel);
+            store.addHotel(std::move(hotel));
+        }
+        for (int i = 1; i <= n / 10; i++) {
+            saveGuestToDatabase(makeBenchGuest(i));
+            queue.addGuest(makeBenchGuest(i));
+        }
+        execSql("COMMIT;");
 
-    if (hotelList.removeHotel(id)) {
-        char* sql = (char*) "DELETE FROM Hotels WHERE id=?;";
-        sqlite3_stmt* stmt;
+        const int reads = 1000;
+        ManagementReport live, walked, stored;
+        double start = benchNow();
+        for (int r = 0; r < reads; r++) readReport(store, queue, live);
+        double liveUs = (benchNow() - start) * 1e6 / reads;
+        start = benchNow();
+        recountReport(store, queue, walked);
+        double walkMs = (benchNow() - start) * 1e3;
+        start = benchNow();
+        bool read = reportFromDatabase(store, stored);
+        double sqlMs = (benchNow() - start) * 1e3;
+        vector<string> differences;
+        diffReports(walked, live, "list walk", differences);
+        if (read) diffReports(stored, live, "database", differences);
 
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
-            sqlite3_bind_int(stmt, 1, id);
+        // The totals' own share of a hotel update: out with the old fields, in with the new
+        HotelAggregates totals;
+        AmenityIndex dictionary;
+        vector<int> fromTown(changes), toTown(changes), fromMix(changes), toMix(changes);
+        for (int c = 0; c < changes; c++) {
+            fromTown[c] = benchRandom(rng) % towns;
+            toTown[c] = benchRandom(rng) % towns;
+            fromMix[c] = benchRandom(rng) % mixCount;
+            toMix[c] = benchRandom(rng) % mixCount;
+            totals.apply(fromTown[c], 20, dictionary.parse(servicesMix[fromMix[c]]), 1);
+        }
+        start = benchNow();
+        for (int c = 0; c < changes; c++) {
+            totals.apply(fromTown[c], 20, dictionary.parse(servicesMix[fromMix[c]]), -1);
+            totals.apply(toTown[c], 25, dictionary.parse(servicesMix[toMix[c]]), 1);
+        }
+        double upkeepNs = (benchNow() - start) * 1e9 / changes;
 
-            if (sqlite3_step(stmt) == SQLITE_DONE) {
-                cout << "Hotel deleted successfully!\n";
-            } else {
-                cerr << "Error deleting hotel from database: " << sqlite3_errmsg(db) << endl;
+        // Change the store behind the database's back, then recount the lists again
+        for (int c = 0; c < changes / 10; c++) {
+            int id = 1 + int(benchRandom(rng) % n);
+            HotelNode* node = store.findHotel(id);
+            if (!node) continue;
+            if (c % 3 == 2) {
+                store.removeHotel(id);
+                continue;
             }
-            sqlite3_finalize(stmt);
-        } else {
-            cerr << "Error preparing delete statement: " << sqlite3_errmsg(db) << endl;
+            Hotel hotel = store.toHotel(node);
+            hotel.location = "City " + to_string(benchRandom(rng) % towns);
+            hotel.services = servicesMix[benchRandom(rng) % mixCount];
+            hotel.roomNumber = 5 + int(benchRandom(rng) % 60);
+            store.updateHotel(hotel);
         }
-    } else {
-        cout << "Hotel not found!\n";
+        for (int i = 0; i < n / 20; i++) queue.serveGuest();
+        readReport(store, queue, live);
+        recountReport(store, queue, walked);
+        diffReports(walked, live, "list walk after changes", differences);
+        if (!read || !differences.empty() || live.served != n / 20) {
+            cout << "MISMATCH in the report totals";
+            if (!differences.empty()) cout << ": " << differences[0];
+            cout << "\n";
+            benchFailed = true;
+        }
+
+        cout << setw(9) << n << setw(14) << fixed << setprecision(2) << liveUs << setw(14) << setprecision(1)
+             << walkMs << setw(14) << sqlMs << setw(11) << setprecision(0) << walkMs * 1e3 / liveUs << "x"
+             << setw(15) << setprecision(1) << upkeepNs << "\n";
+        closeDatabase();
+        remove(dbPath);
     }
 }
 
-// Customer menu
-void customerMenu() {
-    int choice;
-    do {
-        cout << "\nCustomer Menu\n"
-             << "1. View Hotels\n"
-             << "2. Join Queue\n"
-             << "3. View Queue\n"
-             << "4. Add Itinerary Stop\n"
-             << "5. View Itinerary\n"
-             << "6. Back\nChoice: ";
-        cin >> choice;
-        cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+// The per-column code the record schemas replaced, kept as the baseline
+static void handBindHotel(sqlite3_stmt* stmt, const Hotel& hotel) {
+    sqlite3_bind_int(stmt, 1, hotel.id);
+    sqlite3_bind_text(stmt, 2, hotel.name.data(), int(hotel.name.size()), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, hotel.services.data(), int(hotel.services.size()), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, hotel.location.data(), int(hotel.location.size()), SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 5, hotel.roomNumber);
+    if (std::isnan(hotel.latitude)) sqlite3_bind_null(stmt, 6);
+    else sqlite3_bind_double(stmt, 6, hotel.latitude);
+    if (std::isnan(hotel.longitude)) sqlite3_bind_null(stmt, 7);
+    else sqlite3_bind_double(stmt, 7, hotel.longitude);
+}
 
-        switch(choice) {
-            case 1:
-                // DEBUG OUTPUT:
-                cout << "Debug: Number of hotels in list: " << hotelList.size() << endl;
-                viewHotels();
-                break;
-            case 2: addGuest(); break;
-            case 3: displayGuestQueue(); break;
-            case 4: addStopToItinerary(); break;
-            case 5: viewItinerary(); break;
-        }
-    } while(choice != 6);
+static void handReadHotel(sqlite3_stmt* stmt, Hotel& hotel) {
+    hotel.id = sqlite3_column_int(stmt, 0);
+    hotel.name = columnText(stmt, 1);
+    hotel.services = columnText(stmt, 2);
+    hotel.location = columnText(stmt, 3);
+    hotel.roomNumber = sqlite3_column_int(stmt, 4);
+    hotel.latitude = columnReal(stmt, 5);
+    hotel.longitude = columnReal(stmt, 6);
 }
 
-// Add a guest to the queue
-void addGuest() {
-    Guest guest;
-    cout << "Enter Guest ID: ";
-    cin >> guest.id;
-    cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear the input buffer
+static void handEncodeHotel(const Hotel& hotel, string& out) {
+    int32_t fields[2] = {hotel.id, hotel.roomNumber};
+    uint32_t lengths[3] = {uint32_t(hotel.name.size()), uint32_t(hotel.services.size()),
+                           uint32_t(hotel.location.size())};
+    double coordinates[2] = {hotel.latitude, hotel.longitude};
+    out.append((const char*)fields, sizeof(fields));
+    out.append((const char*)lengths, sizeof(lengths));
+    out.append((const char*)coordinates, sizeof(coordinates));
+    out += hotel.name;
+    out += hotel.services;
+    out += hotel.location;
+}
 
-    if (!isGuestIdUnique(guest.id)) {
-        cout << "Error: Guest ID already exists. Please enter a unique ID.\n";
-        return;
-    }
+static bool handTake(const char*& cursor, const char* end, void* out, size_t bytes) {
+    if (size_t(end - cursor) < bytes) return false;
+    memcpy(out, cursor, bytes);
+    cursor += bytes;
+    return true;
+}
 
-    cout << "Enter Guest Name: ";
-    getline(cin, guest.name);
+static bool handTakeString(const char*& cursor, const char* end, uint32_t length, string& out) {
+    if (size_t(end - cursor) < length) return false;
+    out.assign(cursor, length);
+    cursor += length;
+    return true;
+}
 
-    guest.queuePosition = guestQueue.size() + 1;
-    guestQueue.addGuest(guest);
-    saveGuestToDatabase(guest);
-    cout << "Guest added to queue! Position: " << guest.queuePosition << "\n";
+static bool handDecodeHotel(const char*& cursor, const char* end, Hotel& hotel) {
+    int32_t id = 0, roomNumber = 0;
+    uint32_t lengths[3] = {0, 0, 0};
+    bool ok = handTake(cursor, end, &id, 4) && handTake(cursor, end, &roomNumber, 4) &&
+              handTake(cursor, end, lengths, sizeof(lengths)) && handTake(cursor, end, &hotel.latitude, 8) &&
+              handTake(cursor, end, &hotel.longitude, 8) && handTakeString(cursor, end, lengths[0], hotel.name) &&
+              handTakeString(cursor, end, lengths[1], hotel.services) &&
+              handTakeString(cursor, end, lengths[2], hotel.location);
+    hotel.id = id;
+    hotel.roomNumber = roomNumber;
+    return ok;
 }
 
-// Save guest to database
-void saveGuestToDatabase(Guest guest) {
-    char* sql = (char*) "INSERT INTO Guests (id, name, queuePosition) VALUES (?, ?, ?);";
-    sqlite3_stmt* stmt;
+static void handEncodeGuest(const Guest& guest, string& out) {
+    int32_t fields[2] = {guest.id, guest.queuePosition};
+    uint32_t length = uint32_t(guest.name.size());
+    out.append((const char*)fields, sizeof(fields));
+    out.append((const char*)&length, sizeof(length));
+    out += guest.name;
+}
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
-        sqlite3_bind_int(stmt, 1, guest.id);
-        sqlite3_bind_text(stmt, 2, guest.name.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 3, guest.queuePosition);
+static bool handDecodeGuest(const char*& cursor, const char* end, Guest& guest) {
+    int32_t id = 0, queuePosition = 0;
+    uint32_t length = 0;
+    bool ok = handTake(cursor, end, &id, 4) && handTake(cursor, end, &queuePosition, 4) &&
+              handTake(cursor, end, &length, 4) && handTakeString(cursor, end, length, guest.name);
+    guest.id = id;
+    guest.queuePosition = queuePosition;
+    return ok;
+}
 
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            cerr << "Error inserting guest into database: " << sqlite3_errmsg(db) << endl;
+// Binding, reading and encoding records through the code generated from the
+// record schemas against the hand-written code it replaced. Binds are timed
+// without stepping, and reads step an in-memory table, so both include the
+// SQLite calls themselves. Generated and hand-written output must match.
+static void benchSchemaCodec() {
+    const int n = benchSize(200000);
+    vector<Hotel> hotels(n);
+    vector<Guest> guests(n);
+    unsigned int rng = 1234567u;
+    for (int i = 0; i < n; i++) {
+        hotels[i] = makeBenchHotel(i + 1);
+        hotels[i].location = "City " + to_string(benchRandom(rng) % 200);
+        if (i % 3) {
+            hotels[i].latitude = 3.0 + (benchRandom(rng) % 1200000) / 1e5;
+            hotels[i].longitude = 33.0 + (benchRandom(rng) % 1500000) / 1e5;
         }
-        sqlite3_finalize(stmt);
-    } else {
-        cerr << "Error preparing insert statement: " << sqlite3_errmsg(db) << endl;
+        guests[i] = makeBenchGuest(i + 1);
     }
-}
+    cout << "Record codecs: hand-written vs generated from the schemas (ns/record)\n"
+         << setw(9) << "records" << "  " << left << setw(10) << "op" << right << setw(16) << "hand" << setw(16)
+         << "generated" << setw(13) << "ratio\n";
 
-// Load guests from database
-void loadGuestsFromDatabase() {
-    guestQueue.clearList();
-    char* sql = (char*) "SELECT * FROM Guests;";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            Guest guest;
-            guest.id = sqlite3_column_int(stmt, 0);
-            guest.name = (char*)sqlite3_column_text(stmt, 1);
-            guest.queuePosition = sqlite3_column_int(stmt, 2);
-            guestQueue.addGuest(guest);
+    sqlite3* memory;
+    sqlite3_open(":memory:", &memory);
+    sqlite3_exec(memory, createTableSql<Hotel>().c_str(), NULL, NULL, NULL);
+    sqlite3_stmt* insert;
+    sqlite3_prepare_v2(memory, INSERT_HOTEL_SQL.c_str(), -1, &insert, NULL);
+    const int rounds = 5;
+    double start = benchNow();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < n; i++) {
+            sqlite3_reset(insert);
+            handBindHotel(insert, hotels[i]);
         }
-        sqlite3_finalize(stmt);
-    } else {
-        cerr << "Error loading guests from database: " << sqlite3_errmsg(db) << endl;
     }
-}
+    double hand = (benchNow() - start) * 1e9 / (double(n) * rounds);
+    start = benchNow();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < n; i++) {
+            sqlite3_reset(insert);
+            bindRecord(insert, hotels[i]);
+        }
+    }
+    double generated = (benchNow() - start) * 1e9 / (double(n) * rounds);
+    printBenchRow(n, "bind", hand, generated);
 
-// Serve the next guest in the queue
-void serveGuest() {
-    Guest servedGuest = guestQueue.serveGuest();
-    if (servedGuest.id != 0) { // Check if a guest was actually served (ID will be 0 if default Guest was returned)
-        cout << "Serving guest: " << servedGuest.name << " (ID: " << servedGuest.id << ")\n";
+    // Fill the table through the generated binds, then read it back both ways
+    sqlite3_exec(memory, "BEGIN;", NULL, NULL, NULL);
+    for (int i = 0; i < n; i++) {
+        sqlite3_reset(insert);
+        bindRecord(insert, hotels[i]);
+        if (sqlite3_step(insert) != SQLITE_DONE) benchFailed = true;
+    }
+    sqlite3_exec(memory, "COMMIT;", NULL, NULL, NULL);
+    sqlite3_finalize(insert);
+    sqlite3_stmt* select;
+    sqlite3_prepare_v2(memory, LOAD_HOTELS_SQL.c_str(), -1, &select, NULL);
+    Hotel row;
+    long mismatched = 0;
+    start = benchNow();
+    for (int i = 0; sqlite3_step(select) == SQLITE_ROW; i++) {
+        handReadHotel(select, row);
+        if (!sameHotel(row, hotels[i])) mismatched++;
+    }
+    hand = (benchNow() - start) * 1e9 / n;
+    sqlite3_reset(select);
+    start = benchNow();
+    for (int i = 0; sqlite3_step(select) == SQLITE_ROW; i++) {
+        readRecord(select, row);
+        if (!sameHotel(row, hotels[i])) mismatched++;
+    }
+    generated = (benchNow() - start) * 1e9 / n;
+    printBenchRow(n, "read", hand, generated);
+    sqlite3_finalize(select);
+    sqlite3_close(memory);
 
-        char* sql = (char*) "DELETE FROM Guests WHERE id=?;";
-        sqlite3_stmt* stmt;
+    // Encode everything into one buffer, as a snapshot does, then decode it
+    string handBytes, generatedBytes;
+    handBytes.reserve(size_t(n) * 96);
+    generatedBytes.reserve(size_t(n) * 96);
+    start = benchNow();
+    for (int i = 0; i < n; i++) handEncodeHotel(hotels[i], handBytes);
+    hand = (benchNow() - start) * 1e9 / n;
+    start = benchNow();
+    for (int i = 0; i < n; i++) encodeRecord(hotels[i], generatedBytes);
+    generated = (benchNow() - start) * 1e9 / n;
+    printBenchRow(n, "encode", hand, generated);
+    if (handBytes != generatedBytes) {
+        cout << "MISMATCH: generated hotel encoding differs from the snapshot layout\n";
+        benchFailed = true;
+    }
 
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
-            sqlite3_bind_int(stmt, 1, servedGuest.id);
+    const char* cursor = handBytes.data();
+    const char* end = cursor + handBytes.size();
+    start = benchNow();
+    for (int i = 0; i < n; i++) {
+        if (!handDecodeHotel(cursor, end, row) || !sameHotel(row, hotels[i])) mismatched++;
+    }
+    hand = (benchNow() - start) * 1e9 / n;
+    cursor = generatedBytes.data();
+    end = cursor + generatedBytes.size();
+    start = benchNow();
+    for (int i = 0; i < n; i++) {
+        if (!decodeRecord(cursor, end, row) || !sameHotel(row, hotels[i])) mismatched++;
+    }
+    generated = (benchNow() - start) * 1e9 / n;
+    printBenchRow(n, "decode", hand, generated);
 
-            if (sqlite3_step(stmt) == SQLITE_DONE) {
-                cout << "Guest removed from database.\n"; //Confirmation message for database deletion
-            } else {
-                cerr << "Error deleting guest from database: " << sqlite3_errmsg(db) << endl;
-            }
-            sqlite3_finalize(stmt);
-        } else {
-            cerr << "Error preparing delete statement: " << sqlite3_errmsg(db) << endl;
+    handBytes.clear();
+    generatedBytes.clear();
+    start = benchNow();
+    for (int i = 0; i < n; i++) handEncodeGuest(guests[i], handBytes);
+    hand = (benchNow() - start) * 1e9 / n;
+    start = benchNow();
+    for (int i = 0; i < n; i++) encodeRecord(guests[i], generatedBytes);
+    generated = (benchNow() - start) * 1e9 / n;
+    printBenchRow(n, "guest enc", hand, generated);
+    if (handBytes != generatedBytes) {
+        cout << "MISMATCH: generated guest encoding differs from the snapshot layout\n";
+        benchFailed = true;
+    }
+    Guest guest;
+    cursor = handBytes.data();
+    end = cursor + handBytes.size();
+    start = benchNow();
+    for (int i = 0; i < n; i++) {
+        if (!handDecodeGuest(cursor, end, guest) || guest.id != guests[i].id || guest.name != guests[i].name) {
+            mismatched++;
         }
-    } else {
-        cout << "Queue is empty!\n";
     }
-}
+    hand = (benchNow() - start) * 1e9 / n;
+    cursor = generatedBytes.data();
+    end = cursor + generatedBytes.size();
+    start = benchNow();
+    for (int i = 0; i < n; i++) {
+        if (!decodeRecord(cursor, end, guest) || guest.id != guests[i].id || guest.name != guests[i].name) {
+            mismatched++;
+        }
+    }
+    generated = (benchNow() - start) * 1e9 / n;
+    printBenchRow(n, "guest dec", hand, generated);
 
-// Display the guest queue
-void displayGuestQueue() {
-    guestQueue.displayGuests();
+    // Cut short, the generated decoder must refuse rather than read past the end
+    cursor = generatedBytes.data();
+    if (decodeRecord(cursor, cursor + 10, guest)) mismatched++;
+    if (mismatched) {
+        cout << "MISMATCH: " << mismatched << " record(s) did not round-trip\n";
+        benchFailed = true;
+    }
 }
 
-// Add a stop to the itinerary
-void addStopToItinerary() {
-    string stop;
-    cout << "Enter stop: ";
-    getline(cin, stop);
-    itinerary.push_back(stop);
-    cout << "Stop added to itinerary!\n";
-}
+struct BenchmarkEntry {
+    const char* name;
+    void (*run)();
+};
 
-// View the itinerary
-void viewItinerary() {
-    cout << "\n--- Itinerary ---\n";
-    for (list<string>::iterator stop_iter = itinerary.begin(); stop_iter != itinerary.end(); ++stop_iter) {
-        cout << *stop_iter << "\n";
+static const BenchmarkEntry benchmarks[] = {
+    {"hotel-store", benchHotelStore},
+    {"storage-layout", benchStorageLayout},
+    {"statement-cache", benchStatementCache},
+    {"bulk-import", benchBulkImport},
+    {"pagination", benchPagination},
+    {"amenity-index", benchAmenityIndex},
+    {"name-search", benchNameSearch},
+    {"room-index", benchRoomIndex},
+    {"geo-index", benchGeoIndex},
+    {"hotel-memory", benchHotelMemory},
+    {"snapshot-boot", benchSnapshotBoot},
+    {"shard-load", benchShardLoad},
+    {"mvcc-read", benchMvccRead},
+    {"guest-queue-mpmc", benchGuestQueueConcurrency},
+    {"guest-rank", benchGuestRank},
+    {"scaling", benchScaling},
+    {"metrics-overhead", benchMetricsOverhead},
+    {"write-behind", benchWriteBehind},
+    {"change-sync", benchChangeSync},
+    {"availability", benchAvailability},
+    {"report-aggregates", benchReportAggregates},
+    {"schema-codec", benchSchemaCodec},
+};
+
+int runBenchmark(const string& name, const string& jsonPath, bool quick) {
+    if (quick) benchDivisor = 100;
+    const int count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+    bool found = false;
+    for (int i = 0; i < count; i++) {
+        if (name == "all" || name == benchmarks[i].name) {
+            benchmarks[i].run();
+            cout << "\n";
+            found = true;
+        }
+    }
+    if (!found) {
+        cerr << "Unknown benchmark: " << name << "\nAvailable:";
+        for (int i = 0; i < count; i++) cerr << " " << benchmarks[i].name;
+        cerr << " all\n";
+        return 1;
+    }
+    if (!jsonPath.empty() && writeBenchJson(jsonPath)) {
+        cout << benchRecords.size() << " result(s) written to " << jsonPath << "\n";
     }
+    return benchFailed ? 1 : 0;
 }
+#endif // CMS_BENCHMARKS
@@ -0,0 +1,77 @@
+# Run one scripted scenario against the application and compare what it
+# printed with the expected transcript:
+#   cmake -DAPP=<ContactMGMTSys> -DSCENARIO=<name.scenario> -DEXPECTED=<name.expected>
+#         -DWORK_DIR=<empty dir> -P run_scenario.cmake
+#
+# A scenario is a list of steps, each starting with a directive line:
+#   > <arguments>    run the application in WORK_DIR with <arguments>; when
+#                    they end in --batch, the lines up to the next directive
+#                    are the command file
+#   ! mkdir <path>   stage files between runs, such as what another process
+#   ! remove <path>  would have left behind
+# Lines starting with '#' are comments. The transcript holds each run's
+# directive line, its standard output and its exit code.
+
+foreach(var APP SCENARIO EXPECTED WORK_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "run_scenario.cmake needs -D${var}=...")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+set(transcript "")
+set(errors "")
+set(run "")
+set(commands "")
+
+macro(finish_run)
+    if(NOT run STREQUAL "")
+        separate_arguments(args UNIX_COMMAND "${run}")
+        if(run MATCHES "--batch$")
+            file(WRITE "${WORK_DIR}/commands.txt" "${commands}")
+            list(APPEND args commands.txt)
+        endif()
+        execute_process(COMMAND "${APP}" ${args}
+                        WORKING_DIRECTORY "${WORK_DIR}"
+                        RESULT_VARIABLE result
+                        OUTPUT_VARIABLE output
+                        ERROR_VARIABLE error)
+        string(APPEND transcript "> ${run}\n${output}exit ${result}\n")
+        string(APPEND errors "${error}")
+        set(run "")
+        set(commands "")
+    endif()
+endmacro()
+
+file(STRINGS "${SCENARIO}" lines)
+foreach(line IN LISTS lines)
+    if(line MATCHES "^#")
+        continue()
+    elseif(line MATCHES "^> (.*)$")
+        set(next "${CMAKE_MATCH_1}")
+        finish_run()
+        set(run "${next}")
+    elseif(line MATCHES "^! (mkdir|remove) (.+)$")
+        set(operation "${CMAKE_MATCH_1}")
+        set(path "${WORK_DIR}/${CMAKE_MATCH_2}")
+        finish_run()
+        if(operation STREQUAL "mkdir")
+            file(MAKE_DIRECTORY "${path}")
+        else()
+            file(REMOVE_RECURSE "${path}")
+        endif()
+    else()
+        string(APPEND commands "${line}\n")
+    endif()
+endforeach()
+finish_run()
+
+file(WRITE "${WORK_DIR}/actual.txt" "${transcript}")
+file(READ "${EXPECTED}" expected)
+if(NOT transcript STREQUAL expected)
+    message(FATAL_ERROR "Output differs from ${EXPECTED}\n"
+                        "--- actual (${WORK_DIR}/actual.txt) ---\n${transcript}"
+                        "--- standard error ---\n${errors}")
+endif()